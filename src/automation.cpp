@@ -6,6 +6,7 @@
 #define DEBUG_LISTS 0 // whether to print lists of units, targets, impls and associated constants
 #define DEBUG_MOVES 0 // whether to print moves that are executed
 #define DEBUG_HYDRAS 0 // whether to print hydra graph
+#define EQUALITY_SATURATION 1 // whether to unify terms modulo the loaded rewrites and equalities using an e-graph
 
 // whether consts2 is a subset of consts1
 bool consts_subset(const std::vector<std::string>& consts1, const std::vector<std::string>& consts2) {
@@ -18,57 +19,80 @@ bool consts_subset(const std::vector<std::string>& consts1, const std::vector<st
     return true;
 }
 
+// Fingerprint of the given formula of a unit. The one check_done keeps for the line
+// is used unless the line changed since, or the formula is one it doesn't cover.
+fingerprint_t unit_fingerprint(const tabline_t& unit_tabline, const node* formula)
+{
+    if (unit_tabline.fingerprinted && unit_tabline.fingerprinted == unit_tabline.negation &&
+        unit_tabline.fingerprinted_version == unit_tabline.version &&
+        formula == unwrap_special(unit_tabline.formula)) {
+        return unit_tabline.formula_fp;
+    }
+
+    return get_fingerprint(formula);
+}
+
 // Performs trial unification for Modus Ponens.
 // Returns true if trial unification is successful, false otherwise.
-bool trial_modus_ponens(context_t& ctx, const tabline_t& impl_tabline, const tabline_t& unit_tabline, bool forward)
+bool trial_modus_ponens(const tabline_t& impl_tabline, const tabline_t& unit_tabline, bool forward)
 {
-    node* impl_formula = unwrap_special(impl_tabline.formula);
-    node* antecedent = forward ? deep_copy(impl_formula->children[0]) :
-                                  negate_node(deep_copy(impl_formula)->children[1]);
-
     node* unit_formula = unwrap_special(unit_tabline.formula);
 
-    // Find common variables between unit_formula and impl_formula's antecedent
-    std::set<std::string> common_vars = find_common_variables(unit_formula, antecedent);
+    // Run the compiled pattern if there is one
+    if (impl_tabline.code) {
+        const clause_program& program = forward ? impl_tabline.code->mp_forward : impl_tabline.code->mp_backward;
+        if (!fingerprints_compatible(program.fingerprint, unit_fingerprint(unit_tabline, unit_formula))) {
+            return false;
+        }
 
-    // Rename variables to prevent capture
-    std::vector<std::pair<std::string, std::string>> rename_list;
-    if (!common_vars.empty()) {
-        rename_list = vars_rename_list(ctx, common_vars);
-        rename_vars(antecedent, rename_list);
+        trial_result result = run_program(program, unit_formula);
+        if (result != trial_result::Unknown) {
+            return result == trial_result::Success;
+        }
     }
 
-    // Attempt unification between the antecedent of the implication and the unit's formula
-    Substitution subst;
-    bool success = unify(antecedent, unit_formula, subst).has_value();
+    node* impl_formula = unwrap_special(impl_tabline.formula);
+    node* negated = forward ? nullptr : negate_node(deep_copy(impl_formula->children[1]));
+    node* antecedent = forward ? impl_formula->children[0] : negated;
+
+    // Attempt unification between the antecedent of the implication and the unit's formula,
+    // with their variables in different banks to prevent capture
+    BankedSubstitution subst;
+    BankMasks masks = { impl_tabline.formula_info().var_mask, unit_tabline.formula_info().var_mask };
+    bool success = unify_banks(antecedent, 0, unit_formula, 1, subst, false, &masks).has_value();
 
-    delete antecedent; // Clean up the copied formula
+    delete negated; // Clean up the negated formula
 
     return success;
 }
 
 // Performs trial unification for Modus Tollens.
 // Returns true if trial unification is successful, false otherwise.
-bool trial_modus_tollens(context_t& ctx, const tabline_t& impl_tabline, const tabline_t& unit_tabline, bool forward)
+bool trial_modus_tollens(const tabline_t& impl_tabline, const tabline_t& unit_tabline, bool forward)
 {
-    node * consequent = forward ? negate_node(deep_copy(impl_tabline.formula->children[1])) :
-                                  deep_copy(impl_tabline.formula->children[0]);
-
-    // Find common variables between unit_formula and negated_consequent
-    std::set<std::string> common_vars = find_common_variables(unit_tabline.formula, consequent);
+    // Run the compiled pattern if there is one
+    if (impl_tabline.code) {
+        const clause_program& program = forward ? impl_tabline.code->mt_forward : impl_tabline.code->mt_backward;
+        if (!fingerprints_compatible(program.fingerprint, unit_fingerprint(unit_tabline, unit_tabline.formula))) {
+            return false;
+        }
 
-    // Rename variables to prevent capture
-    std::vector<std::pair<std::string, std::string>> rename_list;
-    if (!common_vars.empty()) {
-        rename_list = vars_rename_list(ctx, common_vars);
-        rename_vars(consequent, rename_list);
+        trial_result result = run_program(program, unit_tabline.formula);
+        if (result != trial_result::Unknown) {
+            return result == trial_result::Success;
+        }
     }
 
-    // Attempt unification between the unit's formula and the negated consequent of the implication
-    Substitution subst;
-    bool success = unify(consequent, unit_tabline.formula, subst).has_value();
+    node* negated = forward ? negate_node(deep_copy(impl_tabline.formula->children[1])) : nullptr;
+    node* consequent = forward ? negated : impl_tabline.formula->children[0];
+
+    // Attempt unification between the unit's formula and the negated consequent of the implication,
+    // with their variables in different banks to prevent capture
+    BankedSubstitution subst;
+    BankMasks masks = { impl_tabline.formula_info().var_mask, unit_tabline.formula_info().var_mask };
+    bool success = unify_banks(consequent, 0, unit_tabline.formula, 1, subst, false, &masks).has_value();
 
-    delete consequent; // Clean up the negated formula
+    delete negated; // Clean up the negated formula
 
     return success;
 }
@@ -76,11 +100,14 @@ bool trial_modus_tollens(context_t& ctx, const tabline_t& impl_tabline, const ta
 // Loads a theorem from the module tableau to the main tableau.
 // Updates main_line_idx by reference if the theorem is loaded.
 // Returns true if the theorem was loaded, false otherwise.
-void load_theorem(context_t& ctx, tabline_t& mod_tabline, size_t& main_line_idx, LIBRARY kind)
+void load_theorem(context_t& ctx, const tabline_t& mod_tabline, size_t& main_line_idx, LIBRARY kind)
 {
     if (main_line_idx == -static_cast<size_t>(1)) {
-        // Copy the theorem's tabline from the module to the main tableau
+        // Copy the theorem's tabline from the module to the main tableau. The module is
+        // shared through the registry, so the tableau gets formulas of its own.
         tabline_t copied_tabline = mod_tabline;
+        copied_tabline.formula = deep_copy(mod_tabline.formula);
+        copied_tabline.negation = nullptr;
         node* unwrapped_formula = unwrap_special(mod_tabline.formula);
 
         // Set the justification based on the kind
@@ -104,11 +131,34 @@ void load_theorem(context_t& ctx, tabline_t& mod_tabline, size_t& main_line_idx,
     }
 }
 
-std::pair<bool, bool> metavar_check(tabline_t& tabline) {
-    std::set<std::string> vars_left, vars_right;
+// Silently applies modus ponens or tollens with the given implication to a single other line,
+// unless the same attempt already failed and neither line nor the special predicates changed
+static bool memo_move_mpt(context_t& ctx, size_t impl_idx, int other_line, const std::vector<size_t>& specials,
+                          size_t specials_hash, bool ponens) {
+    unsigned impl_version = ctx.tableau[impl_idx].version;
+    unsigned other_version = ctx.tableau[other_line].version;
+
+    auto key = std::make_tuple(static_cast<int>(impl_idx), other_line, ponens);
+    auto it = ctx.mpt_failures.find(key);
+    if (it != ctx.mpt_failures.end() && it->second.impl_version == impl_version &&
+        it->second.other_version == other_version && it->second.specials_hash == specials_hash) {
+        return false;
+    }
+
+    std::vector<int> other_lines = { other_line };
+    if (move_mpt(ctx, impl_idx, other_lines, specials, ponens, true)) { // silent=true
+        return true;
+    }
+
+    ctx.mpt_failures[key] = { impl_version, other_version, specials_hash };
+
+    return false;
+}
+
+std::pair<bool, bool> metavar_check(const tabline_t& tabline) {
+    const std::vector<std::string>& vars_left = tabline.side_info().first.free_vars;
+    const std::vector<std::string>& vars_right = tabline.side_info().second.free_vars;
     
-    vars_used(vars_left, tabline.formula->children[0], false, false);
-    vars_used(vars_right, tabline.formula->children[1], false, false);
     bool vars_ltor = (std::includes(vars_left.begin(), vars_left.end(),
         vars_right.begin(), vars_right.end()));
     bool vars_rtol = (std::includes(vars_right.begin(), vars_right.end(),
@@ -117,6 +167,178 @@ std::pair<bool, bool> metavar_check(tabline_t& tabline) {
     return std::pair(vars_ltor, vars_rtol);
 }
 
+// Key of the predicate symbol of a unit or conjunct, see automation.h
+std::string predicate_key(const node* formula) {
+    if (formula->is_negation()) {
+        std::string key = predicate_key(formula->children[0]);
+        return key.empty() ? key : "~" + key;
+    }
+
+    switch (formula->type) {
+    case APPLICATION:
+        return formula->children[0]->name();
+    case VARIABLE:
+        return formula->name();
+    case BINARY_PRED:
+    case UNARY_PRED:
+        return "#" + std::to_string(static_cast<int>(formula->symbol));
+    default:
+        return "";
+    }
+}
+
+// Whether the conclusion is already an active hypothesis that holds under the assumptions
+static bool is_known_hypothesis(const context_t& ctx, const banked_term& conclusion, const std::vector<int>& assumptions) {
+    for (const tabline_t& tabline : ctx.tableau) {
+        if (!tabline.active || tabline.target || !equal_banked(unwrap_special(tabline.formula), conclusion)) {
+            continue;
+        }
+
+        if (std::all_of(tabline.assumptions.begin(), tabline.assumptions.end(), [&assumptions](int a) {
+                return std::find(assumptions.begin(), assumptions.end(), a) != assumptions.end();
+            })) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Extends a partial tuple of units for the conjuncts order[depth], order[depth + 1], ...
+// with the substitution found so far. Returns true if a tuple was found that is not
+// in the applied list, whose units together contain the constants of the antecedent
+// and which gives a conclusion that is not already a hypothesis.
+static bool hyper_join(std::vector<int>& tuple, const context_t& ctx, const tabline_t& impl_tabline,
+                       const std::vector<node*>& conjuncts, node* consequent,
+                       const std::vector<size_t>& order, const std::vector<std::vector<size_t>>& candidates,
+                       size_t depth, const BankedSubstitution& subst, BankMasks& masks,
+                       const std::vector<std::vector<int>>& applied) {
+    if (depth == order.size()) {
+        if (std::find(applied.begin(), applied.end(), tuple) != applied.end()) {
+            return false;
+        }
+
+        std::vector<std::string> tuple_consts;
+        std::vector<int> assumptions = impl_tabline.assumptions;
+        for (int unit_idx : tuple) {
+            const tabline_t& unit_tabline = ctx.tableau[unit_idx];
+            tuple_consts.insert(tuple_consts.end(), unit_tabline.constants1.begin(), unit_tabline.constants1.end());
+            assumptions.insert(assumptions.end(), unit_tabline.assumptions.begin(), unit_tabline.assumptions.end());
+        }
+
+        if (!consts_subset(tuple_consts, impl_tabline.constants1)) {
+            return false;
+        }
+
+        // The conclusion is only compared, so it is not built
+        return !is_known_hypothesis(ctx, {consequent, 0, &subst}, assumptions);
+    }
+
+    size_t c = order[depth];
+
+    for (size_t unit_idx : candidates[c]) {
+        const tabline_t& unit_tabline = ctx.tableau[unit_idx];
+
+        // The units must be usable together
+        bool compatible = true;
+        for (size_t k = 0; k < depth && compatible; ++k) {
+            const tabline_t& other_tabline = ctx.tableau[tuple[order[k]]];
+            compatible = assumptions_compatible(unit_tabline.assumptions, other_tabline.assumptions) &&
+                         restrictions_compatible(unit_tabline.restrictions, other_tabline.restrictions);
+        }
+
+        if (!compatible) {
+            continue;
+        }
+
+        // Each unit has a bank of its own, as variables of different units are distinct
+        BankedSubstitution extended = subst;
+        masks[depth + 1] = unit_tabline.formula_info().var_mask;
+        if (!unify_banks(conjuncts[c], 0, unwrap_special(unit_tabline.formula), depth + 1, extended, false, &masks).has_value()) {
+            continue;
+        }
+
+        tuple[c] = unit_idx;
+        if (hyper_join(tuple, ctx, impl_tabline, conjuncts, consequent, order, candidates, depth + 1, extended, masks, applied)) {
+            return true;
+        }
+    }
+
+    tuple[c] = -1;
+
+    return false;
+}
+
+// Hyperresolution, see automation.h. Candidates for each conjunct are taken from the units
+// indexed by its predicate symbol and the conjuncts are joined most selective first.
+bool find_hyper_units(std::vector<int>& tuple, const context_t& ctx, const tabline_t& impl_tabline,
+                      const std::unordered_map<std::string, std::vector<size_t>>& unit_index,
+                      const std::vector<std::vector<int>>& applied) {
+    node* implication = unwrap_special(impl_tabline.formula);
+    if (!implication->is_implication() || !implication->children[0]->is_conjunction()) {
+        return false; // Single premises are dealt with by ordinary modus ponens
+    }
+
+    std::vector<node*> conjuncts;
+    node* current = implication->children[0];
+    while (current->is_conjunction()) {
+        conjuncts.push_back(current->children[1]);
+        current = current->children[0];
+    }
+    conjuncts.push_back(current);
+    std::reverse(conjuncts.begin(), conjuncts.end());
+
+    // Units that unify with each conjunct on their own
+    std::vector<std::vector<size_t>> candidates(conjuncts.size());
+    for (size_t c = 0; c < conjuncts.size(); ++c) {
+        std::string key = predicate_key(conjuncts[c]);
+
+        std::vector<const std::vector<size_t>*> buckets;
+        for (const auto& [unit_key, bucket] : unit_index) {
+            if (key.empty() || unit_key.empty() || unit_key == key) {
+                buckets.push_back(&bucket);
+            }
+        }
+
+        for (const std::vector<size_t>* bucket : buckets) {
+            for (size_t unit_idx : *bucket) {
+                const tabline_t& unit_tabline = ctx.tableau[unit_idx];
+
+                if (!assumptions_compatible(impl_tabline.assumptions, unit_tabline.assumptions) ||
+                    !restrictions_compatible(impl_tabline.restrictions, unit_tabline.restrictions)) {
+                    continue;
+                }
+
+                BankedSubstitution subst;
+                BankMasks masks = { impl_tabline.formula_info().var_mask, unit_tabline.formula_info().var_mask };
+                if (unify_banks(conjuncts[c], 0, unwrap_special(unit_tabline.formula), 1, subst, false, &masks).has_value()) {
+                    candidates[c].push_back(unit_idx);
+                }
+            }
+        }
+
+        if (candidates[c].empty()) {
+            return false;
+        }
+    }
+
+    // Join the conjuncts with fewest candidates first
+    std::vector<size_t> order(conjuncts.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&candidates](size_t a, size_t b) {
+        return candidates[a].size() < candidates[b].size();
+    });
+
+    tuple.assign(conjuncts.size(), -1);
+
+    // Bank 0 is the implication, bank depth + 1 the unit tried at that depth
+    BankMasks masks(conjuncts.size() + 1);
+    masks[0] = impl_tabline.formula_info().var_mask;
+
+    return hyper_join(tuple, ctx, impl_tabline, conjuncts, implication->children[1], order, candidates, 0,
+                      BankedSubstitution(), masks, applied);
+}
+
 // Automation using a waterfall architecture
 // Returns true if theorem successfully proved, else false if the automation gets stuck
 bool automate(context_t& ctx) {
@@ -126,9 +348,19 @@ bool automate(context_t& ctx) {
     std::vector<size_t> impls;                  // Indices of active implication hypotheses
     std::vector<size_t> units;                  // Indices of active non-implication hypotheses
     std::vector<size_t> specials;               // Indices of active special predicates
+    std::unordered_map<std::string, std::vector<size_t>> unit_index; // Units indexed by predicate symbol
 
     bool move_made = false; // whether a move was made at any step
 
+#if EQUALITY_SATURATION
+    // Set up the e-graph with the rewrites and equalities already in the tableau,
+    // check_done adds those of new lines
+    if (!ctx.congruence) {
+        ctx.congruence = std::make_shared<egraph>();
+        update_congruence(ctx, 0);
+    }
+#endif
+
     // Waterfall Architecture Loop
     while (true) {
 #if DEBUG_TABLEAU
@@ -153,10 +385,24 @@ bool automate(context_t& ctx) {
         impls.clear();
         units.clear();
         specials.clear();
+        unit_index.clear();
         
         // Accumulate constants and indices using get_tableau_constants
         ctx.get_tableau_constants(tabc, tarc, impls, units, specials);
 
+        // Failed attempts involving special predicates may succeed once these change
+        size_t specials_hash = specials.size();
+        for (size_t special : specials) {
+            specials_hash = specials_hash * 1000003 + special;
+        }
+
+        // Index the units by predicate symbol for hyperresolution
+        for (const size_t unit_idx : units) {
+            if (ctx.tableau[unit_idx].justification.first != Reason::Special) {
+                unit_index[predicate_key(unwrap_special(ctx.tableau[unit_idx].formula))].push_back(unit_idx);
+            }
+        }
+
         /*
         // Heuristic: sort units by maximum term depth
         std::sort(units.begin(), units.end(), [&ctx](size_t a, size_t b) {
@@ -171,10 +417,11 @@ bool automate(context_t& ctx) {
         // Level 1 of the Waterfall (Load non-implication theorems)
         // --------------------------------------------------------
 
-        for (auto& [name, mod_ctx] : ctx.modules) { // for each loaded module
-            for (auto& digest_entry : mod_ctx.digest) { // for each digest record
+        for (auto& [name, module, digest] : ctx.modules) { // for each loaded module
+            const context_t& mod_ctx = *module;
+            for (auto& digest_entry : digest) { // for each digest record
                 for (auto& [mod_line_idx, main_line_idx, entry_kind] : digest_entry) { // for each theorem in record
-                    tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
+                    const tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
 
                     if (entry_kind == LIBRARY::Theorem) {
                         if (!mod_tabline.formula->is_implication()) { // library result is implication
@@ -217,67 +464,79 @@ bool automate(context_t& ctx) {
 
         // Iterate over each unit in the units list
         for (const int unit_idx : units) {
-            for (auto& [name, mod_ctx] : ctx.modules) { // for each loaded module
-                for (auto& digest_entry : mod_ctx.digest) { // for each digest record
-                    for (auto& [mod_line_idx, main_line_idx, entry_kind] : digest_entry) { // for each theorem in record
-                        tabline_t& unit_tabline = ctx.tableau[unit_idx];
-                        const std::vector<std::string>& unit_consts = unit_tabline.constants1;
-                        tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
-
-                        if (unit_tabline.justification.first != Reason::Special && entry_kind == LIBRARY::Rewrite) {
-                            // Check if this rewrite has been applied already
-                            std::pair<std::string, size_t> mod_pair = {name, mod_line_idx};
-                            if (std::find(unit_tabline.lib_applied.begin(), unit_tabline.lib_applied.end(), mod_pair) != unit_tabline.lib_applied.end()) {
-                                continue; // Skip if already applied
-                            }
-
-                            const std::vector<std::string>& mod_consts1 = mod_tabline.constants1;
-                            bool all_contained_left = consts_subset(unit_consts, mod_consts1);
-                            
-                            // Check if all left constants are contained and conditions for Modus Ponens are met
-                            if (all_contained_left) {                                
-                                // Load the theorem into the main tableau
-                                load_theorem(ctx, mod_tabline, main_line_idx, LIBRARY::Rewrite);
+            if (ctx.tableau[unit_idx].justification.first == Reason::Special) {
+                continue;
+            }
 
-                                // Attempt to rewrite
-                                bool move_success = move_rewrite(ctx, unit_idx, main_line_idx, true); // silent=true
+            // Only rules whose left side has a head symbol occurring in the unit can apply
+            std::set<std::string> heads;
+            term_heads(heads, ctx.tableau[unit_idx].formula);
 
-                                if (move_success) {
-#if DEBUG_MOVES
-                                    std::cout << "Level 8: rewrite " << unit_idx + 1 << " " << main_line_idx + 1 << std::endl << std::endl;
-#endif
-                                    move_made = true;
+            std::vector<int> rule_lines;
+            std::vector<std::pair<std::string, size_t>> tried;
 
-                                    // After applying the move, run cleanup_moves automatically
-                                    cleanup_moves(ctx, ctx.upto);
+            for (auto& [name, module, digest] : ctx.modules) { // for each loaded module
+                const context_t& mod_ctx = *module;
+                for (const std::string& head : heads) {
+                    auto it = mod_ctx.rewrite_heads.find(head);
+                    if (it == mod_ctx.rewrite_heads.end()) {
+                        continue;
+                    }
 
-                                    // Check if done
-                                    if (check_done(ctx)) {
-                                        return true;
-                                    }
-                                }
-                            }
+                    for (auto [record, item] : it->second) { // for each rule with this head
+                        auto& [mod_line_idx, main_line_idx, entry_kind] = digest[record][item];
+                        tabline_t& unit_tabline = ctx.tableau[unit_idx];
+                        const tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
 
-                            // Mark theorem as applied
-                            unit_tabline.lib_applied.push_back(mod_pair);
+                        // Check if this rewrite has been applied already
+                        std::pair<std::string, size_t> mod_pair = {name, mod_line_idx};
+                        if (std::find(unit_tabline.lib_applied.begin(), unit_tabline.lib_applied.end(), mod_pair) != unit_tabline.lib_applied.end() ||
+                            std::find(tried.begin(), tried.end(), mod_pair) != tried.end()) {
+                            continue; // Skip if already applied
                         }
+                        tried.push_back(mod_pair);
 
-                        if (move_made) {
-                            break; // A move was made; restart the waterfall from the beginning
-                        }
-                    }
+                        // Check if all left constants are contained
+                        if (consts_subset(unit_tabline.constants1, mod_tabline.constants1)) {
+                            // Load the theorem into the main tableau
+                            load_theorem(ctx, mod_tabline, main_line_idx, LIBRARY::Rewrite);
 
-                    if (move_made) {
-                        break; // A move was made; restart the waterfall from the beginning
+                            rule_lines.push_back(main_line_idx);
+                        }
                     }
                 }
+            }
 
-                if (move_made) {
-                    break; // A move was made; restart the waterfall from the beginning
-                }
+            if (tried.empty()) {
+                continue;
             }
 
-            if (move_made) { 
+            // Mark rules as applied, rewriting again with them gives the same normal form
+            for (auto& mod_pair : tried) {
+                ctx.tableau[unit_idx].lib_applied.push_back(mod_pair);
+            }
+
+            if (rule_lines.empty()) {
+                continue;
+            }
+
+            // Rewrite with all the rules at once
+            bool move_success = move_normalise(ctx, unit_idx, rule_lines, true); // silent=true
+
+            if (move_success) {
+#if DEBUG_MOVES
+                std::cout << "Level 2: rewrite " << unit_idx + 1 << std::endl << std::endl;
+#endif
+                move_made = true;
+
+                // After applying the move, run cleanup_moves automatically
+                cleanup_moves(ctx, ctx.upto);
+
+                // Check if done
+                if (check_done(ctx)) {
+                    return true;
+                }
+
                 break; // A move was made; restart the waterfall from the beginning
             }
         }
@@ -348,13 +607,11 @@ bool automate(context_t& ctx) {
                 bool consts_ltor = consts_subset(impl_consts1, impl_consts2) || !consts_subset(impl_consts2, impl_consts1);
                 bool consts_rtol = consts_subset(impl_consts2, impl_consts1) || !consts_subset(impl_consts1, impl_consts2);
                 
-                // Prepare the list of other lines (only the target in this case)
-                std::vector<int> other_lines = { target };
                 bool move_success = false;
 
                 if (all_contained_right && consts_rtol && impl_tabline.rtol) {
                     // Attempt Modus Ponens
-                    move_success = move_mpt(ctx, impl_idx, other_lines, specials, true, true); // ponens=true, silent=true
+                    move_success = memo_move_mpt(ctx, impl_idx, target, specials, specials_hash, true); // ponens=true
 
 #if DEBUG_MOVES
                     if (move_success) {
@@ -365,7 +622,7 @@ bool automate(context_t& ctx) {
 
                 if (!move_success && all_contained_left && consts_ltor && impl_tabline.ltor) {
                     // Attempt Modus Tollens since Modus Ponens failed
-                    move_success = move_mpt(ctx, impl_idx, other_lines, specials, false, true); // ponens=false, silent=true
+                    move_success = memo_move_mpt(ctx, impl_idx, target, specials, specials_hash, false); // ponens=false
 
 #if DEBUG_MOVES
                     if (move_success) {
@@ -376,7 +633,7 @@ bool automate(context_t& ctx) {
 
                 if (move_success) {
                     // Add the target to applied_units to prevent reapplication
-                    impl_tabline.applied_units.push_back(target);
+                    ctx.tableau[impl_idx].applied_units.push_back(target);
 
                     // Cleanup
                     cleanup_moves(ctx, ctx.upto);
@@ -435,13 +692,11 @@ bool automate(context_t& ctx) {
                 bool consts_ltor = consts_subset(impl_consts1, impl_consts2) || !consts_subset(impl_consts2, impl_consts1);
                 bool consts_rtol = consts_subset(impl_consts2, impl_consts1) || !consts_subset(impl_consts1, impl_consts2);
                 
-                // Prepare the list of other lines (only the unit in this case)
-                std::vector<int> other_lines = { unit_idx };
                 bool move_success = false;
                 
                 if (all_contained_left && consts_ltor && impl_tabline.ltor && impl_tabline.ltor_safe) {
                     // Attempt Modus Ponens
-                    move_success = move_mpt(ctx, impl_idx, other_lines, specials, true, true); // ponens=true, silent=true
+                    move_success = memo_move_mpt(ctx, impl_idx, unit_idx, specials, specials_hash, true); // ponens=true
                     
 #if DEBUG_MOVES
                     if (move_success) {
@@ -452,7 +707,7 @@ bool automate(context_t& ctx) {
 
                 if (!move_success && all_contained_right && consts_rtol && impl_tabline.rtol && impl_tabline.rtol_safe) {
                     // Attempt Modus Tollens since Modus Ponens failed
-                    move_success = move_mpt(ctx, impl_idx, other_lines, specials, false, true); // ponens=false, silent=true
+                    move_success = memo_move_mpt(ctx, impl_idx, unit_idx, specials, specials_hash, false); // ponens=false
 
 #if DEBUG_MOVES
                     if (move_success) {
@@ -463,7 +718,7 @@ bool automate(context_t& ctx) {
 
                 if (move_success) {
                     // Add the unit to applied_units to prevent reapplication
-                    impl_tabline.applied_units.push_back(unit_idx);
+                    ctx.tableau[impl_idx].applied_units.push_back(unit_idx);
 
                     // Cleanup
                     cleanup_moves(ctx, ctx.upto);
@@ -488,6 +743,48 @@ bool automate(context_t& ctx) {
             continue; // Move made at this level, restart waterfall at level 1
         }
 
+        // Level 4b of the Waterfall (non-library hyperresolution)
+        // -------------------------------------------------------
+
+        // Apply implications with conjunctive antecedents to several units at once
+        for (const size_t impl_idx : impls) {
+            tabline_t& impl_tabline = ctx.tableau[impl_idx];
+
+            if (!impl_tabline.ltor || !impl_tabline.ltor_safe) {
+                continue;
+            }
+
+            std::vector<int> other_lines;
+            if (!find_hyper_units(other_lines, ctx, impl_tabline, unit_index, impl_tabline.applied_tuples)) {
+                continue;
+            }
+
+            // Don't try this tuple again whether or not the move succeeds
+            impl_tabline.applied_tuples.push_back(other_lines);
+
+            if (move_mpt(ctx, impl_idx, other_lines, specials, true, true)) { // ponens=true, silent=true
+#if DEBUG_MOVES
+                std::cout << "Level 4b: mp " << impl_idx + 1;
+                for (int line : other_lines) {
+                    std::cout << " " << line + 1;
+                }
+                std::cout << std::endl << std::endl;
+#endif
+                cleanup_moves(ctx, ctx.upto);
+
+                if (check_done(ctx, true)) {
+                    return true;
+                }
+
+                move_made = true;
+                break;
+            }
+        }
+
+        if (move_made) { 
+            continue; // Move made at this level, restart waterfall at level 1
+        }
+
         // Level 5 of the Waterfall (tableau/disjunction splitting)
         // ----------------------------------------------------------
 
@@ -541,8 +838,9 @@ bool automate(context_t& ctx) {
 
         // Iterate over each current target
         for (const int tar_idx : current_leaf_hydra->target_indices) {       
-            for (auto& [name, mod_ctx] : ctx.modules) { // for each loaded module
-                for (auto& digest_entry : mod_ctx.digest) { // for each digest record
+            for (auto& [name, module, digest] : ctx.modules) { // for each loaded module
+                const context_t& mod_ctx = *module;
+                for (auto& digest_entry : digest) { // for each digest record
                     size_t entry = -static_cast<size_t>(1);
                     for (auto& [mod_line_idx, main_line_idx, entry_kind] : digest_entry) { // for each theorem in record
                         // Index of entry in record
@@ -550,7 +848,7 @@ bool automate(context_t& ctx) {
                         
                         tabline_t& tar_tabline = ctx.tableau[tar_idx];
                         const std::vector<std::string>& tar_consts = tar_tabline.constants1;
-                        tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
+                        const tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
 
                         if (entry_kind == LIBRARY::Definition) {
                             if (mod_tabline.formula->is_implication()) { // library result is implication
@@ -576,7 +874,7 @@ bool automate(context_t& ctx) {
 
                                 if (!failed_left && (tar_contained_right || units.empty())) {
                                     // Perform trial unification for Modus Ponens
-                                    bool trial_mp_success = trial_modus_ponens(ctx, mod_tabline, tar_tabline, false);
+                                    bool trial_mp_success = trial_modus_ponens(mod_tabline, tar_tabline, false);
 
                                     if (trial_mp_success) {
                                         // Load the theorem into the main tableau
@@ -593,7 +891,7 @@ bool automate(context_t& ctx) {
 
                                             move_made = true;
 
-                                            tar_tabline.lib_applied.push_back(mod_pair);
+                                            ctx.tableau[tar_idx].lib_applied.push_back(mod_pair);
                                             
                                             // After applying the move, run cleanup_moves automatically
                                             cleanup_moves(ctx, ctx.upto);
@@ -617,7 +915,7 @@ bool automate(context_t& ctx) {
 
                                 if (failed_left && !failed_right && (tar_contained_left || units.empty())) {
                                     // Perform trial unification for Modus Tollens
-                                    bool trial_mt_success = trial_modus_tollens(ctx, mod_tabline, tar_tabline, false);
+                                    bool trial_mt_success = trial_modus_tollens(mod_tabline, tar_tabline, false);
 
                                     if (trial_mt_success) {
                                         // Load the theorem into the main tableau
@@ -634,7 +932,7 @@ bool automate(context_t& ctx) {
 
                                             move_made = true;
 
-                                            tar_tabline.lib_applied.push_back(mod_pair);
+                                            ctx.tableau[tar_idx].lib_applied.push_back(mod_pair);
                                             
                                             // After applying the move, run cleanup_moves automatically
                                             cleanup_moves(ctx, ctx.upto);
@@ -653,7 +951,7 @@ bool automate(context_t& ctx) {
 
                                 // Mark theorem as applied if both trials failed
                                 if (failed_left && failed_right) {
-                                    tar_tabline.lib_applied.push_back(mod_pair);
+                                    ctx.tableau[tar_idx].lib_applied.push_back(mod_pair);
                                 }
                             }
                         }
@@ -687,8 +985,9 @@ bool automate(context_t& ctx) {
         
         // Iterate over each unit in the units list
         for (const int unit_idx : units) {
-            for (auto& [name, mod_ctx] : ctx.modules) { // for each loaded module
-                for (auto& digest_entry : mod_ctx.digest) { // for each digest record
+            for (auto& [name, module, digest] : ctx.modules) { // for each loaded module
+                const context_t& mod_ctx = *module;
+                for (auto& digest_entry : digest) { // for each digest record
                     size_t entry = -static_cast<size_t>(1);
                     for (auto& [mod_line_idx, main_line_idx, entry_kind] : digest_entry) { // for each theorem in record
                         // Index of entry within record
@@ -696,7 +995,7 @@ bool automate(context_t& ctx) {
                         
                         tabline_t& unit_tabline = ctx.tableau[unit_idx];
                         const std::vector<std::string>& unit_consts = unit_tabline.constants1;
-                        tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
+                        const tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
 
                         if (entry_kind == LIBRARY::Definition) {
                             if (mod_tabline.formula->is_implication()) { // library result is implication
@@ -722,7 +1021,7 @@ bool automate(context_t& ctx) {
 
                                 if (!failed_left && tab_contained_left) {
                                     // Perform trial unification for Modus Ponens
-                                    bool trial_mp_success = trial_modus_ponens(ctx, mod_tabline, unit_tabline, true);
+                                    bool trial_mp_success = trial_modus_ponens(mod_tabline, unit_tabline, true);
 
                                     if (trial_mp_success) {
                                         load_theorem(ctx, mod_tabline, main_line_idx, LIBRARY::Definition);
@@ -737,7 +1036,7 @@ bool automate(context_t& ctx) {
         #endif
                                             move_made = true;
 
-                                            unit_tabline.lib_applied.push_back(mod_pair);
+                                            ctx.tableau[unit_idx].lib_applied.push_back(mod_pair);
                                             
                                             // After applying the move, run cleanup_moves automatically
                                             cleanup_moves(ctx, ctx.upto);
@@ -761,7 +1060,7 @@ bool automate(context_t& ctx) {
 
                                 if (failed_left && !failed_right && tab_contained_right) {
                                     // Perform trial unification for Modus Tollens
-                                    bool trial_mt_success = trial_modus_tollens(ctx, mod_tabline, unit_tabline, true);
+                                    bool trial_mt_success = trial_modus_tollens(mod_tabline, unit_tabline, true);
 
                                     if (trial_mt_success) {
                                         // Load the theorem into the main tableau
@@ -777,7 +1076,7 @@ bool automate(context_t& ctx) {
         #endif
                                             move_made = true;
 
-                                            unit_tabline.lib_applied.push_back(mod_pair);
+                                            ctx.tableau[unit_idx].lib_applied.push_back(mod_pair);
                                             
                                             // After applying the move, run cleanup_moves automatically
                                             cleanup_moves(ctx, ctx.upto);
@@ -796,7 +1095,7 @@ bool automate(context_t& ctx) {
 
                                 // Mark theorem as applied if both trials failed
                                 if (failed_left && failed_right) {
-                                    unit_tabline.lib_applied.push_back(mod_pair);
+                                    ctx.tableau[unit_idx].lib_applied.push_back(mod_pair);
                                 }
                             }
                         }
@@ -826,12 +1125,13 @@ bool automate(context_t& ctx) {
 
         // Iterate over each unit in the units list
         for (const int unit_idx : units) {
-            for (auto& [name, mod_ctx] : ctx.modules) { // for each loaded module
-                for (auto& digest_entry : mod_ctx.digest) { // for each digest record
+            for (auto& [name, module, digest] : ctx.modules) { // for each loaded module
+                const context_t& mod_ctx = *module;
+                for (auto& digest_entry : digest) { // for each digest record
                     for (auto& [mod_line_idx, main_line_idx, entry_kind] : digest_entry) { // for each theorem in record
                         tabline_t& unit_tabline = ctx.tableau[unit_idx];
                         const std::vector<std::string>& unit_consts = unit_tabline.constants1;
-                        tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
+                        const tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
 
                         if (unit_tabline.justification.first != Reason::Special && entry_kind == LIBRARY::Theorem) {
                             if (mod_tabline.formula->is_implication()) { // library result is implication
@@ -860,7 +1160,7 @@ bool automate(context_t& ctx) {
 
                                 if (!failed_left && tab_contained_left) {
                                     // Perform trial unification for Modus Ponens
-                                    bool trial_mp_success = trial_modus_ponens(ctx, mod_tabline, unit_tabline, true);
+                                    bool trial_mp_success = trial_modus_ponens(mod_tabline, unit_tabline, true);
 
                                     if (trial_mp_success) {
                                         // Load the theorem into the main tableau
@@ -876,7 +1176,7 @@ bool automate(context_t& ctx) {
 #endif
                                             move_made = true;
 
-                                            unit_tabline.lib_applied.push_back(mod_pair);
+                                            ctx.tableau[unit_idx].lib_applied.push_back(mod_pair);
                                             
                                             // After applying the move, run cleanup_moves automatically
                                             cleanup_moves(ctx, ctx.upto);
@@ -900,7 +1200,7 @@ bool automate(context_t& ctx) {
 
                                 if (failed_left && !failed_right && tab_contained_right) {
                                     // Perform trial unification for Modus Tollens
-                                    bool trial_mt_success = trial_modus_tollens(ctx, mod_tabline, unit_tabline, true);
+                                    bool trial_mt_success = trial_modus_tollens(mod_tabline, unit_tabline, true);
 
                                     if (trial_mt_success) {
                                         // Load the theorem into the main tableau
@@ -916,7 +1216,7 @@ bool automate(context_t& ctx) {
 #endif
                                             move_made = true;
 
-                                            unit_tabline.lib_applied.push_back(mod_pair);
+                                            ctx.tableau[unit_idx].lib_applied.push_back(mod_pair);
                                             
                                             // After applying the move, run cleanup_moves automatically
                                             cleanup_moves(ctx, ctx.upto);
@@ -935,7 +1235,7 @@ bool automate(context_t& ctx) {
 
                                 // Mark theorem as applied if both trials failed
                                 if (failed_left && failed_right) {
-                                    unit_tabline.lib_applied.push_back(mod_pair);
+                                    ctx.tableau[unit_idx].lib_applied.push_back(mod_pair);
                                 }
                             }
                         }
@@ -964,6 +1264,88 @@ bool automate(context_t& ctx) {
             continue; // Move made at this level, restart waterfall at level 1
         }
 
+        // Level 9b of the Waterfall (Library hyperresolution)
+        // ---------------------------------------------------
+
+        // Apply library theorems with conjunctive antecedents to several units at once
+        for (auto& [name, module, digest] : ctx.modules) { // for each loaded module
+            const context_t& mod_ctx = *module;
+            for (auto& digest_entry : digest) { // for each digest record
+                for (auto& [mod_line_idx, main_line_idx, entry_kind] : digest_entry) { // for each theorem in record
+                    const tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
+                    node* mod_formula = unwrap_special(mod_tabline.formula);
+
+                    if (entry_kind != LIBRARY::Theorem || !mod_formula->is_implication() ||
+                        !mod_formula->children[0]->is_conjunction()) {
+                        continue;
+                    }
+
+                    // All variables of the conclusion must be assigned by the units
+                    std::set<std::string> vars_left, vars_right;
+                    vars_used(vars_left, mod_formula->children[0], false, false);
+                    vars_used(vars_right, mod_formula->children[1], false, false);
+                    bool vars_ltor = std::includes(vars_left.begin(), vars_left.end(),
+                                                   vars_right.begin(), vars_right.end());
+                    const std::vector<std::string>& mod_consts1 = mod_tabline.constants1;
+                    const std::vector<std::string>& mod_consts2 = mod_tabline.constants2;
+                    bool consts_ltor = consts_subset(mod_consts1, mod_consts2) || !consts_subset(mod_consts2, mod_consts1);
+
+                    if (!vars_ltor || !consts_ltor || !consts_subset(tabc, mod_consts1)) {
+                        continue;
+                    }
+
+                    // Tuples already used are recorded on the loaded copy of the theorem
+                    static const std::vector<std::vector<int>> none_applied;
+                    const std::vector<std::vector<int>>& applied = main_line_idx == -static_cast<size_t>(1) ?
+                                                                    none_applied : ctx.tableau[main_line_idx].applied_tuples;
+
+                    std::vector<int> other_lines;
+                    if (!find_hyper_units(other_lines, ctx, mod_tabline, unit_index, applied)) {
+                        continue;
+                    }
+
+                    // Load the theorem into the main tableau
+                    load_theorem(ctx, mod_tabline, main_line_idx, LIBRARY::Theorem);
+
+                    // Don't try this tuple again whether or not the move succeeds
+                    ctx.tableau[main_line_idx].applied_tuples.push_back(other_lines);
+
+                    if (move_mpt(ctx, main_line_idx, other_lines, specials, true, true)) { // ponens=true, silent=true
+#if DEBUG_MOVES
+                        std::cout << "Level 9b: mp " << main_line_idx + 1;
+                        for (int line : other_lines) {
+                            std::cout << " " << line + 1;
+                        }
+                        std::cout << std::endl << std::endl;
+#endif
+                        move_made = true;
+
+                        // After applying the move, run cleanup_moves automatically
+                        cleanup_moves(ctx, ctx.upto);
+
+                        // Check if done
+                        if (check_done(ctx)) {
+                            return true;
+                        }
+
+                        break; // A move was made; restart the waterfall from the beginning
+                    }
+                }
+
+                if (move_made) {
+                    break; // A move was made; restart the waterfall from the beginning
+                }
+            }
+
+            if (move_made) {
+                break; // A move was made; restart the waterfall from the beginning
+            }
+        }
+
+        if (move_made) { 
+            continue; // Move made at this level, restart waterfall at level 1
+        }
+
         // Level 10 of the Waterfall (Library backwards reasoning)
         // ----------------------------------------------------------
 
@@ -971,12 +1353,13 @@ bool automate(context_t& ctx) {
 
         // Iterate over each current target
         for (const int tar_idx : current_leaf_hydra->target_indices) {
-            for (auto& [name, mod_ctx] : ctx.modules) { // for each loaded module
-                for (auto& digest_entry : mod_ctx.digest) { // for each digest record
+            for (auto& [name, module, digest] : ctx.modules) { // for each loaded module
+                const context_t& mod_ctx = *module;
+                for (auto& digest_entry : digest) { // for each digest record
                     for (auto& [mod_line_idx, main_line_idx, entry_kind] : digest_entry) { // for each theorem in record
                         tabline_t& tar_tabline = ctx.tableau[tar_idx];
                         const std::vector<std::string>& tar_consts = tar_tabline.constants1;
-                        tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
+                        const tabline_t& mod_tabline = mod_ctx.tableau[mod_line_idx];
 
                         if (entry_kind == LIBRARY::Theorem) {
                             if (mod_tabline.formula->is_implication()) { // library result is implication
@@ -1005,7 +1388,7 @@ bool automate(context_t& ctx) {
 
                                 if (!failed_left && (tar_contained_right || units.empty())) {
                                     // Perform trial unification for Modus Ponens
-                                    bool trial_mp_success = trial_modus_ponens(ctx, mod_tabline, tar_tabline, false);
+                                    bool trial_mp_success = trial_modus_ponens(mod_tabline, tar_tabline, false);
 
                                     if (trial_mp_success) {
                                         // Load the theorem into the main tableau
@@ -1022,7 +1405,7 @@ bool automate(context_t& ctx) {
 
                                             move_made = true;
 
-                                            tar_tabline.lib_applied.push_back(mod_pair);
+                                            ctx.tableau[tar_idx].lib_applied.push_back(mod_pair);
                                             
                                             // After applying the move, run cleanup_moves automatically
                                             cleanup_moves(ctx, ctx.upto);
@@ -1046,7 +1429,7 @@ bool automate(context_t& ctx) {
 
                                 if (failed_left && !failed_right && (tar_contained_left || units.empty())) {
                                     // Perform trial unification for Modus Tollens
-                                    bool trial_mt_success = trial_modus_tollens(ctx, mod_tabline, tar_tabline, false);
+                                    bool trial_mt_success = trial_modus_tollens(mod_tabline, tar_tabline, false);
 
                                     if (trial_mt_success) {
                                         // Load the theorem into the main tableau
@@ -1063,7 +1446,7 @@ bool automate(context_t& ctx) {
 
                                             move_made = true;
 
-                                            tar_tabline.lib_applied.push_back(mod_pair);
+                                            ctx.tableau[tar_idx].lib_applied.push_back(mod_pair);
                                             
                                             // After applying the move, run cleanup_moves automatically
                                             cleanup_moves(ctx, ctx.upto);
@@ -1082,7 +1465,7 @@ bool automate(context_t& ctx) {
 
                                 // Mark theorem as applied if both trials failed
                                 if (failed_left && failed_right) {
-                                    tar_tabline.lib_applied.push_back(mod_pair);
+                                    ctx.tableau[tar_idx].lib_applied.push_back(mod_pair);
                                 }
                             }
                         }
@@ -1133,13 +1516,11 @@ bool automate(context_t& ctx) {
                 bool all_contained_left = consts_subset(unit_consts, impl_consts1);
                 bool all_contained_right = consts_subset(unit_consts, impl_consts2);
                 
-                // Prepare the list of other lines (only the unit in this case)
-                std::vector<int> other_lines = { unit_idx };
                 bool move_success = false;
                 
                 if (all_contained_left && impl_tabline.ltor) {
                     // Attempt Modus Ponens
-                    move_success = move_mpt(ctx, impl_idx, other_lines, specials, true, true); // ponens=true, silent=true
+                    move_success = memo_move_mpt(ctx, impl_idx, unit_idx, specials, specials_hash, true); // ponens=true
 
 #if DEBUG_MOVES
                     if (move_success) {
@@ -1150,7 +1531,7 @@ bool automate(context_t& ctx) {
 
                 if (!move_success && all_contained_right && impl_tabline.rtol) {
                     // Attempt Modus Tollens since Modus Ponens failed
-                    move_success = move_mpt(ctx, impl_idx, other_lines, specials, false, true); // ponens=false, silent=true
+                    move_success = memo_move_mpt(ctx, impl_idx, unit_idx, specials, specials_hash, false); // ponens=false
 
 #if DEBUG_MOVES
                     if (move_success) {
@@ -1161,7 +1542,7 @@ bool automate(context_t& ctx) {
 
                 if (move_success) {
                     // Add the unit to applied_units to prevent reapplication
-                    impl_tabline.applied_units.push_back(unit_idx);
+                    ctx.tableau[impl_idx].applied_units.push_back(unit_idx);
 
                     // Cleanup
                     cleanup_moves(ctx, ctx.upto);
@@ -1214,13 +1595,11 @@ bool automate(context_t& ctx) {
                 bool all_contained_left = consts_subset(target_consts, impl_consts1);
                 bool all_contained_right = consts_subset(target_consts, impl_consts2);
                 
-                // Prepare the list of other lines (only the target in this case)
-                std::vector<int> other_lines = { target };
                 bool move_success = false;
 
                 if (all_contained_right && impl_tabline.rtol) {
                     // Attempt Modus Ponens
-                    move_success = move_mpt(ctx, impl_idx, other_lines, specials, true, true); // ponens=true, silent=true
+                    move_success = memo_move_mpt(ctx, impl_idx, target, specials, specials_hash, true); // ponens=true
 
 #if DEBUG_MOVES
                     if (move_success) {
@@ -1231,7 +1610,7 @@ bool automate(context_t& ctx) {
 
                 if (!move_success && all_contained_left  && impl_tabline.ltor) {
                     // Attempt Modus Tollens since Modus Ponens failed
-                    move_success = move_mpt(ctx, impl_idx, other_lines, specials, false, true); // ponens=false, silent=true
+                    move_success = memo_move_mpt(ctx, impl_idx, target, specials, specials_hash, false); // ponens=false
 
 #if DEBUG_MOVES
                     if (move_success) {
@@ -1242,7 +1621,7 @@ bool automate(context_t& ctx) {
 
                 if (move_success) {
                     // Add the target to applied_units to prevent reapplication
-                    impl_tabline.applied_units.push_back(target);
+                    ctx.tableau[impl_idx].applied_units.push_back(target);
 
                     // Cleanup
                     cleanup_moves(ctx, ctx.upto);
@@ -11,8 +11,22 @@
 #include <memory>
 #include <algorithm>
 #include <optional>
+#include <numeric>
+#include <unordered_map>
 
 // Automation using a waterfall
 bool automate(context_t& ctx);
 
+// Key of the predicate symbol of a unit or conjunct, used to index units for
+// hyperresolution. Returns an empty string if there is no fixed predicate symbol.
+std::string predicate_key(const node* formula);
+
+// Hyperresolution: finds a unit for each conjunct of the antecedent of the implication,
+// such that all of them unify with a single substitution. Units are taken from the index
+// of units by predicate_key. Tuples in the applied list are skipped. Returns true and
+// sets tuple to the unit for each conjunct, in order, if one is found.
+bool find_hyper_units(std::vector<int>& tuple, const context_t& ctx, const tabline_t& impl_tabline,
+                      const std::unordered_map<std::string, std::vector<size_t>>& unit_index,
+                      const std::vector<std::vector<int>>& applied);
+
 #endif // AUTOMATION_H
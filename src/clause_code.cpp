@@ -0,0 +1,216 @@
+// clause_code.cpp
+
+#include "clause_code.h"
+#include <unordered_map>
+
+static bool compile_node(clause_program& program, std::unordered_map<std::string, int>& slots, const node* pattern) {
+    clause_instruction instr = { clause_op::STRUCT, pattern->type, pattern->symbol, INDIVIDUAL, "", pattern->children.size(), -1, -1, false };
+
+    if (pattern->type == VARIABLE) {
+        if (pattern->is_free_variable() && !pattern->is_shared_variable()) {
+            auto it = slots.find(pattern->name());
+            instr.op = clause_op::VAR;
+            instr.first = (it == slots.end());
+            if (instr.first) {
+                instr.slot = slots[pattern->name()] = program.num_slots++;
+                program.slot_names.push_back(pattern->name());
+            } else {
+                instr.slot = it->second;
+            }
+        } else if (pattern->vdata->var_kind == INDIVIDUAL) {
+            return false; // Shared or bound variables are left to unify
+        } else {
+            instr.op = clause_op::NAMED;
+            instr.kind = pattern->vdata->var_kind;
+            instr.name = pattern->name();
+        }
+        program.code.push_back(instr);
+        return true;
+    }
+
+    if (pattern->type == QUANTIFIER) {
+        return false;
+    }
+
+    if (pattern->type == APPLICATION) {
+        const node* head = pattern->children[0];
+        if (head->type != VARIABLE) {
+            return false;
+        }
+        instr.op = clause_op::APPLY;
+        instr.kind = head->vdata->var_kind;
+        instr.name = head->name();
+        program.code.push_back(instr);
+        for (size_t i = 1; i < pattern->children.size(); ++i) {
+            if (!compile_node(program, slots, pattern->children[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Fast path for x ∈ A, X ⊆ Y, a = b and the like with fresh variables
+    if (pattern->type == BINARY_PRED) {
+        const node* left = pattern->children[0];
+        const node* right = pattern->children[1];
+        if (left->is_free_variable() && !left->is_shared_variable() &&
+            right->is_free_variable() && !right->is_shared_variable() &&
+            left->name() != right->name() &&
+            slots.find(left->name()) == slots.end() && slots.find(right->name()) == slots.end()) {
+            instr.op = clause_op::BINPRED_VARS;
+            instr.slot = slots[left->name()] = program.num_slots++;
+            instr.slot2 = slots[right->name()] = program.num_slots++;
+            program.slot_names.push_back(left->name());
+            program.slot_names.push_back(right->name());
+            program.code.push_back(instr);
+            return true;
+        }
+    }
+
+    program.code.push_back(instr);
+    for (const node* child : pattern->children) {
+        if (!compile_node(program, slots, child)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+clause_program compile_pattern(const node* pattern) {
+    clause_program program;
+    std::unordered_map<std::string, int> slots;
+
+    program.fingerprint = get_fingerprint(pattern);
+    program.compiled = compile_node(program, slots, pattern);
+    if (!program.compiled) {
+        program.code.clear();
+        program.slot_names.clear();
+        program.num_slots = 0;
+    }
+
+    return program;
+}
+
+// Whether the term contains a symbol that has the same name as a variable, which
+// the occurs check of unify would trip over
+static bool name_occurs(const std::string& name, const node* term) {
+    if (term->type == VARIABLE) {
+        return term->vdata->var_kind != INDIVIDUAL && term->name() == name;
+    }
+
+    for (const node* child : term->children) {
+        if (name_occurs(name, child)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Assigns a pattern variable, or checks a repeated one
+static trial_result assign_slot(std::vector<node*>& slots, int slot, bool first, const std::string& name, node* term) {
+    if (term->is_free_variable() && !term->is_shared_variable()) {
+        return trial_result::Unknown; // Variable of the term, needs unification
+    }
+
+    if (!first) {
+        return equal(slots[slot], term) ? trial_result::Success : trial_result::Unknown;
+    }
+
+    if (term->type != VARIABLE && term->type != CONSTANT && term->type != APPLICATION &&
+        term->type != TUPLE && term->type != BINARY_OP && term->type != UNARY_OP) {
+        return trial_result::Fail; // Formulas can't be assigned to variables
+    }
+
+    if (name_occurs(name, term)) {
+        return trial_result::Unknown;
+    }
+
+    slots[slot] = term;
+
+    return trial_result::Success;
+}
+
+trial_result run_program(const clause_program& program, node* term) {
+    if (!program.compiled) {
+        return trial_result::Unknown;
+    }
+
+    std::vector<node*> slots(program.num_slots, nullptr);
+    std::vector<node*> stack = { term };
+
+    for (const clause_instruction& instr : program.code) {
+        node* t = stack.back();
+        stack.pop_back();
+
+        if (instr.op != clause_op::VAR && t->is_free_variable() && !t->is_shared_variable()) {
+            return trial_result::Unknown; // Variable of the term, needs unification
+        }
+
+        switch (instr.op) {
+        case clause_op::VAR: {
+            trial_result res = assign_slot(slots, instr.slot, instr.first, program.slot_names[instr.slot], t);
+            if (res != trial_result::Success) {
+                return res;
+            }
+            break;
+        }
+        case clause_op::BINPRED_VARS: {
+            if (t->type != BINARY_PRED || t->symbol != instr.symbol || t->children.size() != 2) {
+                return trial_result::Fail;
+            }
+            trial_result res = assign_slot(slots, instr.slot, true, program.slot_names[instr.slot], t->children[0]);
+            if (res == trial_result::Success) {
+                res = assign_slot(slots, instr.slot2, true, program.slot_names[instr.slot2], t->children[1]);
+            }
+            if (res != trial_result::Success) {
+                return res;
+            }
+            break;
+        }
+        case clause_op::NAMED:
+            if (t->type != VARIABLE || t->vdata->var_kind != instr.kind || t->name() != instr.name) {
+                return trial_result::Fail;
+            }
+            break;
+        case clause_op::APPLY:
+            if (t->type != APPLICATION || t->children[0]->type != VARIABLE ||
+                t->children[0]->vdata->var_kind != instr.kind || t->children[0]->name() != instr.name ||
+                t->children.size() != instr.arity) {
+                return trial_result::Fail;
+            }
+            for (size_t i = t->children.size() - 1; i >= 1; --i) {
+                stack.push_back(t->children[i]);
+            }
+            break;
+        case clause_op::STRUCT:
+            if (t->type != instr.type || t->symbol != instr.symbol || t->children.size() != instr.arity) {
+                return trial_result::Fail;
+            }
+            for (size_t i = t->children.size(); i > 0; --i) {
+                stack.push_back(t->children[i - 1]);
+            }
+            break;
+        }
+    }
+
+    return trial_result::Success;
+}
+
+std::shared_ptr<clause_code> compile_clause(const node* formula) {
+    auto code = std::make_shared<clause_code>();
+    node* impl = unwrap_special(const_cast<node*>(formula));
+
+    code->mp_forward = compile_pattern(impl->children[0]);
+    node* negated = negate_node(deep_copy(impl->children[1]));
+    code->mp_backward = compile_pattern(negated);
+    delete negated;
+
+    negated = negate_node(deep_copy(formula->children[1]));
+    code->mt_forward = compile_pattern(negated);
+    delete negated;
+    code->mt_backward = compile_pattern(formula->children[0]);
+
+    return code;
+}
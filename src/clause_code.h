@@ -0,0 +1,70 @@
+// clause_code.h
+
+#ifndef CLAUSE_CODE_H
+#define CLAUSE_CODE_H
+
+#include "node.h"
+#include "fingerprint.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Instructions of the trial unification machine. A pattern is compiled to a flat
+// preorder sequence of instructions which is run against a term using a stack of
+// subterms still to be matched.
+enum class clause_op {
+    STRUCT,      // node of the given type and symbol with arity children
+    APPLY,       // application of the named function/predicate with arity arguments
+    NAMED,       // parameter, function or predicate symbol with the given name
+    VAR,         // pattern variable in the given slot
+    BINPRED_VARS // binary predicate (=, ∈, ⊆, ...) of two distinct fresh pattern variables
+};
+
+struct clause_instruction {
+    clause_op op;
+    node_type type;
+    symbol_enum symbol;
+    VariableKind kind;
+    std::string name;
+    size_t arity;
+    int slot;   // variable slot for VAR, first slot for BINPRED_VARS
+    int slot2;  // second slot for BINPRED_VARS
+    bool first; // whether this is the first occurrence of the VAR
+};
+
+// The compiled form of a pattern. Patterns with quantifiers or shared variables
+// are not compiled.
+struct clause_program {
+    fingerprint_t fingerprint; // of the pattern, for rejecting terms before running the code
+    bool compiled = false;
+    int num_slots = 0;
+    std::vector<std::string> slot_names; // names of the pattern variables
+    std::vector<clause_instruction> code;
+};
+
+enum class trial_result {
+    Fail,    // the pattern does not unify with the term
+    Success, // the pattern unifies with the term
+    Unknown  // the term has free variables where they matter, use full unification
+};
+
+// Compiles a pattern whose free variables are assigned when run against a term
+clause_program compile_pattern(const node* pattern);
+
+// Runs a compiled pattern against a term, giving the same answer as unify_banks
+// with the pattern and term in different banks, unless Unknown is returned
+trial_result run_program(const clause_program& program, node* term);
+
+// The patterns used by the trial unifications for a library implication, for
+// modus ponens/tollens and forwards/backwards reasoning
+struct clause_code {
+    clause_program mp_forward;
+    clause_program mp_backward;
+    clause_program mt_forward;
+    clause_program mt_backward;
+};
+
+// Compiles the trial patterns of a library implication
+std::shared_ptr<clause_code> compile_clause(const node* formula);
+
+#endif // CLAUSE_CODE_H
@@ -11,6 +11,7 @@
 #include <functional>
 #include <optional>
 #include <stack>
+#include <set>
 #include <vector>
 #include <string>
 #include <queue>
@@ -18,11 +19,47 @@
 #define DEBUG_STEP_2 0 // enable debug traces for Step 2
 #define DEBUG_CHECK 0 // print tableaus and hydras for check_done
 
+// Adds the terms of lines from start onwards to the congruence closure, merges
+// unconditional equalities among them, adds loaded rewrites as rules and saturates.
+// Each equality and rule has its line as reason, so that it can be cited.
+void update_congruence(context_t& ctx, size_t start) {
+    for (size_t j = start; j < ctx.tableau.size(); ++j) {
+        tabline_t& current_line = ctx.tableau[j];
+        if (current_line.dead || current_line.is_theorem() || current_line.is_definition()) {
+            continue;
+        }
+
+        if (current_line.is_rewrite()) {
+            node* formula = unwrap_special(current_line.formula);
+            if (formula->is_equality()) {
+                ctx.congruence->add_rule(formula->children[0], formula->children[1], j);
+            }
+        } else if (current_line.target) {
+            ctx.congruence->add_terms(current_line.negation);
+        } else {
+            node* formula = unwrap_special(current_line.formula);
+            if (formula->is_equality() && current_line.assumptions.empty() &&
+                current_line.restrictions.empty()) {
+                ctx.congruence->merge_terms(formula->children[0], formula->children[1], j);
+            }
+            ctx.congruence->add_terms(formula);
+        }
+    }
+
+    ctx.congruence->saturate();
+}
+
 bool check_done(context_t& ctx, bool apply_cleanup) {
-    // Step 1: Negate formulas of all non-target lines starting from 'upto'
+    // Step 1: Negate formulas of non-target lines starting from 'upto', a negation is
+    // only built again if the formula was replaced or changed since it was last built
     for (int j = ctx.upto; j < static_cast<int>(ctx.tableau.size()); ++j) {
         tabline_t& current_line = ctx.tableau[j];
         if (!current_line.target) {
+            if (current_line.negation && current_line.negated_formula == current_line.formula &&
+                current_line.negated_version == current_line.version) {
+                continue;
+            }
+
             if (current_line.negation)
                 delete current_line.negation;
 
@@ -31,6 +68,35 @@ bool check_done(context_t& ctx, bool apply_cleanup) {
     
             node* negation = negate_node(deep_copy(formula));
             current_line.negation = reapply_special(special_predicates, negation);
+            current_line.negated_formula = current_line.formula;
+            current_line.negated_version = current_line.version;
+            current_line.fingerprinted = nullptr; // The new negation may reuse the address of the old one
+        }
+    }
+
+    // Step 1b: Add the new terms and equalities to the congruence closure. Formulas
+    // don't change until the unifications are done, so terms are looked up once.
+    const egraph* eg = nullptr;
+    if (ctx.congruence) {
+        update_congruence(ctx, ctx.upto);
+        eg = ctx.congruence.get();
+        eg->set_cache(true);
+    }
+
+    // Step 1c: Fingerprint formulas and negations, so that most pairs which can't
+    // unify are rejected without calling unify. Positions of terms equal to other
+    // terms are wildcards, so all fingerprints are redone when classes were merged.
+    size_t merges = eg ? eg->merges() : 0;
+    bool remerged = merges != ctx.fingerprinted_merges;
+    ctx.fingerprinted_merges = merges;
+    for (auto& line : ctx.tableau) {
+        if (!line.dead && (line.fingerprinted != line.negation || line.fingerprinted_version != line.version ||
+                           !line.negation || remerged)) {
+            const egraph* merged = merges ? eg : nullptr;
+            line.formula_fp = get_fingerprint(unwrap_special(line.formula), merged);
+            line.negation_fp = line.negation ? get_fingerprint(unwrap_special(line.negation), merged) : fingerprint_t();
+            line.fingerprinted = line.negation;
+            line.fingerprinted_version = line.version;
         }
     }
 
@@ -73,6 +139,11 @@ bool check_done(context_t& ctx, bool apply_cleanup) {
                 continue; // Skip if previous_line is also a target
             }
 
+            // Skip pairs whose shallow symbols clash
+            if (!fingerprints_compatible(current_line.negation_fp, previous_line.formula_fp)) {
+                continue;
+            }
+
 #if DEBUG_STEP_2
             std::cout << "  Checking against Previous Line: " << i 
                       << (previous_line.target ? " [Target]" : " [Hypothesis]") << "\n";
@@ -100,7 +171,7 @@ bool check_done(context_t& ctx, bool apply_cleanup) {
                 Substitution subst;
 
                 std::optional<Substitution> result = unify(unwrap_special(current_line.negation),
-                                              unwrap_special(previous_line.formula), subst, true);
+                                              unwrap_special(previous_line.formula), subst, true, ctx.congruence.get());
                 if (result.has_value()) {
 #if DEBUG_STEP_2
                     std::cout << "    Unification Successful between Line " << j 
@@ -242,6 +313,10 @@ bool check_done(context_t& ctx, bool apply_cleanup) {
         // Variable to store the merged assumptions from the successful tuple
         std::vector<int> successful_merged_assumptions;
 
+        // Target negations and hypotheses unified on the current path and the successful one
+        std::vector<std::pair<node*, node*>> chosen_pairs;
+        std::vector<std::pair<node*, node*>> successful_pairs;
+
         // Recursively attempts to find a simultaneous unification across all targets.
         std::function<void(size_t, Substitution, std::vector<int>&)> recurse = [&](size_t depth, Substitution current_subst, std::vector<int>& merged_assumptions_ref) {
             if (simultaneous_unification_found) {
@@ -312,13 +387,17 @@ bool check_done(context_t& ctx, bool apply_cleanup) {
                 Substitution new_subst = current_subst; // Copy current substitution
 
                 std::optional<Substitution> unif_result = unify(unwrap_special(target_negation),
-                                        unwrap_special(hypothesis_formula), new_subst, true);
+                                        unwrap_special(hypothesis_formula), new_subst, true, ctx.congruence.get());
                 if (unif_result.has_value()) {
+                    chosen_pairs.resize(depth);
+                    chosen_pairs.emplace_back(unwrap_special(target_negation), unwrap_special(hypothesis_formula));
+
                     if (depth + 1 == num_targets) {
                         // Check if already proved for those assumptions
                         if (!current_hydra_ptr->assumption_exists(updated_merged_assumptions)) {
                             simultaneous_unification_found = true;
                             successful_merged_assumptions = updated_merged_assumptions;
+                            successful_pairs = chosen_pairs;
                             return;
                         }
                     }
@@ -342,6 +421,27 @@ bool check_done(context_t& ctx, bool apply_cleanup) {
         recurse(0, initial_subst, initial_assumptions);
 
         if (simultaneous_unification_found) {
+            // Lines whose equalities the unifications relied on, found by unifying again
+            // with the terms the e-graph took to be equal logged
+            std::string equalities_used;
+            if (ctx.congruence) {
+                std::vector<std::pair<const node*, const node*>> equal_terms;
+                Substitution subst;
+                ctx.congruence->set_log(&equal_terms);
+                for (const auto& [target_negation, hypothesis_formula] : successful_pairs) {
+                    unify(target_negation, hypothesis_formula, subst, true, ctx.congruence.get());
+                }
+                ctx.congruence->set_log(nullptr);
+
+                std::set<int> reasons;
+                for (const auto& [a, b] : equal_terms) {
+                    ctx.congruence->explain(a, b, reasons);
+                }
+                for (int line : reasons) {
+                    equalities_used += (equalities_used.empty() ? " using " : ", ") + std::to_string(line + 1);
+                }
+            }
+
             // Attempt to add the merged assumptions to the current hydra and all its descendants
             std::vector<std::shared_ptr<hydra>> hydras_processed;
             std::function<void(std::shared_ptr<hydra>)> add_assumption_recursive = [&](std::shared_ptr<hydra> hydra_ptr) {
@@ -362,7 +462,7 @@ bool check_done(context_t& ctx, bool apply_cleanup) {
 
                     // Print the success message
                     if (!targets_proved.empty()) {
-                        std::cout << "Target" << (targets_proved.size() == 1 ? " " : "s ") << targets_proved << " proved.\n";
+                        std::cout << "Target" << (targets_proved.size() == 1 ? " " : "s ") << targets_proved << " proved" << equalities_used << ".\n";
                     }
 
                     // Add hydra to deletion list
@@ -384,6 +484,10 @@ bool check_done(context_t& ctx, bool apply_cleanup) {
         }
     }
 
+    if (eg) {
+        eg->set_cache(false);
+    }
+
     // Now handle the deletion list
     if (!hydras_to_remove.empty()) { 
         // Traverse the hydra_graph recursively to remove hydras from the deletion list
@@ -433,8 +537,7 @@ bool check_done(context_t& ctx, bool apply_cleanup) {
                 // Mark all targets in hydra_to_remove and its descendants as dead and inactive
                 std::function<void(std::shared_ptr<hydra>)> mark_dead = [&](std::shared_ptr<hydra> hydra_ptr) {
                     for (int target_idx : hydra_ptr->target_indices) {
-                        ctx.tableau[target_idx].active = false;
-                        ctx.tableau[target_idx].dead = true;
+                        ctx.kill_line(target_idx);
                     }
                     for (auto& child : hydra_ptr->children) {
                         mark_dead(child);
@@ -6,6 +6,9 @@
 #include "context.h"
 #include "moves.h"
 
+// Adds terms and equalities of lines from start onwards to ctx.congruence
+void update_congruence(context_t& ctx, size_t start);
+
 // Function to perform the completion check as described
 bool check_done(context_t& ctx, bool apply_cleanup=true);
 
@@ -18,6 +18,27 @@ void tabline_t::print_assumptions() const {
     print_list(assumptions);
 }
 
+const std::pair<node_info, node_info>& tabline_t::side_info() const {
+    if (!annotated.sides_valid || annotated.sides_version != version) {
+        annotated.sides.first = annotate(formula->children[0]);
+        annotated.sides.second = annotate(formula->children[1]);
+        annotated.sides_valid = true;
+        annotated.sides_version = version;
+    }
+
+    return annotated.sides;
+}
+
+const node_info& tabline_t::formula_info() const {
+    if (!annotated.info_valid || annotated.info_version != version) {
+        annotated.info = annotate(formula);
+        annotated.info_valid = true;
+        annotated.info_version = version;
+    }
+
+    return annotated.info;
+}
+
 // Constructor: Initializes the context (empty var_indices)
 context_t::context_t() 
     : hydra_graph(),          // 1. hydra_graph
@@ -66,6 +87,64 @@ void context_t::print_context() const {
     std::cout << "--------------------------\n";
 }
 
+void context_t::append_fragment(context_t& fragment) {
+    int offset = static_cast<int>(tableau.size());
+
+    // The fragment numbered each base from 0, shift its names past the indices in use here
+    std::vector<std::pair<std::string, std::string>> renaming_pairs;
+    for (const auto& [base, last] : fragment.var_indices) {
+        int first = get_current_index(base) + 1;
+        if (first != 0) {
+            for (int i = 0; i <= last; ++i) {
+                renaming_pairs.emplace_back(append_subscript(base, i), append_subscript(base, first + i));
+            }
+        }
+        var_indices[base] = first + last;
+    }
+
+    for (tabline_t& tabline : fragment.tableau) {
+        if (!renaming_pairs.empty()) {
+            rename_vars(tabline.formula, renaming_pairs);
+            if (tabline.negation) {
+                rename_vars(tabline.negation, renaming_pairs);
+            }
+        }
+
+        for (int& line : tabline.justification.second) {
+            line += offset;
+        }
+        for (int& line : tabline.assumptions) {
+            line += offset;
+        }
+        for (int& line : tabline.restrictions) {
+            line += offset;
+        }
+        for (auto& [i, j] : tabline.unifications) {
+            i += offset;
+            j += offset;
+        }
+        for (int& line : tabline.applied_units) {
+            line += offset;
+        }
+        for (auto& tuple : tabline.applied_tuples) {
+            for (int& line : tuple) {
+                line += offset;
+            }
+        }
+
+        tableau.push_back(std::move(tabline));
+    }
+    fragment.tableau.clear();
+
+    reasoning += fragment.reasoning;
+    rewrite += fragment.rewrite;
+    cleanup += fragment.cleanup;
+    split += fragment.split;
+    backtrack += fragment.backtrack;
+
+    upto = tableau.size();
+}
+
 // Generates renaming pairs for common variables based on the context
 std::vector<std::pair<std::string, std::string>> vars_rename_list(context_t& ctx, const std::set<std::string>& common_vars) {
     std::vector<std::pair<std::string, std::string>> renaming_pairs;
@@ -274,8 +353,7 @@ void context_t::purge_dead() {
                 
                 // If all restricted targets are dead, mark the hypothesis as dead and inactive
                 if (all_targets_dead) {
-                    current_line.dead = true;
-                    current_line.active = false;
+                    kill_line(j);
                 }
             }
         }
@@ -523,7 +601,7 @@ void context_t::select_targets(const std::vector<int>& targets) {
 
         if (tabline.target) {
             // If the tabline is a target, set active if its index is in the targets list
-            tabline.active = (target_set.find(static_cast<int>(i)) != target_set.end());
+            set_active(i, target_set.find(static_cast<int>(i)) != target_set.end());
         }
         else {
             // If the tabline is a hypothesis
@@ -540,12 +618,7 @@ void context_t::select_targets(const std::vector<int>& targets) {
             }
 
             // Determine activation based on the specified conditions
-            if (alive && (restrictions_empty || restrictions_contains_target)) {
-                tabline.active = true;
-            }
-            else {
-                tabline.active = false;
-            }
+            set_active(i, alive && (restrictions_empty || restrictions_contains_target));
         }
     }
 }
@@ -601,7 +674,7 @@ void context_t::select_hypotheses(const std::vector<int>& targets, const std::ve
             // Determine activation based on the specified conditions
             if (alive && (restrictions_empty || restrictions_contains_target)) {
                 if (tabline.assumptions.empty()) {
-                    tabline.active = true;
+                    set_active(i, true);
                 } else {
 #if DEBUG_SELECT_HYPOTHESES
                     std::cout << "Assumptions " << i << " : ";
@@ -624,11 +697,11 @@ void context_t::select_hypotheses(const std::vector<int>& targets, const std::ve
                     std::cout << "Assumptions found: " << assumptions_found << std::endl;
 #endif
                     // set tabline.active
-                    tabline.active = assumptions_found;
+                    set_active(i, assumptions_found);
                 }
             }
             else {
-                tabline.active = false;
+                set_active(i, false);
             }
         }
     }
@@ -680,6 +753,7 @@ void context_t::restrictions_replace(int i, int j) {
             if (it != tabline.restrictions.end()) {
                 // Add j to restrictions
                 tabline.restrictions.push_back(j);
+                tabline.version++;
             }
         }
     }
@@ -764,6 +838,7 @@ void context_t::restrictions_split(int i, int j1, int j2) {
                 // add j1 and j2 to restrictions
                 tabline.restrictions.push_back(j1);
                 tabline.restrictions.push_back(j2);
+                tabline.version++;
             }
         }
     }
@@ -844,6 +919,7 @@ void context_t::restrictions_replace_list(const std::vector<int>& targets, int j
             
             if (found_target){    // add j to restrictions
                 tabline.restrictions.push_back(j);
+                tabline.version++;
             }
         }
     }
@@ -976,7 +1052,8 @@ void print_tableau(const context_t& tab_ctx) {
             if (!tabline.is_theorem() && !tabline.is_special() && !tabline.is_definition() && !tabline.is_rewrite()) {
                 std::cout << " " << i + 1 << " "; // Line number
                 print_reason(tab_ctx, static_cast<int>(i)); // Print reason
-                std::cout << ": " << tabline.formula->to_string(UNICODE);
+                std::cout << ": ";
+                tabline.formula->write(std::cout, UNICODE);
                 if (!tabline.assumptions.empty()) {
                     std::cout << "    ass:";
                     tabline.print_assumptions();
@@ -1001,7 +1078,8 @@ void print_tableau(const context_t& tab_ctx) {
             if (tabline.active && !tabline.target && (tabline.is_theorem() || tabline.is_definition() || tabline.is_special() || tabline.is_rewrite())) {
                 std::cout << " " << i + 1 << " "; // Line number
                 print_reason(tab_ctx, static_cast<int>(i)); // Print reason
-                std::cout << ": " << tabline.formula->to_string(UNICODE);
+                std::cout << ": ";
+                tabline.formula->write(std::cout, UNICODE);
                 std::cout << std::endl;
             }
         }
@@ -1015,7 +1093,9 @@ void print_tableau(const context_t& tab_ctx) {
         if (tabline.active && tabline.target) {
             std::cout << " " << i + 1 << " "; // Line number
             print_reason(tab_ctx, static_cast<int>(i)); // Print reason
-            std::cout << ": " << tabline.negation->to_string(UNICODE) << std::endl;
+            std::cout << ": ";
+            tabline.negation->write(std::cout, UNICODE);
+            std::cout << std::endl;
         }
     }
 }
@@ -1119,13 +1199,90 @@ void context_t::get_ltor() {
     }
 }
 
-std::optional<context_t*> context_t::find_module(const std::string& filename_stem) {
-    for (auto& [fname, ctx] : modules) {
-        if (fname == filename_stem) {
-            return &ctx;
+module_ref* context_t::find_module(const std::string& filename_stem) {
+    for (auto& module : modules) {
+        if (module.name == filename_stem) {
+            return &module;
+        }
+    }
+    return nullptr;
+}
+
+void context_t::set_active(size_t i, bool active) {
+    if (tableau[i].active != active) {
+        tableau[i].active = active;
+        update_constants(i);
+    }
+}
+
+void context_t::kill_line(size_t i) {
+    tableau[i].active = false;
+    tableau[i].dead = true;
+    update_constants(i);
+}
+
+void context_t::formula_changed(size_t i) {
+    tableau[i].version++;
+    update_constants(i);
+}
+
+void context_t::update_constants(size_t i) {
+    // Lines appended since the last call to get_tableau_constants are dealt with there
+    if (i >= constants_cache.size()) {
+        return;
+    }
+
+    const tabline_t& tabline = tableau[i];
+    line_constants& entry = constants_cache[i];
+
+    // Work out which constants this line should be counted in
+    ConstantsCount count = ConstantsCount::None;
+    if (tabline.active) {
+        if (tabline.target) {
+            count = ConstantsCount::Target;
+        } else if (!tabline.is_theorem() && !tabline.is_definition() && !tabline.is_rewrite()) {
+            count = ConstantsCount::Hypothesis;
+        }
+    }
+
+    bool stale = entry.computed && entry.version != tabline.version;
+    if (count == entry.counted && !stale) {
+        return;
+    }
+
+    if (entry.counted != ConstantsCount::None) {
+        auto& counts = entry.counted == ConstantsCount::Target ? target_constant_counts : hypothesis_constant_counts;
+        for (const std::string& c : entry.constants) {
+            if (--counts[c] == 0) {
+                counts.erase(c);
+            }
+        }
+        if (entry.counted == ConstantsCount::Hypothesis) {
+            hypothesis_lines.erase(i);
         }
     }
-    return std::nullopt;
+
+    if (count != ConstantsCount::None) {
+        if (!entry.computed || stale) {
+            entry.constants.clear();
+            // Remove special implications to retrieve matrix
+            node_get_constants(entry.constants, unwrap_special(tabline.formula));
+            entry.computed = true;
+            entry.version = tabline.version;
+        }
+
+        auto& counts = count == ConstantsCount::Target ? target_constant_counts : hypothesis_constant_counts;
+        for (const std::string& c : entry.constants) {
+            counts[c]++;
+        }
+        if (count == ConstantsCount::Hypothesis) {
+            hypothesis_lines.insert(i);
+        }
+    } else if (stale) {
+        entry.computed = false;
+    }
+
+    entry.counted = count;
 }
 
 void context_t::get_tableau_constants(
@@ -1133,39 +1290,43 @@ void context_t::get_tableau_constants(
     std::vector<std::string>& target_constants,
     std::vector<size_t>& implication_indices,
     std::vector<size_t>& unit_indices,
-    std::vector<size_t>& special_indices) const
+    std::vector<size_t>& special_indices)
 {
-    // Iterate through each line in the tableau
-    for (size_t i = 0; i < tableau.size(); ++i) {
-        const tabline_t& tabline = tableau[i];
-        
-        // Skip inactive lines
-        if (!tabline.active) {
-            continue;
-        }
-        
-        // Remove special implications to retrieve matrix
-        node* formula = unwrap_special(tabline.formula);
+    // Lines are never removed, but start again if the tableau was replaced
+    if (tableau.size() < constants_cache.size()) {
+        constants_cache.clear();
+        hypothesis_constant_counts.clear();
+        target_constant_counts.clear();
+        hypothesis_lines.clear();
+    }
 
-        if (tabline.target) {
-            // Accumulate constants from active target lines
-            node_get_constants(target_constants, formula);
+    // Count the lines appended since the last call
+    size_t start = constants_cache.size();
+    constants_cache.resize(tableau.size());
+    for (size_t i = start; i < tableau.size(); ++i) {
+        update_constants(i);
+    }
+
+    // Skolemization can turn a unit into an implication, so always classify the lines again
+    for (size_t i : hypothesis_lines) {
+        node* formula = unwrap_special(tableau[i].formula);
+
+        if (formula->is_implication()) {
+            implication_indices.push_back(i);
         }
-        else if (!tabline.is_theorem() && !tabline.is_definition() && !tabline.is_rewrite()) {
-            // Accumulate constants from active lines that are neither theorems nor definitions
-            node_get_constants(all_constants, formula);
-            
-            // Check if the formula is an implication
-            if (formula->is_implication()) {
-                implication_indices.push_back(i);
-            }
-            else if (formula->is_special_predicate()) {
-                special_indices.push_back(i);
-            } else {
-                unit_indices.push_back(i);
-            }
+        else if (formula->is_special_predicate()) {
+            special_indices.push_back(i);
+        } else {
+            unit_indices.push_back(i);
         }
-        // Note: Targets cannot be theorems or definitions, so no further checks are needed
+    }
+
+    for (const auto& [c, n] : hypothesis_constant_counts) {
+        all_constants.push_back(c);
+    }
+
+    for (const auto& [c, n] : target_constant_counts) {
+        target_constants.push_back(c);
     }
 }
 
@@ -1245,8 +1406,7 @@ void context_t::kill_duplicates(size_t start_index) {
             }
 
             // All conditions met, mark the current line as inactive and dead
-            current_line.active = false;
-            current_line.dead = true;
+            kill_line(i);
 
             // No need to check further prior lines for this current line
             break;
@@ -1307,9 +1467,7 @@ void context_t::kill_duplicates(size_t start_index) {
 
 void context_t::reanimate() {
     for (size_t i = 0; i < tableau.size(); ++i) {
-        tabline_t& tabline = tableau[i];
-
-        tabline.active = true;
+        set_active(i, true);
     }
 }
 
@@ -1317,29 +1475,33 @@ void context_t::print_statistics(const std::string filename, bool log) {
     std::cout << "Cleanup moves: " << cleanup << ", Reasoning moves: " << reasoning << ", Rewrite moves: " << rewrite << ", Disjunction splits: " << split << ", Backtracks: " << backtrack;
 
     if (log) {
-        // Open proofs.log in append mode
-        std::ofstream log_file("proofs.log", std::ios::app);
-        
-        // Check if the file opened successfully
-        if (!log_file.is_open()) {
-            std::cerr << "Error: Could not open proofs.log for appending." << std::endl;
-            return;
-        }
-        
-        // Set the formatting:
-        // - Filename: left-aligned within 20 characters
-        // - Integers: right-aligned within 10 characters each
-        log_file << std::left << std::setw(20) << filename
-                << std::right << std::setw(10) << cleanup
-                << std::right << std::setw(10) << reasoning
-                << std::right << std::setw(10) << rewrite
-                << std::right << std::setw(10) << split
-                << std::right << std::setw(10) << backtrack
-                << std::endl;
-        
-        // Close the file
-        log_file.close();        
+        log_statistics(filename);
+    }
+}
+
+void context_t::log_statistics(const std::string& filename) {
+    // Open proofs.log in append mode
+    std::ofstream log_file("proofs.log", std::ios::app);
+    
+    // Check if the file opened successfully
+    if (!log_file.is_open()) {
+        std::cerr << "Error: Could not open proofs.log for appending." << std::endl;
+        return;
     }
+    
+    // Set the formatting:
+    // - Filename: left-aligned within 20 characters
+    // - Integers: right-aligned within 10 characters each
+    log_file << std::left << std::setw(20) << filename
+            << std::right << std::setw(10) << cleanup
+            << std::right << std::setw(10) << reasoning
+            << std::right << std::setw(10) << rewrite
+            << std::right << std::setw(10) << split
+            << std::right << std::setw(10) << backtrack
+            << std::endl;
+    
+    // Close the file
+    log_file.close();        
 }
 
 void get_special_predicates(std::vector<size_t>& special_lines, context_t& ctx)
@@ -6,7 +6,12 @@
 #include "node.h"
 #include "hydra.h"
 #include "debug.h"
+#include "egraph.h"
+#include "clause_code.h"
+#include "fingerprint.h"
 #include <unordered_map>
+#include <map>
+#include <tuple>
 #include <string>
 #include <iostream>
 #include <vector>
@@ -18,6 +23,7 @@
 #include <optional>
 #include <fstream>
 #include <iomanip>
+#include <cstdint>
 
 // Define the LIBRARY enum to distinguish between Theorem and Definition
 enum class LIBRARY {
@@ -59,6 +65,24 @@ enum class Reason {
     Special
 };
 
+class context_t;
+
+// A module loaded for a tableau. The module context is shared by all tableaux that
+// load it and is never changed, the digest records which of its lines are loaded here.
+struct module_ref {
+    std::string name;                               // Filename stem of the module
+    std::shared_ptr<const context_t> module;        // Module context, owned by the module registry
+    std::vector<std::vector<digest_item>> digest;   // Copy of the module digest with lines of this tableau
+};
+
+// Versions of an implication line, the line it was applied to and the special predicates
+// when modus ponens or tollens last failed for the pair
+struct mpt_failure {
+    unsigned impl_version;
+    unsigned other_version;
+    size_t specials_hash;
+};
+
 // Represents a single line in the tableau
 class tabline_t {
 public:
@@ -78,8 +102,18 @@ public:
     std::vector<std::string> constants1;           // Constants for line or constants on left of implication line
     std::vector<std::string> constants2;           // Constants right of implication line
     std::vector<int> applied_units;                // Tracks applied target indices
+    std::vector<std::vector<int>> applied_tuples;  // Tuples of units already used by hyperresolution
     std::vector<std::pair<std::string, size_t>> lib_applied; // library (name, index) pairs already applied to this unit
     bool split;                                    // If a disjunction, whether it has already been split
+    bool skolemized = false;                       // Whether the formula has no quantifier prefix left to remove
+    std::shared_ptr<clause_code> code;             // For library implications, compiled trial unification patterns
+    fingerprint_t formula_fp;                      // Fingerprints of the formula and negation, refreshed by check_done
+    fingerprint_t negation_fp;
+    unsigned version = 0;                          // Incremented when formula, assumptions or restrictions change in place
+    const node* negated_formula = nullptr;         // Formula and version the negation of a hypothesis was built from
+    unsigned negated_version = 0;
+    const node* fingerprinted = nullptr;           // Negation and version the fingerprints were computed for
+    unsigned fingerprinted_version = 0;
     
     // Constructor Initializer Lists to Match Declaration Order
     tabline_t(node* form) 
@@ -115,6 +149,38 @@ public:
     bool is_rewrite() const {
         return justification.first == Reason::Rewrite;
     }
+
+    // Annotations of the two sides of a binary formula, computed when first asked for
+    // and again only after the version changes, so the formula must not be changed in
+    // place without bumping the version (see context_t::formula_changed)
+    const std::pair<node_info, node_info>& side_info() const;
+
+    // Annotations of the whole formula, kept in the same way
+    const node_info& formula_info() const;
+
+private:
+    // Annotations belong to the line they were computed for. A copy of a line usually
+    // gets a formula of its own, so copies start without them, but moving a line, e.g.
+    // when the tableau grows, keeps them.
+    struct annotations {
+        bool sides_valid = false;
+        std::pair<node_info, node_info> sides;
+        unsigned sides_version = 0;
+        bool info_valid = false;
+        node_info info;
+        unsigned info_version = 0;
+
+        annotations() = default;
+        annotations(const annotations&) {}
+        annotations(annotations&&) = default;
+        annotations& operator=(const annotations&) {
+            sides_valid = info_valid = false;
+            return *this;
+        }
+        annotations& operator=(annotations&&) = default;
+    };
+
+    mutable annotations annotated;
 };
 
 class context_t {
@@ -134,6 +200,9 @@ public:
     // Print how many of each move were executed
     void print_statistics(const std::string filename="none", bool log=false);
 
+    // Appends the statistics for the given file to proofs.log
+    void log_statistics(const std::string& filename);
+
     // Retrieves and increments the next available index for a variable
     int get_next_index(const std::string& var_name);
 
@@ -151,6 +220,11 @@ public:
     // Prints the current state of variable indices for debugging
     void print_context() const;
 
+    // Moves the lines of a fragment built in a separate context to the end of the tableau.
+    // Variable names generated in the fragment are renamed to the names this context
+    // would have generated and line references are offset to the new positions.
+    void append_fragment(context_t& fragment);
+
     // Purges all hypotheses that can only be used to prove dead targets
     void purge_dead();
 
@@ -179,13 +253,29 @@ public:
     // Pair (i, j): i = line in this tableau, j = line in main
     // tableau if theorem/definition line loaded there, else -1
     std::vector<std::vector<digest_item>> digest;
+
+    // Rewrite rules in the digest indexed by the head symbol of their left side
+    // Pair (i, j): i = digest record, j = item in that record
+    std::unordered_map<std::string, std::vector<std::pair<size_t, size_t>>> rewrite_heads;
+
+    // Hash of the contents of the .dat file when ctx is storing a module
+    uint64_t source_hash = 0;
     
-    // Vector of loaded modules: pair of filename stem and their context
-    std::vector<std::pair<std::string, context_t>> modules;
+    // Congruence closure of the equalities from loaded modules and hypotheses, used
+    // for unification in check_done if equality saturation is enabled, else nullptr
+    std::shared_ptr<egraph> congruence;
+    size_t fingerprinted_merges = 0; // Merges of the congruence closure the fingerprints allow for
+
+    // Modules loaded for this tableau
+    std::vector<module_ref> modules;
 
     // Lines already dealt with (used for incremental completion checking)
     size_t upto = 0;
 
+    // Failed non-library modus ponens/tollens attempts keyed by (implication, other line, ponens),
+    // an entry only applies while the versions it records are current
+    std::map<std::tuple<int, int, bool>, mpt_failure> mpt_failures;
+
     // Selects and activates/deactivates targets and hypotheses based on the provided list
     void select_targets(const std::vector<int>& targets);
 
@@ -220,16 +310,27 @@ public:
     // If a digest is present, only lines listed in digest are dealt with
     void get_constants();
 
-    // Function to find a module by filename stem
-    std::optional<context_t*> find_module(const std::string& filename_stem);
+    // Function to find a loaded module by filename stem, returns nullptr if not loaded
+    module_ref* find_module(const std::string& filename_stem);
+
+    // Makes line i of the tableau active or inactive
+    void set_active(size_t i, bool active);
+
+    // Marks line i of the tableau inactive and dead
+    void kill_line(size_t i);
+
+    // To be called when the formula of line i of the tableau is changed in place, bumps its version
+    void formula_changed(size_t i);
 
     // Return constants used in active (non-thm/defn) lines of tableau and constants used in active targets
-    // along with a list of all active implications and unit clauses
+    // along with a list of all active implications and unit clauses. The constants are kept up to date
+    // by the three functions above, so only lines appended since the last call are looked at, along
+    // with the active hypotheses to classify them.
     void get_tableau_constants(std::vector<std::string>& all_constants,
                                std::vector<std::string>& target_constants,
                                std::vector<size_t>& implication_indices,
                                std::vector<size_t>& unit_indices,
-                               std::vector<size_t>& special_indices) const;
+                               std::vector<size_t>& special_indices);
 
     // kill all duplicate lines starting at the given start line
     void kill_duplicates(size_t start_index);
@@ -243,6 +344,34 @@ private:
     // Maps variable base names to their latest index
     std::unordered_map<std::string, int> var_indices;
 
+    // Which constants count a line is included in by get_tableau_constants
+    enum class ConstantsCount {
+        None,
+        Hypothesis,
+        Target
+    };
+
+    // Constants of each line, the version of the line they were computed for and which
+    // count they are included in
+    struct line_constants {
+        bool computed = false;
+        unsigned version = 0;
+        std::vector<std::string> constants;
+        ConstantsCount counted = ConstantsCount::None;
+    };
+
+    std::vector<line_constants> constants_cache;
+
+    // Number of counted lines each constant occurs in
+    std::unordered_map<std::string, int> hypothesis_constant_counts;
+    std::unordered_map<std::string, int> target_constant_counts;
+
+    // Lines counted as hypotheses, in order
+    std::set<size_t> hypothesis_lines;
+
+    // Brings the counts up to date with the current state of line i
+    void update_constants(size_t i);
+
     // Helper Function: Partitions a hydra based on shared variables and creates new hydras
     std::vector<std::shared_ptr<hydra>> partition_hydra(hydra& h);
 };
@@ -0,0 +1,457 @@
+// egraph.cpp
+
+#include "egraph.h"
+#include <algorithm>
+#include <set>
+
+// Key identifying the symbol at the head of a term, arguments excluded
+static std::string enode_head(const node* term) {
+    switch (term->type) {
+    case VARIABLE:
+        return "v" + std::to_string(static_cast<int>(term->vdata->var_kind)) + ":" + term->name();
+    case APPLICATION:
+        return "f:" + term->children[0]->name();
+    case TUPLE:
+        return "t";
+    default:
+        return "#" + std::to_string(static_cast<int>(term->symbol));
+    }
+}
+
+// Index of the first child that is an argument of the head symbol
+static size_t first_arg(const node* term) {
+    return term->type == APPLICATION ? 1 : 0;
+}
+
+// Whether the term contains variables that may still be assigned or that are bound
+static bool has_variables(const node* term) {
+    if (term->type == VARIABLE) {
+        return term->is_free_variable() || term->vdata->bound;
+    }
+
+    for (size_t i = first_arg(term); i < term->children.size(); ++i) {
+        if (has_variables(term->children[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int egraph::find(int c) const {
+    int root = c;
+    while (parent[root] != root) {
+        root = parent[root];
+    }
+
+    // Path compression
+    while (parent[c] != root) {
+        int next = parent[c];
+        parent[c] = root;
+        c = next;
+    }
+
+    return root;
+}
+
+void egraph::merge(int a, int b, proof_edge edge) {
+    int ra = find(a);
+    int rb = find(b);
+    if (ra == rb) {
+        return;
+    }
+    parent[std::max(ra, rb)] = std::min(ra, rb);
+    class_size[std::min(ra, rb)] += class_size[std::max(ra, rb)];
+
+    // Make a the root of its proof tree by reversing the path above it, then hang
+    // it below b
+    int x = a, prev = -1, prev_edge = -1;
+    while (x != -1) {
+        int next = proof_parent[x];
+        int next_edge = proof_edge_of[x];
+        proof_parent[x] = prev;
+        proof_edge_of[x] = prev_edge;
+        prev = x;
+        prev_edge = next_edge;
+        x = next;
+    }
+
+    proof_parent[a] = b;
+    proof_edge_of[a] = edges.size();
+    edges.push_back(std::move(edge));
+}
+
+int egraph::add_enode(const std::string& head, std::vector<int> args) {
+    for (int& a : args) {
+        a = find(a);
+    }
+
+    auto key = std::make_pair(head, args);
+    auto it = hashcons.find(key);
+    if (it != hashcons.end()) {
+        return it->second;
+    }
+
+    int id = nodes.size();
+    nodes.push_back({head, args});
+    parent.push_back(id);
+    class_size.push_back(1);
+    proof_parent.push_back(-1);
+    proof_edge_of.push_back(-1);
+    hashcons[key] = id;
+    saturated = false;
+
+    return id;
+}
+
+int egraph::add_ground(const node* term) {
+    std::vector<int> args;
+    for (size_t i = first_arg(term); i < term->children.size(); ++i) {
+        args.push_back(add_ground(term->children[i]));
+    }
+
+    return add_enode(enode_head(term), args);
+}
+
+int egraph::add_term(const node* term) {
+    if (!term->is_term() || has_variables(term)) {
+        return -1;
+    }
+
+    return add_ground(term);
+}
+
+void egraph::add_terms(const node* formula) {
+    if (formula->is_term()) {
+        add_term(formula);
+        return;
+    }
+
+    for (size_t i = first_arg(formula); i < formula->children.size(); ++i) {
+        add_terms(formula->children[i]);
+    }
+}
+
+void egraph::merge_terms(const node* a, const node* b, int reason) {
+    int na = add_term(a);
+    int nb = add_term(b);
+
+    if (na != -1 && nb != -1 && find(na) != find(nb)) {
+        merge(na, nb, {reason, {}});
+        rebuild();
+        saturated = false;
+    }
+}
+
+bool egraph::add_rule(const node* lhs, const node* rhs, int reason) {
+    if (!lhs->is_term() || !rhs->is_term() || lhs->is_free_variable()) {
+        return false;
+    }
+
+    std::set<std::string> vars_lhs, vars_rhs;
+    vars_used(vars_lhs, lhs, false, false);
+    vars_used(vars_rhs, rhs, false, false);
+    if (!std::includes(vars_lhs.begin(), vars_lhs.end(), vars_rhs.begin(), vars_rhs.end())) {
+        return false; // Right side can't be instantiated from a match
+    }
+
+    for (const rule& r : rules) {
+        if (r.lhs == lhs && r.rhs == rhs) {
+            return true; // Already added
+        }
+    }
+
+    rules.push_back({lhs, rhs, reason});
+    saturated = false;
+
+    return true;
+}
+
+// Two nodes with the same head and equal arguments must be in the same class.
+// The hashcons is recomputed with canonical arguments until no merges happen.
+void egraph::rebuild() {
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        std::map<std::pair<std::string, std::vector<int>>, int> canonical;
+
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            std::vector<int> args = nodes[n].args;
+            for (int& a : args) {
+                a = find(a);
+            }
+
+            auto key = std::make_pair(nodes[n].head, args);
+            auto it = canonical.find(key);
+            if (it == canonical.end()) {
+                canonical[key] = n;
+            } else if (find(it->second) != find(n)) {
+                // Congruence, justified by the equality of the arguments
+                proof_edge edge = {-1, {}};
+                for (size_t i = 0; i < args.size(); ++i) {
+                    edge.premises.emplace_back(nodes[it->second].args[i], nodes[n].args[i]);
+                }
+                merge(it->second, n, std::move(edge));
+                changed = true;
+            }
+        }
+
+        hashcons.swap(canonical);
+    }
+}
+
+// Finds the e-node of the term in one pass, a term with variables has none
+int egraph::lookup(const node* term) const {
+    if (caching) {
+        auto it = cache.find(term);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    int n = -1;
+    if (term->is_term() && !(term->type == VARIABLE && (term->is_free_variable() || term->vdata->bound))) {
+        std::vector<int> args;
+        size_t i = first_arg(term);
+        for ( ; i < term->children.size(); ++i) {
+            int c = lookup(term->children[i]);
+            if (c == -1) {
+                break;
+            }
+            args.push_back(find(c));
+        }
+
+        if (i == term->children.size()) {
+            auto it = hashcons.find(std::make_pair(enode_head(term), args));
+            if (it != hashcons.end()) {
+                n = it->second;
+            }
+        }
+    }
+
+    if (caching) {
+        cache[term] = n;
+    }
+
+    return n;
+}
+
+bool egraph::in_merged_class(const node* term) const {
+    int n = lookup(term);
+    return n != -1 && class_size[find(n)] > 1;
+}
+
+bool egraph::equivalent(const node* a, const node* b) const {
+    int na = lookup(a);
+    if (na == -1) {
+        return false;
+    }
+
+    int nb = lookup(b);
+    if (nb == -1 || find(na) != find(nb)) {
+        return false;
+    }
+
+    if (equivalent_log) {
+        equivalent_log->emplace_back(a, b);
+    }
+
+    return true;
+}
+
+void egraph::explain(const node* a, const node* b, std::set<int>& reasons) const {
+    std::set<int> explained;
+    int na = explain_term(a, reasons, explained);
+    int nb = explain_term(b, reasons, explained);
+    explain_nodes(na, nb, reasons, explained);
+}
+
+// Returns the e-node lookup() finds for the term, explaining why each argument of the
+// term is equal to the corresponding argument of that e-node
+int egraph::explain_term(const node* term, std::set<int>& reasons, std::set<int>& explained) const {
+    int n = lookup(term);
+    if (n == -1) {
+        return -1;
+    }
+
+    size_t start = first_arg(term);
+    for (size_t i = 0; i + start < term->children.size(); ++i) {
+        int m = explain_term(term->children[start + i], reasons, explained);
+        explain_nodes(m, nodes[n].args[i], reasons, explained);
+    }
+
+    return n;
+}
+
+// Collects the edges on the path between a and b in the proof forest, and recursively
+// those the premises of the edges rely on. Each edge is explained once.
+void egraph::explain_nodes(int a, int b, std::set<int>& reasons, std::set<int>& explained) const {
+    if (a == b || a == -1 || b == -1) {
+        return;
+    }
+
+    std::vector<int> path_a;
+    for (int x = a; x != -1; x = proof_parent[x]) {
+        path_a.push_back(x);
+    }
+
+    std::vector<int> path_b;
+    int common = b;
+    while (common != -1 && std::find(path_a.begin(), path_a.end(), common) == path_a.end()) {
+        path_b.push_back(common);
+        common = proof_parent[common];
+    }
+    if (common == -1) {
+        return; // Not in the same class
+    }
+
+    path_a.resize(std::find(path_a.begin(), path_a.end(), common) - path_a.begin());
+    path_a.insert(path_a.end(), path_b.begin(), path_b.end());
+
+    for (int x : path_a) {
+        int e = proof_edge_of[x];
+        if (!explained.insert(e).second) {
+            continue;
+        }
+
+        if (edges[e].reason >= 0) {
+            reasons.insert(edges[e].reason);
+        }
+        for (const auto& [p, q] : edges[e].premises) {
+            explain_nodes(p, q, reasons, explained);
+        }
+    }
+}
+
+// Finds all assignments of e-classes to the free variables of the pattern such that
+// the pattern is in class c, extending the given binding
+void egraph::ematch(const node* pattern, int c, std::unordered_map<std::string, int>& binding,
+                    std::vector<std::unordered_map<std::string, int>>& matches,
+                    const std::vector<std::vector<int>>& members) const {
+    if (pattern->is_free_variable()) {
+        auto it = binding.find(pattern->name());
+        if (it == binding.end()) {
+            binding[pattern->name()] = c;
+            matches.push_back(binding);
+            binding.erase(pattern->name());
+        } else if (find(it->second) == c) {
+            matches.push_back(binding);
+        }
+        return;
+    }
+
+    std::string head = enode_head(pattern);
+    size_t start = first_arg(pattern);
+    size_t arity = pattern->children.size() - start;
+
+    for (int n : members[c]) {
+        if (nodes[n].head != head || nodes[n].args.size() != arity) {
+            continue;
+        }
+
+        // Match the arguments left to right, each partial match extends the binding
+        std::vector<std::unordered_map<std::string, int>> partial = { binding };
+        for (size_t i = 0; i < arity && !partial.empty(); ++i) {
+            std::vector<std::unordered_map<std::string, int>> next;
+            for (auto& b : partial) {
+                ematch(pattern->children[start + i], find(nodes[n].args[i]), b, next, members);
+            }
+            partial.swap(next);
+        }
+
+        matches.insert(matches.end(), partial.begin(), partial.end());
+    }
+}
+
+int egraph::instantiate(const node* pattern, const std::unordered_map<std::string, int>& binding) {
+    if (pattern->is_free_variable()) {
+        return binding.at(pattern->name());
+    }
+
+    std::vector<int> args;
+    for (size_t i = first_arg(pattern); i < pattern->children.size(); ++i) {
+        args.push_back(instantiate(pattern->children[i], binding));
+    }
+
+    return add_enode(enode_head(pattern), args);
+}
+
+// Adds the pairs of e-nodes that must be equal for e-node n to be the pattern with
+// the binding applied: each argument of n and the instance of the pattern for it
+void egraph::pattern_premises(const node* pattern, int n, const std::unordered_map<std::string, int>& binding,
+                              std::vector<std::pair<int, int>>& premises) {
+    if (pattern->is_free_variable()) {
+        premises.emplace_back(n, binding.at(pattern->name()));
+        return;
+    }
+
+    size_t start = first_arg(pattern);
+    for (size_t i = 0; i + start < pattern->children.size(); ++i) {
+        const node* child = pattern->children[start + i];
+        int m = instantiate(child, binding);
+        premises.emplace_back(nodes[n].args[i], m);
+        if (!child->is_free_variable()) {
+            pattern_premises(child, m, binding, premises);
+        }
+    }
+}
+
+void egraph::saturate(int max_iters, size_t max_nodes) {
+    if (saturated) {
+        return;
+    }
+
+    for (int iter = 0; iter < max_iters && nodes.size() <= max_nodes; ++iter) {
+        // Nodes of each canonical class
+        std::vector<std::vector<int>> members(nodes.size());
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            members[find(n)].push_back(n);
+        }
+
+        // Collect all matches first, as instantiating changes the e-graph
+        std::vector<std::pair<size_t, std::unordered_map<std::string, int>>> found;
+        for (size_t r = 0; r < rules.size(); ++r) {
+            for (size_t c = 0; c < members.size(); ++c) {
+                if (members[c].empty()) {
+                    continue;
+                }
+
+                std::unordered_map<std::string, int> binding;
+                std::vector<std::unordered_map<std::string, int>> matches;
+                ematch(rules[r].lhs, c, binding, matches, members);
+
+                for (auto& m : matches) {
+                    found.emplace_back(r, m);
+                }
+            }
+        }
+
+        size_t old_size = nodes.size();
+        bool merged = false;
+
+        for (auto& [r, binding] : found) {
+            int lhs = instantiate(rules[r].lhs, binding);
+            int rhs = instantiate(rules[r].rhs, binding);
+            if (find(lhs) != find(rhs)) {
+                proof_edge edge = {rules[r].reason, {}};
+                pattern_premises(rules[r].lhs, lhs, binding, edge.premises);
+                pattern_premises(rules[r].rhs, rhs, binding, edge.premises);
+                merge(lhs, rhs, std::move(edge));
+                merged = true;
+            }
+
+            if (nodes.size() > max_nodes) {
+                break;
+            }
+        }
+
+        rebuild();
+
+        if (!merged && nodes.size() == old_size) {
+            break; // Saturated
+        }
+    }
+
+    saturated = true;
+}
@@ -0,0 +1,145 @@
+// egraph.h
+
+#ifndef EGRAPH_H
+#define EGRAPH_H
+
+#include "node.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+// A node of the e-graph: a function or operator symbol applied to e-classes
+struct enode {
+    std::string head;
+    std::vector<int> args;
+};
+
+// Why two e-nodes were merged: the reason given by the caller (-1 for congruence)
+// and pairs of e-nodes whose equality the merge relied on
+struct proof_edge {
+    int reason;
+    std::vector<std::pair<int, int>> premises;
+};
+
+// Congruence closure of a set of terms under equalities, with equality saturation
+// for rewrite rules containing variables. Terms are only ever added, so equivalence
+// classes grow monotonically. Terms containing free variables are not stored.
+// Each equality and rule carries a reason, a non-negative number chosen by the
+// caller, and explain() gives the reasons two terms were found equal by.
+class egraph {
+public:
+    // Adds the term and all its subterms, returns its e-node or -1 if the term
+    // contains free variables
+    int add_term(const node* term);
+
+    // Adds all terms without free variables occurring in the formula
+    void add_terms(const node* formula);
+
+    // Records that the two terms are equal for the given reason
+    void merge_terms(const node* a, const node* b, int reason);
+
+    // Adds a rule lhs = rhs with free variables, applied during saturation. The
+    // rule is not copied and adding it again has no effect. Returns false if the
+    // rule can't be used for saturation.
+    bool add_rule(const node* lhs, const node* rhs, int reason);
+
+    // Instantiates the rules with all matching e-classes until nothing changes,
+    // max_iters rounds are done or the e-graph has more than max_nodes nodes. Does
+    // nothing if no terms or rules were added since the last saturation.
+    void saturate(int max_iters = 5, size_t max_nodes = 2000);
+
+    // Whether the two terms are known to be equal, false if either term is not
+    // in the e-graph. While a log is attached, the terms found equivalent are
+    // appended to it.
+    bool equivalent(const node* a, const node* b) const;
+
+    // Adds the reasons of the equalities and rules that make the two terms equal,
+    // which must be equivalent()
+    void explain(const node* a, const node* b, std::set<int>& reasons) const;
+
+    void set_log(std::vector<std::pair<const node*, const node*>>* log) const {
+        equivalent_log = log;
+    }
+
+    // While the cache is on, the e-node found for each term is remembered, so that
+    // subterms compared again and again are only looked up once. Neither the terms
+    // looked up nor the e-graph may change until it is turned off.
+    void set_cache(bool on) const {
+        caching = on;
+        cache.clear();
+    }
+
+    // Whether the term is in a class with other e-nodes, so that it may be equal to
+    // a term of a different shape
+    bool in_merged_class(const node* term) const;
+
+    // Whether any classes were merged, if not only equal terms are equivalent
+    bool has_equalities() const {
+        return !edges.empty();
+    }
+
+    // Number of merges so far, which changes whenever terms become equal
+    size_t merges() const {
+        return edges.size();
+    }
+
+    size_t size() const {
+        return nodes.size();
+    }
+
+private:
+    std::vector<enode> nodes;
+    mutable std::vector<int> parent; // union-find over e-nodes, the root of a class being its e-class
+    std::vector<int> class_size;     // number of e-nodes in the class, at its root
+    std::map<std::pair<std::string, std::vector<int>>, int> hashcons; // canonical node -> node
+
+    // Proof forest: each e-node but the root of its tree points to the e-node it was
+    // merged with, by edge proof_edge_of of edges
+    std::vector<int> proof_parent;
+    std::vector<int> proof_edge_of;
+    std::vector<proof_edge> edges;
+
+    struct rule {
+        const node* lhs;
+        const node* rhs;
+        int reason;
+    };
+    std::vector<rule> rules;
+    bool saturated = true; // whether nothing was added since the last saturation
+
+    mutable std::vector<std::pair<const node*, const node*>>* equivalent_log = nullptr;
+    mutable bool caching = false;
+    mutable std::unordered_map<const node*, int> cache; // e-node of each term looked up, -1 if none
+
+    int find(int c) const;
+
+    // Merges the classes of e-nodes a and b, recording why
+    void merge(int a, int b, proof_edge edge);
+
+    // Restores the congruence invariant after merges
+    void rebuild();
+
+    int add_enode(const std::string& head, std::vector<int> args);
+
+    // Adds a term known to contain no variables
+    int add_ground(const node* term);
+
+    int lookup(const node* term) const;
+
+    int explain_term(const node* term, std::set<int>& reasons, std::set<int>& explained) const;
+
+    void explain_nodes(int a, int b, std::set<int>& reasons, std::set<int>& explained) const;
+
+    void ematch(const node* pattern, int c, std::unordered_map<std::string, int>& binding,
+                std::vector<std::unordered_map<std::string, int>>& matches,
+                const std::vector<std::vector<int>>& members) const;
+
+    int instantiate(const node* pattern, const std::unordered_map<std::string, int>& binding);
+
+    void pattern_premises(const node* pattern, int n, const std::unordered_map<std::string, int>& binding,
+                          std::vector<std::pair<int, int>>& premises);
+};
+
+#endif // EGRAPH_H
@@ -0,0 +1,107 @@
+// fingerprint.cpp
+
+#include "fingerprint.h"
+#include <functional>
+#include <string>
+
+// Special values at a position, all symbol codes are larger
+enum : uint32_t {
+    FP_VARIABLE = 0, // a free variable, matches any symbol
+    FP_BELOW = 1,    // below a variable or quantifier, matches anything
+    FP_NONE = 2      // the position does not exist
+};
+
+// Code of the symbol at the root of the node, including its arity
+static uint32_t symbol_code(const node* n) {
+    size_t h;
+
+    if (n->type == VARIABLE) {
+        h = std::hash<std::string>()(n->name()) ^ (static_cast<size_t>(n->vdata->var_kind) << 1);
+    } else {
+        h = (static_cast<size_t>(n->type) << 16) ^ static_cast<size_t>(n->symbol);
+        if (n->type == APPLICATION && n->children[0]->type == VARIABLE) {
+            h ^= std::hash<std::string>()(n->children[0]->name()) << 1;
+        }
+    }
+    h = h * 31 + n->children.size();
+
+    return static_cast<uint32_t>(h % (UINT32_MAX - FP_NONE)) + FP_NONE + 1;
+}
+
+static uint32_t position_code(const node* n, bool& stop, const egraph* eg) {
+    if (n->is_free_variable()) {
+        stop = true;
+        return FP_VARIABLE;
+    }
+
+    if (eg && n->is_term() && eg->in_merged_class(n)) {
+        stop = true;
+        return FP_BELOW;
+    }
+
+    // Bound variables of quantifiers are renamed by unify, so don't look inside
+    stop = (n->type == QUANTIFIER);
+
+    return symbol_code(n);
+}
+
+fingerprint_t get_fingerprint(const node* formula, const egraph* eg) {
+    fingerprint_t fp;
+    fp.valid = true;
+    fp.symbols.fill(FP_NONE);
+
+    bool stop;
+    fp.symbols[0] = position_code(formula, stop, eg);
+    if (stop) {
+        for (size_t i = 1; i < FINGERPRINT_SIZE; ++i) {
+            fp.symbols[i] = FP_BELOW;
+        }
+        return fp;
+    }
+
+    for (size_t i = 0; i < 2; ++i) {
+        if (i >= formula->children.size()) {
+            continue; // Positions below don't exist either
+        }
+
+        const node* child = formula->children[i];
+        bool child_stop;
+        fp.symbols[1 + i] = position_code(child, child_stop, eg);
+
+        for (size_t j = 0; j < 2; ++j) {
+            uint32_t& code = fp.symbols[3 + 2*i + j];
+            if (child_stop) {
+                code = FP_BELOW;
+            } else if (j < child->children.size()) {
+                bool grandchild_stop;
+                code = position_code(child->children[j], grandchild_stop, eg);
+            }
+        }
+    }
+
+    return fp;
+}
+
+bool fingerprints_compatible(const fingerprint_t& fp1, const fingerprint_t& fp2) {
+    if (!fp1.valid || !fp2.valid) {
+        return true;
+    }
+
+    for (size_t i = 0; i < FINGERPRINT_SIZE; ++i) {
+        uint32_t a = fp1.symbols[i];
+        uint32_t b = fp2.symbols[i];
+
+        if (a == b || a == FP_BELOW || b == FP_BELOW) {
+            continue;
+        }
+
+        // A variable can be replaced by any term, but that doesn't create a missing position
+        if ((a == FP_VARIABLE && b != FP_NONE) || (b == FP_VARIABLE && a != FP_NONE)) {
+            continue;
+        }
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,31 @@
+// fingerprint.h
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include "node.h"
+#include "egraph.h"
+#include <array>
+#include <cstdint>
+
+// Number of positions sampled: the root, its first two children and their first
+// two children
+#define FINGERPRINT_SIZE 7
+
+// Symbols at fixed shallow positions of a formula, used to reject pairs of
+// formulas that can't unify before calling unify
+struct fingerprint_t {
+    bool valid = false;
+    std::array<uint32_t, FINGERPRINT_SIZE> symbols{};
+};
+
+// Computes the fingerprint of a formula. Free variables are wildcards, as are terms
+// in a class of the e-graph with other terms, if one is given, since they may unify
+// with terms of a different shape.
+fingerprint_t get_fingerprint(const node* formula, const egraph* eg = nullptr);
+
+// Whether formulas with the given fingerprints may unify. Invalid fingerprints
+// are compatible with everything.
+bool fingerprints_compatible(const fingerprint_t& fp1, const fingerprint_t& fp2);
+
+#endif // FINGERPRINT_H
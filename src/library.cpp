@@ -1,10 +1,12 @@
 // library.cpp
 
+#include "library.h"
 #include "context.h"
 #include "grammar.h"
 #include "hydra.h"
 #include "moves.h"
-#include <fstream>
+#include "rewrite.h"
+#include "mapped_file.h"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -13,108 +15,159 @@
 #include <memory>
 #include <unordered_set>
 #include <functional>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <map>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+
+#define PREMISE_DEPTH 0 // how many rounds of triggering premise selection does, 0 for no limit
+#define PREMISE_TOLERANCE 2.0 // how much more common than the rarest symbol of a record a trigger symbol may be
+
+// Cleans up a single record in a context of its own, so records can be done in parallel
+static void normalise_record(context_t& fragment, record_t record, node* ast) {
+    tabline_t new_tabline(ast);
+    fragment.tableau.push_back(new_tabline);
+
+    if (record == RECORD_DEFINITION) {
+        cleanup_definition(fragment, 0);
+    }
+    else if (record == RECORD_THEOREM) {
+        cleanup_moves(fragment, 0);
+    }
+    else {
+        cleanup_rewrite(fragment, 0);
+    }
+
+    fragment.upto = fragment.tableau.size();
+}
 
 // Loads theorems and definitions from a .dat file into the tableau.
 bool library_load(context_t& context, const std::string& base_str) {
     // Step 1: Generate Filename
     std::string filename = base_str + ".dat";
 
-    // Step 2: Open File
-    std::ifstream infile(filename);
-    if (!infile.is_open()) {
+    // Step 2: Map the whole file into memory
+    mapped_file file(filename);
+    if (!file.is_open()) {
         std::cerr << "Error: Could not open file " << filename << std::endl;
         return false;
     }
 
     // Step 3: Initialize Parser
     manager_t mgr;
-    mgr.input = nullptr; // Initialize manager input
+    mgr.input = file.c_str(); // The parser reads all records from the one buffer
     mgr.pos = 0;
 
     parser_context_t* ctx = parser_create(&mgr);
     if (ctx == nullptr) {
         std::cerr << "Failed to create parser context." << std::endl;
-        infile.close();
         return false;
     }
 
-    // Step 4: Read and Process Records
-    std::string line_type, line_formula, line_blank;
+    // Step 4: Parse all Records, the parser is not reentrant so this is done in order
+    std::vector<std::pair<record_t, node*>> records;
     int record_number = 0;
+    bool more_input = file.size() != 0;
+    bool skip_formula = false; // Whether the next line is the formula of a skipped record
 
-    while (std::getline(infile, line_type)) {
-        // Skip blank lines between records
-        if (line_type.empty()) {
-            continue;
+    while (more_input) {
+        mgr.record = RECORD_NONE;
+
+        node* ast = nullptr;
+        more_input = parser_parse(ctx, &ast);
+
+        record_t record = mgr.record;
+        if (record == RECORD_BLANK) {
+            continue; // Skip blank lines between records
         }
 
-        // Read the formula line
-        if (!std::getline(infile, line_formula)) {
-            std::cerr << "Error: Incomplete record after type: " << line_type << std::endl;
-            break; // Exit the loop as the record is incomplete
+        if (skip_formula) {
+            skip_formula = false;
+            delete ast;
+            continue;
         }
 
-        // Read the blank line separating records
-        std::getline(infile, line_blank); // This can be empty; no action needed
+        if (record != RECORD_THEOREM && record != RECORD_DEFINITION && record != RECORD_REWRITE) {
+            std::cerr << "Warning: Unknown record type '" << statement_line(&mgr) << "' on line " << mgr.line
+                      << ", skipping the record." << std::endl;
+            delete ast;
+            skip_formula = true;
+            continue;
+        }
 
         record_number++;
 
-        // Step 5: Record initial_upto
-        size_t initial_upto = context.upto;
-
-        // Step 6: Parse the Formula
-        std::string modified_input = line_formula + "\n"; // Add newline as per parser requirement
-        mgr.input = modified_input.c_str();
-        mgr.pos = 0;
-
-        node* ast = nullptr;
-        parser_parse(ctx, &ast);
-
+        // Step 5: Check the Formula parsed
         if (!ast) {
-            std::cerr << "Error parsing formula in record " << record_number << ": " << line_formula << std::endl;
+            std::cerr << "Error parsing formula in record " << record_number << " on line " << mgr.line + 1
+                      << ": " << statement_line(&mgr, 1) << std::endl;
             continue; // Skip to the next record
         }
 
-        // Step 7: Add Formula to Tableau
-        tabline_t new_tabline(ast);
-        context.tableau.push_back(new_tabline);
+        records.emplace_back(record, ast);
+    }
 
-        // Step 8: Perform Cleanup Based on Record Type
-        if (line_type == "definition") {
-            cleanup_definition(context, initial_upto);
-        }
-        else if (line_type == "theorem") {
-            cleanup_moves(context, initial_upto);
-        }
-        else if (line_type == "rewrite") {
-            cleanup_rewrite(context, initial_upto);
+    // The formulas don't refer to the parser or file, so these can go now
+    parser_destroy(ctx);
+
+    // Step 6: Clean up each Record in a Fragment of its own, in parallel
+    std::vector<context_t> fragments(records.size());
+    std::atomic<size_t> next_record(0);
+
+    auto worker = [&]() {
+        for (size_t r = next_record++; r < records.size(); r = next_record++) {
+            normalise_record(fragments[r], records[r].first, records[r].second);
         }
-        else {
-            std::cerr << "Warning: Unknown record type '" << line_type << "' in record " << record_number << "." << std::endl;
-            // Optionally, handle unknown types differently
+    };
+
+    size_t num_threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), records.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Step 7: Stitch the Fragments into the Module in Record Order
+    for (size_t r = 0; r < records.size(); ++r) {
+        record_t record = records[r].first;
+        size_t initial_upto = context.upto;
+
+        // Lines of a theorem cleaned up before anything was in the digest have their
+        // constants computed, later ones only get them once the module is complete
+        if (record != RECORD_THEOREM || !context.digest.empty()) {
+            for (auto& tabline : fragments[r].tableau) {
+                tabline.constants1.clear();
+                tabline.constants2.clear();
+            }
         }
 
-        context.upto = context.tableau.size();
+        context.append_fragment(fragments[r]);
+
+        // Duplicates of lines from earlier records are only killed for theorems
+        if (record == RECORD_THEOREM) {
+            context.kill_duplicates(initial_upto);
+        }
 
-        // Step 9: Update Digest with LIBRARY Kind
+        // Step 8: Update Digest with LIBRARY Kind
         std::vector<digest_item> digest_entry;
         for (size_t i = initial_upto; i < context.upto; ++i) {
             if (context.tableau[i].active) { // Only consider active lines
-                // Determine the kind based on line_type
+                // Determine the kind based on the record type
                 LIBRARY kind;
-                if (line_type == "theorem") {
+                if (record == RECORD_THEOREM) {
                     kind = LIBRARY::Theorem;
                 }
-                else if (line_type == "definition") {
+                else if (record == RECORD_DEFINITION) {
                     kind = LIBRARY::Definition;
                 }
-                else if (line_type == "rewrite") {
-                    kind = LIBRARY::Rewrite;
-                }
                 else {
-                    // If unknown type, default or skip
-                    std::cerr << "Warning: Skipping line " << (i + 1) << " due to unknown type '" << line_type << "'." << std::endl;
-                    continue;
+                    kind = LIBRARY::Rewrite;
                 }
 
                 // Initialize main_tableau_line_idx to a special value (e.g., max size_t) indicating not loaded yet
@@ -123,13 +176,317 @@ bool library_load(context_t& context, const std::string& base_str) {
         }
 
         if (!digest_entry.empty()) {
+            // Compile the patterns used to try implications against units
+            for (auto& item : digest_entry) {
+                tabline_t& tabline = context.tableau[item.module_line_idx];
+                if (item.kind != LIBRARY::Rewrite && tabline.formula->is_implication() &&
+                    unwrap_special(tabline.formula)->is_implication()) {
+                    tabline.code = compile_clause(tabline.formula);
+                }
+            }
+
+            // Index rewrite rules by the head symbol of their left side
+            for (size_t j = 0; j < digest_entry.size(); ++j) {
+                node* formula = context.tableau[digest_entry[j].module_line_idx].formula;
+                if (digest_entry[j].kind == LIBRARY::Rewrite && formula->is_equality()) {
+                    // Orient the rule so that the left side is the greater one in the term ordering
+                    if (term_greater(formula->children[1], formula->children[0])) {
+                        std::swap(formula->children[0], formula->children[1]);
+                        context.formula_changed(digest_entry[j].module_line_idx);
+                    }
+
+                    std::string head = head_symbol(formula->children[0]);
+                    if (!head.empty()) {
+                        context.rewrite_heads[head].emplace_back(context.digest.size(), j);
+                    }
+                }
+            }
+
             context.digest.push_back(digest_entry);
         }
     }
 
-    // Step 10: Clean Up Parser and Close File
-    parser_destroy(ctx);
-    infile.close();
+    return true;
+}
+
+// Collects the non-logical symbols of a formula: built in predicates, operators and
+// constants and the names of user defined functions, predicates and structures
+static void premise_symbols(std::set<std::string>& symbols, const node* formula) {
+    if (formula->type == VARIABLE) {
+        if (formula->vdata->var_kind == FUNCTION || formula->vdata->var_kind == PREDICATE) {
+            symbols.insert(formula->vdata->name);
+        }
+    }
+    else if (precedenceTable[formula->symbol].nonlogical) {
+        symbols.insert(std::string(precedenceTable[formula->symbol].unicode));
+    }
+
+    for (const node* child : formula->children) {
+        premise_symbols(symbols, child);
+    }
+}
+
+void select_premises(context_t& tab_ctx) {
+    // A record is identified by its module and its index in the module digest
+    struct premise_t {
+        module_ref* ref;
+        size_t record;
+        std::set<std::string> symbols;
+    };
+
+    std::vector<premise_t> premises;
+    std::map<std::string, size_t> occurrences; // number of records each symbol occurs in
+
+    for (auto& ref : tab_ctx.modules) {
+        for (size_t r = 0; r < ref.digest.size(); ++r) {
+            // Rewrites are found by head symbol, not by scanning, so they are always kept,
+            // as are records already loaded into the tableau
+            bool keep = std::any_of(ref.digest[r].begin(), ref.digest[r].end(),
+                [](const digest_item& item) {
+                    return item.kind == LIBRARY::Rewrite || item.main_tableau_line_idx != static_cast<size_t>(-1);
+                });
+            if (keep || ref.digest[r].empty()) {
+                continue;
+            }
+
+            premise_t premise{&ref, r, {}};
+            for (const auto& item : ref.digest[r]) {
+                premise_symbols(premise.symbols, ref.module->tableau[item.module_line_idx].formula);
+            }
+            for (const auto& symbol : premise.symbols) {
+                occurrences[symbol]++;
+            }
+            premises.push_back(std::move(premise));
+        }
+    }
+
+    // A record is triggered by those of its symbols that are nearly as rare as its rarest
+    std::map<std::string, std::vector<size_t>> triggers;
+    std::vector<bool> selected(premises.size(), false);
+
+    for (size_t i = 0; i < premises.size(); ++i) {
+        if (premises[i].symbols.empty()) {
+            selected[i] = true; // nothing can trigger it
+            continue;
+        }
+
+        size_t rarest = SIZE_MAX;
+        for (const auto& symbol : premises[i].symbols) {
+            rarest = std::min(rarest, occurrences[symbol]);
+        }
+        for (const auto& symbol : premises[i].symbols) {
+            if (occurrences[symbol] <= PREMISE_TOLERANCE*rarest) {
+                triggers[symbol].push_back(i);
+            }
+        }
+    }
+
+    // Start from the symbols of the problem and follow triggers outwards
+    std::set<std::string> seen;
+    for (const auto& tabline : tab_ctx.tableau) {
+        if (tabline.formula) {
+            premise_symbols(seen, tabline.formula);
+        }
+    }
+    std::vector<std::string> frontier(seen.begin(), seen.end());
+
+    for (int depth = 0; !frontier.empty() && (PREMISE_DEPTH == 0 || depth < PREMISE_DEPTH); ++depth) {
+        std::vector<std::string> next;
+        for (const auto& symbol : frontier) {
+            auto it = triggers.find(symbol);
+            if (it == triggers.end()) {
+                continue;
+            }
+            for (size_t i : it->second) {
+                if (selected[i]) {
+                    continue;
+                }
+                selected[i] = true;
+                for (const auto& new_symbol : premises[i].symbols) {
+                    if (seen.insert(new_symbol).second) {
+                        next.push_back(new_symbol);
+                    }
+                }
+            }
+        }
+        frontier = std::move(next);
+    }
+
+    // Records that weren't selected are emptied rather than removed, so that indices
+    // into the digest, such as those of rewrite heads, remain valid
+    for (size_t i = 0; i < premises.size(); ++i) {
+        if (!selected[i]) {
+            premises[i].ref->digest[premises[i].record].clear();
+        }
+    }
+}
+
+void restore_premises(context_t& tab_ctx) {
+    // Only records that weren't selected are empty, and none of their lines were loaded
+    for (auto& ref : tab_ctx.modules) {
+        for (size_t r = 0; r < ref.digest.size(); ++r) {
+            if (ref.digest[r].empty()) {
+                ref.digest[r] = ref.module->digest[r];
+            }
+        }
+    }
+}
+
+// Converts a symbol as written in a .dat file to the form premise_symbols produces
+static std::string manifest_symbol(const std::string& token) {
+    for (int sym = 0; sym < SYMBOL_COUNT; ++sym) {
+        if (precedenceTable[sym].nonlogical && precedenceTable[sym].repr == token) {
+            return std::string(precedenceTable[sym].unicode);
+        }
+    }
+    return token;
+}
+
+// Converts a symbol produced by premise_symbols back to the form written in .dat files
+static std::string dat_symbol(const std::string& symbol) {
+    for (int sym = 0; sym < SYMBOL_COUNT; ++sym) {
+        if (precedenceTable[sym].nonlogical && precedenceTable[sym].unicode == symbol) {
+            return std::string(precedenceTable[sym].repr);
+        }
+    }
+    return symbol;
+}
+
+bool manifest_load(std::vector<manifest_entry>& manifest, const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open manifest " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    size_t line_num = 0;
+    while (std::getline(file, line)) {
+        line_num++;
+
+        std::istringstream tokens(line);
+        std::string keyword, token;
+        if (!(tokens >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+
+        if (keyword == "module") {
+            if (!(tokens >> token)) {
+                std::cerr << "Error: Missing module name in " << filename << " line " << line_num << std::endl;
+                return false;
+            }
+            manifest.push_back({token, {}, {}});
+        }
+        else if (manifest.empty()) {
+            std::cerr << "Error: Expected module in " << filename << " line " << line_num << std::endl;
+            return false;
+        }
+        else if (keyword == "needs") {
+            while (tokens >> token) {
+                manifest.back().needs.push_back(token);
+            }
+        }
+        else if (keyword == "symbols") {
+            while (tokens >> token) {
+                manifest.back().symbols.insert(manifest_symbol(token));
+            }
+        }
+        else {
+            std::cerr << "Error: Unknown keyword " << keyword << " in " << filename << " line " << line_num << std::endl;
+            return false;
+        }
+    }
+
+    for (const auto& entry : manifest) {
+        for (const auto& need : entry.needs) {
+            if (std::none_of(manifest.begin(), manifest.end(),
+                    [&](const manifest_entry& other) { return other.name == need; })) {
+                std::cerr << "Error: Module " << entry.name << " needs " << need << " which is not in " << filename << std::endl;
+                return false;
+            }
+        }
+    }
 
     return true;
 }
+
+// Adds to the given modules all the modules they need, directly or indirectly
+static void add_needs(std::set<std::string>& needed, const std::vector<manifest_entry>& manifest) {
+    std::vector<std::string> pending(needed.begin(), needed.end());
+    while (!pending.empty()) {
+        std::string name = pending.back();
+        pending.pop_back();
+
+        for (const auto& entry : manifest) {
+            if (entry.name != name) {
+                continue;
+            }
+            for (const auto& need : entry.needs) {
+                if (needed.insert(need).second) {
+                    pending.push_back(need);
+                }
+            }
+        }
+    }
+}
+
+std::vector<std::string> modules_needed(const context_t& tab_ctx, const std::vector<manifest_entry>& manifest) {
+    std::set<std::string> symbols;
+    for (const auto& tabline : tab_ctx.tableau) {
+        if (tabline.formula) {
+            premise_symbols(symbols, tabline.formula);
+        }
+    }
+
+    // Modules defining a symbol of the problem
+    std::set<std::string> needed;
+    for (const auto& entry : manifest) {
+        if (std::any_of(entry.symbols.begin(), entry.symbols.end(),
+                [&](const std::string& symbol) { return symbols.count(symbol); })) {
+            needed.insert(entry.name);
+        }
+    }
+
+    // The facts of a module are only usable with the modules they are stated in terms of,
+    // and lines derived from them only involve symbols of those modules
+    add_needs(needed, manifest);
+
+    std::vector<std::string> modules;
+    for (const auto& entry : manifest) {
+        if (needed.count(entry.name)) {
+            modules.push_back(entry.name);
+        }
+    }
+
+    return modules;
+}
+
+std::set<std::string> undeclared_symbols(const context_t& module_ctx, const std::string& name,
+                                         const std::vector<manifest_entry>& manifest) {
+    std::set<std::string> symbols;
+    for (const auto& digest_entry : module_ctx.digest) {
+        for (const auto& item : digest_entry) {
+            premise_symbols(symbols, module_ctx.tableau[item.module_line_idx].formula);
+        }
+    }
+
+    // Equality is common to all theories rather than declared by a module
+    symbols.erase(std::string(precedenceTable[SYMBOL_EQUALS].unicode));
+
+    std::set<std::string> declaring = {name};
+    add_needs(declaring, manifest);
+    for (const auto& entry : manifest) {
+        if (declaring.count(entry.name)) {
+            for (const auto& symbol : entry.symbols) {
+                symbols.erase(symbol);
+            }
+        }
+    }
+
+    std::set<std::string> undeclared;
+    for (const auto& symbol : symbols) {
+        undeclared.insert(dat_symbol(symbol));
+    }
+
+    return undeclared;
+}
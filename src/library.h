@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <string>
+#include <set>
 
 // Existing includes and declarations
 #include "context.h"
@@ -10,4 +11,37 @@
 // Function declaration for loading library
 bool library_load(context_t& context, const std::string& base_str);
 
+// Premise selection in the style of SInE. Starting from the symbols of the tableau,
+// selects the library records triggered by them, then those triggered by the symbols
+// of the selected records and so on. Records of the loaded modules that are not
+// selected are dropped from the digests of this tableau. Rewrites are always kept.
+void select_premises(context_t& tab_ctx);
+
+// Puts back the library records select_premises dropped from the digests of the tableau,
+// so that they can be loaded by hand once an automatic proof attempt is over
+void restore_premises(context_t& tab_ctx);
+
+// Entry of the module manifest: a module, the symbols it defines and the modules whose
+// facts it is stated in terms of
+struct manifest_entry {
+    std::string name;
+    std::vector<std::string> needs;
+    std::set<std::string> symbols;
+};
+
+// Reads a manifest of modules. Each entry starts with a line "module <name>", followed
+// by optional lines "needs <module> ..." and "symbols <symbol> ...". Symbols are written
+// as in .dat files. Lines starting with # are comments.
+bool manifest_load(std::vector<manifest_entry>& manifest, const std::string& filename);
+
+// Returns the modules of the manifest that define a symbol of the tableau, together with
+// all the modules they need, in manifest order
+std::vector<std::string> modules_needed(const context_t& tab_ctx, const std::vector<manifest_entry>& manifest);
+
+// Returns the symbols of the facts of the given module that are declared in the manifest
+// neither by the module nor by the modules it needs, written as in .dat files. Problems
+// using only those symbols won't cause the module to be loaded.
+std::set<std::string> undeclared_symbols(const context_t& module_ctx, const std::string& name,
+                                         const std::vector<manifest_entry>& manifest);
+
 #endif // LIBRARY_H
@@ -0,0 +1,54 @@
+// mapped_file.cpp
+
+#include "mapped_file.h"
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+mapped_file::mapped_file(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        length = st.st_size;
+
+        // The rest of the last page of a mapping reads as zeros, which terminates the
+        // input. If the file fills its last page exactly there is no room for this.
+        size_t page_size = sysconf(_SC_PAGESIZE);
+        if (length % page_size != 0) {
+            void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data = static_cast<const char*>(addr);
+                mapped = true;
+            }
+        }
+    }
+
+    close(fd);
+
+    if (!mapped) {
+        std::ifstream infile(filename, std::ios::binary);
+        if (!infile) {
+            return;
+        }
+
+        std::ostringstream oss;
+        oss << infile.rdbuf();
+        contents = oss.str();
+
+        data = contents.c_str();
+        length = contents.size();
+    }
+}
+
+mapped_file::~mapped_file() {
+    if (mapped) {
+        munmap(const_cast<char*>(data), length);
+    }
+}
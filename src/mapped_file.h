@@ -0,0 +1,40 @@
+// mapped_file.h
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+// The whole contents of a file, terminated by a null character as the parser
+// expects. The file is memory mapped where possible, otherwise it is read in.
+class mapped_file {
+public:
+    explicit mapped_file(const std::string& filename);
+
+    ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    // Whether the file could be opened
+    bool is_open() const {
+        return data != nullptr;
+    }
+
+    const char* c_str() const {
+        return data;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::string contents; // Used if the file can't be mapped
+};
+
+#endif // MAPPED_FILE_H
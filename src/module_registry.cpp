@@ -0,0 +1,83 @@
+// module_registry.cpp
+
+#include "module_registry.h"
+#include "library.h"
+#include "mapped_file.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+
+// FNV-1a hash of the file contents
+static uint64_t content_hash(const mapped_file& file) {
+    uint64_t h = 14695981039346656037ULL;
+    const char* data = file.c_str();
+    for (size_t i = 0; i < file.size(); ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static std::mutex registry_mutex;
+static std::map<std::pair<std::string, uint64_t>, std::shared_ptr<const context_t>> registry;
+static std::map<std::string, std::shared_ptr<const context_t>> pinned; // Modules trusted without a check, by name
+
+void registry_pin() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    for (const auto& [key, module_ctx] : registry) {
+        pinned[key.first] = module_ctx;
+    }
+}
+
+std::shared_ptr<const context_t> registry_load(const std::string& filename_stem) {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        auto it = pinned.find(filename_stem);
+        if (it != pinned.end()) {
+            return it->second;
+        }
+    }
+
+    uint64_t hash;
+    {
+        mapped_file file(filename_stem + ".dat");
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename_stem << ".dat" << std::endl;
+            return nullptr;
+        }
+        hash = content_hash(file);
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    auto key = std::make_pair(filename_stem, hash);
+    auto it = registry.find(key);
+    if (it != registry.end()) {
+        return it->second;
+    }
+
+    auto module_ctx = std::make_shared<context_t>();
+    if (!library_load(*module_ctx, filename_stem)) {
+        return nullptr;
+    }
+    module_ctx->source_hash = hash;
+    module_ctx->get_constants(); // Populate constants
+    module_ctx->get_ltor(); // Compute whether implications are left-to-right and/or right-to-left applicable
+
+    // The module is shared once registered, so fill in the lazily computed annotations now
+    for (const auto& digest_entry : module_ctx->digest) {
+        for (const auto& item : digest_entry) {
+            const tabline_t& tabline = module_ctx->tableau[item.module_line_idx];
+            tabline.formula_info();
+            if (tabline.formula->children.size() == 2) {
+                tabline.side_info();
+            }
+        }
+    }
+
+    registry[key] = module_ctx;
+
+    return module_ctx;
+}
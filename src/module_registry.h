@@ -0,0 +1,21 @@
+// module_registry.h
+
+#ifndef MODULE_REGISTRY_H
+#define MODULE_REGISTRY_H
+
+#include "context.h"
+#include <memory>
+#include <string>
+
+// Returns the module stored in the .dat file with the given filename stem. Modules are
+// kept for the life of the process, keyed by name and a hash of the file contents, so
+// each version of a module is only loaded once however many tableaux use it. The
+// module is shared and must not be changed. Returns nullptr if it can't be loaded.
+std::shared_ptr<const context_t> registry_load(const std::string& filename_stem);
+
+// Makes registry_load return the modules already loaded without reading their files
+// again. The server calls this once it has loaded every module, so that the processes
+// it forks for requests don't each map and hash every .dat file.
+void registry_pin();
+
+#endif // MODULE_REGISTRY_H
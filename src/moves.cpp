@@ -2,6 +2,7 @@
 
 #include "moves.h"
 #include <set>
+#include <map>
 #include <algorithm>
 #include <vector>
 #include <stack>
@@ -29,7 +30,9 @@ node* parameterize(node* formula) {
 void parameterize_all(context_t& tab_ctx) {
     // Iterate through each tabline in the tableau
     if (!tab_ctx.parameterized) {
-        for (auto& tabline : tab_ctx.tableau) {
+        for (size_t i = 0; i < tab_ctx.tableau.size(); ++i) {
+            tabline_t& tabline = tab_ctx.tableau[i];
+
             // Only process active formulas
             if (tabline.active) {
                 // Apply parameterize to the formula
@@ -44,6 +47,7 @@ void parameterize_all(context_t& tab_ctx) {
                 } else {
                     parameterize(tabline.formula);
                 }
+                tab_ctx.formula_changed(i);
             }
         }
     }
@@ -113,9 +117,41 @@ node* skolemize(context_t& ctx, node* formula, const std::vector<std::string>& u
     return phi;
 }
 
+// Applies the substitution to the formula in place. If copy is not null it is set to a
+// copy of the result built in the same traversal.
+static void substitute_in_place(node*& formula, const Substitution& subst, node** copy) {
+    if (formula->type == VARIABLE) {
+        auto it = subst.find(formula->vdata->name);
+        if (it != subst.end()) {
+            delete formula;
+            formula = deep_copy(it->second);
+        }
+
+        if (copy != nullptr) {
+            *copy = deep_copy(formula);
+        }
+        return;
+    }
+
+    node* result = copy != nullptr ? new node(formula->type, formula->symbol) : nullptr;
+    for (node*& child : formula->children) {
+        node* child_copy;
+        substitute_in_place(child, subst, copy != nullptr ? &child_copy : nullptr);
+        if (result != nullptr) {
+            result->children.push_back(child_copy);
+        }
+    }
+
+    if (copy != nullptr) {
+        *copy = result;
+    }
+}
+
 // skolemize an arbitrary formula
 // original formula is destroyed
-node* skolem_form(context_t& ctx, node* formula) {
+// if copy is not null it is set to a second, independent copy of the result, built
+// while the substitution is applied rather than by copying the result afterwards
+node* skolem_form(context_t& ctx, node* formula, node** copy) {
     Substitution subst; // Initialize empty substitution map
     std::vector<std::string> universals; // List of universally quantified variables
     node* special_implications = nullptr; // implications coming from special quantifiers
@@ -178,56 +214,63 @@ node* skolem_form(context_t& ctx, node* formula) {
         formula = special_implications;
     }
 
-    if (!subst.empty()) {
-        // Apply all accumulated substitutions to the formula
-        node* skolemized_formula = substitute(formula, subst);
+    // Apply all accumulated substitutions to the formula
+    if (!subst.empty() || copy != nullptr) {
+        substitute_in_place(formula, subst, copy);
         cleanup_subst(subst);
-        delete formula;
-        
-        return skolemized_formula;
-    } else {
-        return formula;
     }
+
+    return formula;
 }
 
-bool skolemize_all(context_t& tab_ctx, size_t start) {
-    bool moved = false; // whether any move occurred
-    
-    for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
-        tabline_t& tabline = tab_ctx.tableau[i];
+// Skolemizes the formula on a single line, returns true if it was quantified
+static bool skolemize_line(context_t& tab_ctx, size_t i) {
+    tabline_t& tabline = tab_ctx.tableau[i];
 
-       // Only process active formulas
-        if (tabline.active && !tabline.is_theorem() && !tabline.is_definition()) {
-            bool quantified = unwrap_special(tabline.formula)->type == QUANTIFIER;
-            
-            // Apply skolem_form to the formula
-            node* skolemized = skolem_form(tab_ctx, tabline.formula);
-            
-            if (quantified) { // if anything changed
-                moved = true;
+    // Only process active formulas not already in skolem form
+    if (!tabline.active || tabline.skolemized || tabline.is_theorem() || tabline.is_definition()) {
+        return false;
+    }
 
-                // If the formula is a target, re-negate it
-                if (!tabline.target) {
-                    // Replace the original formula with the skolemized formula
-                    tabline.formula = disjunction_to_implication(skolemized);
-                } else {
-                    // Replace the original formula with the skolemized formula
-                    tabline.formula = skolemized;
+    // Once the quantifier prefix is removed the line needn't be looked at again
+    tabline.skolemized = true;
 
-                    // Delete existing negation to prevent memory leaks
-                    delete tabline.negation;
+    if (unwrap_special(tabline.formula)->type != QUANTIFIER) {
+        return false; // nothing to do
+    }
 
-                    // Create a deep copy of the skolemized formula
-                    node* formula_copy = deep_copy(tabline.formula);
+    if (!tabline.target) {
+        // Replace the original formula with the skolemized formula
+        node* skolemized = skolem_form(tab_ctx, tabline.formula);
+        tabline.formula = disjunction_to_implication(skolemized);
+    } else {
+        // Replace the original formula with the skolemized formula, getting
+        // a copy of it back from the same traversal to build the negation
+        node* formula_copy;
+        tabline.formula = skolem_form(tab_ctx, tabline.formula, &formula_copy);
 
-                    // Negate the copied formula
-                    node* negated = negate_node(formula_copy);
-                    negated = disjunction_to_implication(negated);
+        // Delete existing negation to prevent memory leaks
+        delete tabline.negation;
 
-                    // Assign the negated formula to the negation field
-                    tabline.negation = negated;
-                }
-            }
+        // Negate the copied formula
+        node* negated = negate_node(formula_copy);
+        negated = disjunction_to_implication(negated);
+
+        // Assign the negated formula to the negation field
+        tabline.negation = negated;
+    }
+
+    tab_ctx.formula_changed(i);
+
+    return true;
+}
+
+bool skolemize_all(context_t& tab_ctx, size_t start) {
+    bool moved = false; // whether any move occurred
+    
+    for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
+        if (skolemize_line(tab_ctx, i)) {
+            moved = true;
         }
     }
 
@@ -240,130 +283,148 @@ void cleanup_conjuncts(std::vector<node*> conjuncts) {
     conjuncts.clear();
 }
 
-node* modus_ponens(Substitution& combined_subst, context_t& ctx_var, node* implication, const std::vector<node*>& unit_clauses, bool silent) {
-    // 1. Verify that the first formula is an implication
-    if (!(implication->is_implication())) {
-        std::cerr << "Error: The first formula is not an implication." << std::endl;
-        return nullptr;
+// Records the first node of each individual variable in the formula by name
+static void individual_vars(std::map<std::string, const node*>& vars, const node* formula) {
+    if (formula->type == VARIABLE && formula->vdata->var_kind == INDIVIDUAL) {
+        vars.emplace(formula->vdata->name, formula);
     }
-
-    // 2. Deep copy the implication formula
-    node* implication_copy = deep_copy(implication);
-
-    // 3. Extract antecedent and consequent from the implication
-    node* antecedent = implication_copy->children[0];
-    node* consequent = implication_copy->children[1];
-
-    // 5. Collect all variables from conjuncts and unit clauses
-    std::set<std::string> vars_conjuncts;
-    vars_used(vars_conjuncts, implication, false);
-
-    std::set<std::string> vars_units;
-    for (const auto& unit : unit_clauses) {
-        vars_used(vars_units, unit, true);
+    for (const node* child : formula->children) {
+        individual_vars(vars, child);
     }
+}
 
-    // 6. Find common variables
-    std::set<std::string> common_vars;
-    std::set_intersection(
-        vars_conjuncts.begin(), vars_conjuncts.end(),
-        vars_units.begin(), vars_units.end(),
-        std::inserter(common_vars, common_vars.begin())
-    );
+// Binds the unassigned variables of the bank in the list to fresh variables named by
+// the renaming, so that they come out renamed apart from the other banks
+static void rename_bank(BankedSubstitution& subst, std::vector<node*>& fresh_vars, int bank,
+                        const std::map<std::string, const node*>& vars,
+                        const std::vector<std::pair<std::string, std::string>>& rename_list) {
+    for (const auto& [old_name, new_name] : rename_list) {
+        std::string key = std::to_string(bank) + ":" + old_name;
+        if (subst.find(key) != subst.end()) {
+            continue;
+        }
 
-    // If there are common variables, rename them in the entire implication_copy
-    if (!common_vars.empty()) {
-        // Create a rename list based on common variables
-        std::vector<std::pair<std::string, std::string>> rename_list = vars_rename_list(ctx_var, common_vars);
+        node* fresh = deep_copy(vars.at(old_name));
+        fresh->set_name(new_name);
+        fresh_vars.push_back(fresh);
+        subst[key] = {fresh, -1}; // No variable is ever bound in bank -1
+    }
+}
 
-        // Rename variables in the entire implication_copy
-        rename_vars(implication_copy, rename_list);
+node* modus_ponens(Substitution& combined_subst, context_t& ctx_var, node* implication, const std::vector<node*>& unit_clauses, bool silent,
+                   std::vector<std::pair<node*, int>>* specials) {
+    // 1. Verify that the first formula is an implication
+    if (!(implication->is_implication())) {
+        std::cerr << "Error: The first formula is not an implication." << std::endl;
+        return nullptr;
     }
 
-    // 4. Flatten antecedent into a list of conjuncts
+    // 2. Flatten antecedent into a list of conjuncts
     std::vector<node*> conjuncts;
-    conjuncts = conjunction_to_list(antecedent);
+    node* current = implication->children[0];
+    while (current->is_conjunction()) {
+        conjuncts.push_back(current->children[1]);
+        current = current->children[0];
+    }
+    conjuncts.push_back(current);
+    std::reverse(conjuncts.begin(), conjuncts.end());
 
-    // 7. Verify that the number of unit clauses matches the number of conjuncts
+    // 3. Verify that the number of unit clauses matches the number of conjuncts
     if (unit_clauses.size() != conjuncts.size()) {
         if (!silent) {
             std::cerr << "Error: Number of unit clauses (" << unit_clauses.size()
                   << ") does not match number of antecedent conjuncts (" << conjuncts.size() << ")." << std::endl;
         }
-        cleanup_conjuncts(conjuncts);
-        delete implication_copy;
         return nullptr;
     }
 
-    // 8. Collect all substitutions
+    // 4. Unify each conjunct with its unit clause, with the implication in bank 0 and
+    // unit clause i in bank i + 1, so that variables of different lines are distinct
+    // without copying and renaming
+    BankedSubstitution subst;
     for (size_t i = 0; i < conjuncts.size(); ++i) {
-        node* conjunct = conjuncts[i];
-        node* unit = unit_clauses[i];
-
-        // e. Unify the renamed conjunct with the unit clause
-        Substitution subst;
-        std::optional<Substitution> maybe_subst = unify(conjunct, unit, subst);
-        if (!maybe_subst.has_value()) {
+        if (!unify_banks(conjuncts[i], 0, unit_clauses[i], i + 1, subst).has_value()) {
             if (!silent) {
                 std::cerr << "Error: Unification failed between conjunct " << (i + 1) << " and unit clause." << std::endl;
-                std::cerr << "Conjunct: " << conjunct->to_string(UNICODE) 
-                          << " | Unit Clause: " << unit->to_string(UNICODE) << std::endl;
+                std::cerr << "Conjunct: " << conjuncts[i]->to_string(UNICODE)
+                          << " | Unit Clause: " << unit_clauses[i]->to_string(UNICODE) << std::endl;
             }
-            cleanup_conjuncts(conjuncts);
-            delete implication_copy;
             return nullptr;
         }
+    }
 
-        // f. Combine substitutions, ensuring no conflicts
-        for (const auto& [key, value] : maybe_subst.value()) {
-            // Check if the variable already has a substitution
-            auto it = combined_subst.find(key);
-            if (it != combined_subst.end()) {
-                if (it->second->to_string(REPR) != value->to_string(REPR)) {
-                    if (!silent) {
-                        std::cerr << "Error: Conflicting substitutions for variable '" << key << "'." << std::endl;
-                    }
-                    cleanup_conjuncts(conjuncts);
-                    delete implication_copy;
-                    return nullptr;
-                }
-                // Else, same substitution; no action needed
-            }
-            else {
-                // Add the substitution to the combined substitution
-                node* value_copy = deep_copy(value); // Deep copy to own the substitution
+    // 5. Variables left unassigned keep their names, except that variables of the
+    // implication that also occur in a unit clause, and variables of a unit clause that
+    // occur in an earlier one, are renamed apart
+    std::vector<node*> fresh_vars;
+    std::map<std::string, const node*> impl_vars;
+    individual_vars(impl_vars, implication);
+
+    std::set<std::string> vars_units;
+    for (const auto& unit : unit_clauses) {
+        vars_used(vars_units, unit, true);
+    }
+
+    std::set<std::string> common_vars;
+    for (const auto& [name, var] : impl_vars) {
+        if (vars_units.count(name)) {
+            common_vars.insert(name);
+        }
+    }
+
+    if (!common_vars.empty()) {
+        rename_bank(subst, fresh_vars, 0, impl_vars, vars_rename_list(ctx_var, common_vars));
+    }
 
-                combined_subst[key] = value_copy; // Store the deep copy
+    std::set<std::string> vars_earlier;
+    for (size_t i = 0; i < unit_clauses.size(); ++i) {
+        std::map<std::string, const node*> unit_vars;
+        individual_vars(unit_vars, unit_clauses[i]);
+
+        std::set<std::string> repeated;
+        for (const auto& [name, var] : unit_vars) {
+            bool bound = subst.count(std::to_string(i + 1) + ":" + name) != 0;
+            if (!var->is_shared_variable() && !vars_earlier.insert(name).second && !bound) {
+                repeated.insert(name);
             }
         }
+
+        if (!repeated.empty()) {
+            rename_bank(subst, fresh_vars, i + 1, unit_vars, vars_rename_list(ctx_var, repeated));
+        }
+    }
+
+    // 6. The substitution made to the variables of the implication
+    for (const auto& [key, value] : subst) {
+        if (key.compare(0, 2, "0:") == 0 && value.second != -1) {
+            combined_subst[key.substr(2)] = substitute_banks(value.first, value.second, subst);
+        }
     }
 
-    // g. Clean up the conjuncts
-    cleanup_conjuncts(conjuncts);
+    // 7. Substitute the consequent and the special predicates, each in the bank of the
+    // line it was peeled off
+    node* substituted_consequent = substitute_banks(implication->children[1], 0, subst);
 
-    // 9. Substitute the consequent with the combined substitution
-    node* substituted_consequent = substitute(consequent, combined_subst);
-    if (!substituted_consequent) {
-        if (!silent) {
-            std::cerr << "Error: Substitution failed on the consequent." << std::endl;
+    if (specials) {
+        for (auto& [special, bank] : *specials) {
+            special = substitute_banks(special, bank, subst);
         }
-        // Clean up and exit
-        delete implication_copy;
-        return nullptr;
     }
-    
-    // 10. Clean up combined_subst and implication_copy
-    delete implication_copy;
+
+    for (node* fresh : fresh_vars) {
+        delete fresh;
+    }
 
     return substituted_consequent;
 }
 
-node* modus_tollens(Substitution& combined_subst, context_t& ctx_var, node* implication, const std::vector<node*>& unit_clauses, bool silent) {
+node* modus_tollens(Substitution& combined_subst, context_t& ctx_var, node* implication, const std::vector<node*>& unit_clauses, bool silent,
+                    std::vector<std::pair<node*, int>>* specials) {
     // 1. Negate the implication: A -> B becomes ¬B -> ¬A
     node* negated_implication = contrapositive(implication);
 
     // 2. Apply modus ponens with the negated implication and the provided unit clauses
-    node* result = modus_ponens(combined_subst, ctx_var, negated_implication, unit_clauses, silent);
+    node* result = modus_ponens(combined_subst, ctx_var, negated_implication, unit_clauses, silent, specials);
 
     // 3. Clean up the negated implication
     delete negated_implication;
@@ -388,10 +449,13 @@ bool move_mpt(context_t& ctx, int implication_line, const std::vector<int>& othe
         return false;
     }
 
-    // list of special predicates peeled off implication and units
+    // list of special predicates peeled off implication and units, with the bank of the
+    // line each came from in the unification, 0 for the implication and i + 1 for unit i
     std::vector<node*> special_predicates;
+    std::vector<int> special_banks;
 
     node* implication = split_special(special_predicates, implication_tabline.formula);
+    special_banks.resize(special_predicates.size(), 0);
     if (!implication->is_implication()) {
         std::cerr << "Error: Line " << implication_line + 1 << " does not contain a valid implication.\n";
         return false;
@@ -446,6 +510,7 @@ bool move_mpt(context_t& ctx, int implication_line, const std::vector<int>& othe
     std::vector<node*> unit_clauses;
     for (int line : other_lines) {
         node* clause = split_special(special_predicates, ctx.tableau[line].formula);
+        special_banks.resize(special_predicates.size(), unit_clauses.size() + 1);
         unit_clauses.push_back(clause);
     }
 
@@ -453,14 +518,18 @@ bool move_mpt(context_t& ctx, int implication_line, const std::vector<int>& othe
     node* result = nullptr;
     Reason justification_reason;
     Substitution subst;
+    std::vector<std::pair<node*, int>> specials;
+    for (size_t i = 0; i < special_predicates.size(); ++i) {
+        specials.emplace_back(special_predicates[i], special_banks[i]);
+    }
 
     if (forward ^ !ponens) {
         // Apply modus ponens
-        result = modus_ponens(subst, ctx, implication, unit_clauses, silent);
+        result = modus_ponens(subst, ctx, implication, unit_clauses, silent, &specials);
     }
     else {
         // Apply modus tollens
-        result = modus_tollens(subst, ctx, implication, unit_clauses, silent);
+        result = modus_tollens(subst, ctx, implication, unit_clauses, silent, &specials);
     }
 
     justification_reason = (ponens ? Reason::ModusPonens : Reason::ModusTollens);
@@ -475,9 +544,9 @@ bool move_mpt(context_t& ctx, int implication_line, const std::vector<int>& othe
         return false;
     }
 
-    // Step 8: Apply substitutions to special predicates
+    // Step 8: Take the special predicates with the substitutions applied
     for (size_t i = 0; i < special_predicates.size(); ++i) {
-        special_predicates[i] = substitute(deep_copy(special_predicates[i]), subst);
+        special_predicates[i] = specials[i].first;
     }
     
     // Step 9: Check special predicates against supplied list
@@ -515,6 +584,7 @@ bool move_mpt(context_t& ctx, int implication_line, const std::vector<int>& othe
         }
         special_predicates.clear();
         cleanup_subst(subst);
+        delete result;
 
         return false;
     }
@@ -543,7 +613,7 @@ bool move_mpt(context_t& ctx, int implication_line, const std::vector<int>& othe
         std::string special_str = special->to_string(UNICODE);
 
         // Check we don't already have this special predicate
-        if (special_strings.find(special_str) != vars.end()) {
+        if (special_strings.find(special_str) != special_strings.end()) {
             delete special;
             continue;
         } else {
@@ -615,27 +685,27 @@ bool move_mpt(context_t& ctx, int implication_line, const std::vector<int>& othe
     return true;
 }
 
-// Recursive function to traverse the formula tree, find a subformula that unifies with P,
+// Recursive function to traverse the formula tree, find a subterm that matches P,
 // apply the substitution, replace it with Q_prime, and merge the substitution into combined_subst.
 // Returns true if a replacement was made; otherwise, false.
 bool rewrite(Substitution& combined_subst, node*& current, node* P, node* Q) {
-    // Local substitution for the current unification attempt
+    // Local substitution for the current matching attempt
     Substitution local_subst;
 
-    // Attempt to unify P with the current node
-    if (unify(P, current, local_subst)) {
-        // Apply substitution to Q to get Q_prime
+    // Attempt to match P against the current node, only variables of P are assigned
+    if (current->is_term() && match(P, current, local_subst)) {
+        // Apply substitution to Q to get Q_prime, the rule itself is left intact
         node* Q_prime = substitute(Q, local_subst);
 
+        // Merge local_subst into combined_subst, the bindings point into current
+        for (const auto& [key, value] : local_subst) {
+            combined_subst[key] = deep_copy(value);
+        }
+
         // Replace the current node with Q_prime
         delete current;       // Free the memory of the current node
         current = Q_prime;    // Assign Q_prime to the current node pointer
 
-        // Merge local_subst into combined_subst
-        for (const auto& [key, value] : local_subst) {
-            combined_subst[key] = value;
-        }
-
         return true;          // Indicate that a replacement has been made
     }
 
@@ -733,6 +803,7 @@ bool move_rewrite(context_t& ctx, int formula_line, int rewrite_line, bool silen
 
     // Traverse formula_copy, find a subformula that unifies with P, apply substitution, and replace it with Q'.
     bool replaced = rewrite(combined_subst, formula_copy, P, Q);
+    cleanup_subst(combined_subst);
 
     if (!replaced) {
         if (!silent) {
@@ -770,6 +841,105 @@ bool move_rewrite(context_t& ctx, int formula_line, int rewrite_line, bool silen
     return true;
 }
 
+// Function to rewrite a formula (hypothesis or target) to normal form using all of
+// the given rewrite rules of the form P = Q at once.
+bool move_normalise(context_t& ctx, int formula_line, const std::vector<int>& rewrite_lines, bool silent) {
+    // Step 1: Validate line indices.
+    if (formula_line < 0 || formula_line >= static_cast<int>(ctx.tableau.size())) {
+        std::cerr << "Error: formula_line " << (formula_line + 1) << " is out of bounds.\n";
+        return false;
+    }
+
+    tabline_t& formula_tabline = ctx.tableau[formula_line];
+
+    if (!formula_tabline.active) {
+        std::cerr << "Error: formula_line " << (formula_line + 1) << " is not active.\n";
+        return false;
+    }
+
+    // Step 2: Index the usable rules by the head symbol of their left sides.
+    rewrite_index index;
+
+    for (int rewrite_line : rewrite_lines) {
+        if (rewrite_line < 0 || rewrite_line >= static_cast<int>(ctx.tableau.size())) {
+            std::cerr << "Error: rewrite_line " << (rewrite_line + 1) << " is out of bounds.\n";
+            return false;
+        }
+
+        tabline_t& rewrite_tabline = ctx.tableau[rewrite_line];
+        node* rewrite_formula = rewrite_tabline.formula;
+
+        if (rewrite_tabline.target || !rewrite_formula->is_equality()) {
+            if (!silent) {
+                std::cerr << "Error: rewrite_line " << (rewrite_line + 1) << " is not an equality hypothesis P = Q.\n";
+            }
+            continue;
+        }
+
+        // Rules with incompatible assumptions or restrictions can't be used together with the formula
+        if (!assumptions_compatible(formula_tabline.assumptions, rewrite_tabline.assumptions) ||
+            !restrictions_compatible(formula_tabline.restrictions, rewrite_tabline.restrictions)) {
+            continue;
+        }
+
+        index.add_rule(rewrite_formula->children[0], rewrite_formula->children[1], rewrite_line);
+    }
+
+    if (index.empty()) {
+        if (!silent) {
+            std::cerr << "Error: No usable rewrite rules.\n";
+        }
+        return false;
+    }
+
+    // Step 3: Normalise a copy of the formula.
+    std::vector<int> used_lines;
+    node* formula_copy = index.normalise(deep_copy(formula_tabline.formula), used_lines);
+
+    if (!formula_copy) {
+        if (!silent) {
+            std::cerr << "Error: Rewriting of formula_line " << (formula_line + 1) << " does not terminate.\n";
+        }
+        return false;
+    }
+
+    if (used_lines.empty()) {
+        if (!silent) {
+            std::cerr << "Error: No subterm in formula_line " << (formula_line + 1)
+                      << " matches the left side of a rewrite rule.\n";
+        }
+        delete formula_copy;
+        return false;
+    }
+
+    // Step 4: Create a new tabline with the rewritten formula.
+    tabline_t new_tabline(formula_copy);
+
+    if (formula_tabline.target) {
+        node* negated_formula = negate_node(deep_copy(formula_copy));
+        negated_formula = disjunction_to_implication(negated_formula);
+
+        new_tabline.negation = negated_formula;
+    }
+
+    // Step 5: Update assumptions, restrictions and justification.
+    new_tabline.assumptions = formula_tabline.assumptions;
+    new_tabline.restrictions = formula_tabline.restrictions;
+    for (int rewrite_line : used_lines) {
+        new_tabline.assumptions = combine_assumptions(new_tabline.assumptions, ctx.tableau[rewrite_line].assumptions);
+        new_tabline.restrictions = combine_restrictions(new_tabline.restrictions, ctx.tableau[rewrite_line].restrictions);
+    }
+    used_lines.insert(used_lines.begin(), formula_line);
+    new_tabline.justification = { Reason::EqualitySubst, used_lines };
+
+    // Step 6: Add the new tabline to the tableau.
+    ctx.tableau.push_back(new_tabline);
+
+    ctx.rewrite++;
+
+    return true;
+}
+
 // Function to check for Disjunctive Idempotence: P ∨ P
 bool disjunctive_idempotence(const node* formula) {
     // Ensure the formula is a logical binary operation with OR symbol
@@ -815,1052 +985,1083 @@ bool conjunctive_idempotence(const node* formula) {
     return equal(left, right);
 }
 
-bool move_di(context_t& tab_ctx, size_t start) {
+static bool move_di_line(context_t& tab_ctx, size_t i) {
     bool moved = false;
-    size_t i = start;
 
-    while (i < tab_ctx.tableau.size()) {
-        tabline_t& tabline = tab_ctx.tableau[i];
+    tabline_t& tabline = tab_ctx.tableau[i];
 
-        if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
-            i++;
-            continue;
-        }
+    if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
+        return false;
+    }
 
-        std::vector<node*> special_predicates;
-        node* formula = split_special(special_predicates, tabline.formula);
-    
-        // Check if the formula is a disjunctive idempotent
-        if ((tabline.target && conjunctive_idempotence(formula))
-            || (!tabline.target && disjunctive_idempotence(formula))
-            || (!tabline.target && implicative_idempotence(formula))) {
-            // Formula is of the form P ∨ P or P ∧ P
+    std::vector<node*> special_predicates;
+    node* formula = split_special(special_predicates, tabline.formula);
 
-            // Increment count of cleanup moves
-            tab_ctx.cleanup++;
-        
-            // **Critical Fix: Set flags before modifying the vector**
-            // Mark the original conjunction/disjunction as inactive and dead
-            tabline.active = false;
-            tabline.dead = true;
+    // Check if the formula is a disjunctive idempotent
+    if ((tabline.target && conjunctive_idempotence(formula))
+        || (!tabline.target && disjunctive_idempotence(formula))
+        || (!tabline.target && implicative_idempotence(formula))) {
+        // Formula is of the form P ∨ P or P ∧ P
 
-            // Store the original formula node and its children
-            node* original_formula = formula;
-            node* P = original_formula->children[1];
+        // Increment count of cleanup moves
+        tab_ctx.cleanup++;
+    
+        // **Critical Fix: Set flags before modifying the vector**
+        // Mark the original conjunction/disjunction as inactive and dead
+        tab_ctx.kill_line(i);
 
-            if (!tabline.target) {
-                P = reapply_special(special_predicates, deep_copy(P));
+        // Store the original formula node and its children
+        node* original_formula = formula;
+        node* P = original_formula->children[1];
 
-                // Original is a hypothesis, new tablines are hypotheses
-                tabline_t new_tabline_P(P);
-                
-                // Copy restrictions and assumptions
-                new_tabline_P.assumptions = tabline.assumptions;
-                new_tabline_P.restrictions = tabline.restrictions;
-                
-                // Set justification to DisjunctiveIdempotence or ConjunctiveIdempotence
-                Reason justification = formula->is_disjunction() ? Reason::DisjunctiveIdempotence : Reason::ConjunctiveIdempotence;
-                new_tabline_P.justification = { justification, { static_cast<int>(i) } };
-                
-                // Append new hypotheses to the tableau
-                tab_ctx.tableau.push_back(new_tabline_P);
-            }
-            else {
-                // Original is a target, new tablines are targets
-                node* neg_P = negate_node(deep_copy(P), true);
-                neg_P = reapply_special(special_predicates, neg_P);
-                node* new_P = reapply_special(special_predicates, deep_copy(P));
-                
-                tabline_t new_tabline_P(new_P, neg_P);
+        if (!tabline.target) {
+            P = reapply_special(special_predicates, deep_copy(P));
 
-                // Copy restrictions and assumptions
-                new_tabline_P.assumptions = tabline.assumptions;
-                new_tabline_P.restrictions = tabline.restrictions;
-                
-                // Set justification to DisjunctiveIdempotence or ConjunctiveIdempotence
-                Reason justification = formula->is_disjunction() ? Reason::DisjunctiveIdempotence : Reason::ConjunctiveIdempotence;
-                new_tabline_P.justification = { justification, { static_cast<int>(i) } };
+            // Original is a hypothesis, new tablines are hypotheses
+            tabline_t new_tabline_P(P);
+            
+            // Copy restrictions and assumptions
+            new_tabline_P.assumptions = tabline.assumptions;
+            new_tabline_P.restrictions = tabline.restrictions;
+            
+            // Set justification to DisjunctiveIdempotence or ConjunctiveIdempotence
+            Reason justification = formula->is_disjunction() ? Reason::DisjunctiveIdempotence : Reason::ConjunctiveIdempotence;
+            new_tabline_P.justification = { justification, { static_cast<int>(i) } };
+            
+            // Append new hypotheses to the tableau
+            tab_ctx.tableau.push_back(new_tabline_P);
+        }
+        else {
+            // Original is a target, new tablines are targets
+            node* neg_P = negate_node(deep_copy(P), true);
+            neg_P = reapply_special(special_predicates, neg_P);
+            node* new_P = reapply_special(special_predicates, deep_copy(P));
+            
+            tabline_t new_tabline_P(new_P, neg_P);
 
-                // Append new targets to the tableau
-                tab_ctx.tableau.push_back(new_tabline_P);
+            // Copy restrictions and assumptions
+            new_tabline_P.assumptions = tabline.assumptions;
+            new_tabline_P.restrictions = tabline.restrictions;
+            
+            // Set justification to DisjunctiveIdempotence or ConjunctiveIdempotence
+            Reason justification = formula->is_disjunction() ? Reason::DisjunctiveIdempotence : Reason::ConjunctiveIdempotence;
+            new_tabline_P.justification = { justification, { static_cast<int>(i) } };
 
-                // Replace hydra
-                tab_ctx.hydra_replace(i, tab_ctx.tableau.size() - 1);
-                tab_ctx.restrictions_replace(i, tab_ctx.tableau.size() - 1);
-                tab_ctx.select_targets();
-            }
+            // Append new targets to the tableau
+            tab_ctx.tableau.push_back(new_tabline_P);
 
-            moved = true;
+            // Replace hydra
+            tab_ctx.hydra_replace(i, tab_ctx.tableau.size() - 1);
+            tab_ctx.restrictions_replace(i, tab_ctx.tableau.size() - 1);
+            tab_ctx.select_targets();
         }
 
-        special_predicates.clear();
-
-        i++;
+        moved = true;
     }
 
+    special_predicates.clear();
+
     return moved;
 }
 
-bool move_ci(context_t& tab_ctx, size_t start) {
+bool move_di(context_t& tab_ctx, size_t start) {
     bool moved = false;
-    size_t i = start;
-
-    while (i < tab_ctx.tableau.size()) {
-        tabline_t& tabline = tab_ctx.tableau[i];
 
-        if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
-            i++;
-            continue;
+    for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
+        if (move_di_line(tab_ctx, i)) {
+            moved = true;
         }
+    }
 
-        std::vector<node*> special_predicates;
-        node* formula = split_special(special_predicates, tabline.formula);
-    
-        // Check if the formula is a conjunctive idempotent
-        if ((tabline.target && disjunctive_idempotence(formula))
-            || (!tabline.target && conjunctive_idempotence(formula))) {
-            // Formula is of the form P ∧ P or P ∨ P
+    return moved;
+}
 
-            // Increment count of cleanup moves
-            tab_ctx.cleanup++;
-            
-            // **Critical Fix: Set flags before modifying the vector**
-            // Mark the original conjunction/disjunction as inactive and dead
-            tabline.active = false;
-            tabline.dead = true;
+static bool move_ci_line(context_t& tab_ctx, size_t i) {
+    bool moved = false;
 
-            // Store the original formula node and its children
-            node* original_formula = formula;
-            node* P = original_formula->children[0];
+    tabline_t& tabline = tab_ctx.tableau[i];
 
-            if (!tabline.target) {
-                P = reapply_special(special_predicates, deep_copy(P));
+    if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
+        return false;
+    }
 
-                // Original is a hypothesis, new tablines are hypotheses
-                tabline_t new_tabline_P(P);
-                
-                // Copy restrictions and assumptions
-                new_tabline_P.assumptions = tabline.assumptions;
-                new_tabline_P.restrictions = tabline.restrictions;
-                
-                // Set justification to ConjunctiveIdempotence or DisjunctiveIdempotence
-                Reason justification = formula->is_conjunction() ? Reason::ConjunctiveIdempotence : Reason::DisjunctiveIdempotence;
-                new_tabline_P.justification = { justification, { static_cast<int>(i) } };
-                
-                // Append new hypotheses to the tableau
-                tab_ctx.tableau.push_back(new_tabline_P);
-            }
-            else {
-                // Original is a target, new tablines are targets
-                node* new_P = reapply_special(special_predicates, deep_copy(P));
-                node* neg_P = negate_node(deep_copy(P), true);
-                neg_P = reapply_special(special_predicates, neg_P);
+    std::vector<node*> special_predicates;
+    node* formula = split_special(special_predicates, tabline.formula);
 
-                tabline_t new_tabline_P(new_P, neg_P);
+    // Check if the formula is a conjunctive idempotent
+    if ((tabline.target && disjunctive_idempotence(formula))
+        || (!tabline.target && conjunctive_idempotence(formula))) {
+        // Formula is of the form P ∧ P or P ∨ P
 
-                // Copy restrictions and assumptions
-                new_tabline_P.assumptions = tabline.assumptions;
-                new_tabline_P.restrictions = tabline.restrictions;
-                
-                // Set justification to ConjunctiveIdempotence or DisjunctiveIdempotence
-                Reason justification = formula->is_conjunction() ? Reason::ConjunctiveIdempotence : Reason::DisjunctiveIdempotence;
-                new_tabline_P.justification = { justification, { static_cast<int>(i) } };
+        // Increment count of cleanup moves
+        tab_ctx.cleanup++;
+        
+        // **Critical Fix: Set flags before modifying the vector**
+        // Mark the original conjunction/disjunction as inactive and dead
+        tab_ctx.kill_line(i);
 
-                // Append new targets to the tableau
-                tab_ctx.tableau.push_back(new_tabline_P);
-                
-                // Replace hydra
-                tab_ctx.hydra_replace(i, tab_ctx.tableau.size() - 1);
-                tab_ctx.restrictions_replace(i, tab_ctx.tableau.size() - 1);
-                tab_ctx.select_targets();
-            }
+        // Store the original formula node and its children
+        node* original_formula = formula;
+        node* P = original_formula->children[0];
 
-            moved = true;
+        if (!tabline.target) {
+            P = reapply_special(special_predicates, deep_copy(P));
+
+            // Original is a hypothesis, new tablines are hypotheses
+            tabline_t new_tabline_P(P);
+            
+            // Copy restrictions and assumptions
+            new_tabline_P.assumptions = tabline.assumptions;
+            new_tabline_P.restrictions = tabline.restrictions;
+            
+            // Set justification to ConjunctiveIdempotence or DisjunctiveIdempotence
+            Reason justification = formula->is_conjunction() ? Reason::ConjunctiveIdempotence : Reason::DisjunctiveIdempotence;
+            new_tabline_P.justification = { justification, { static_cast<int>(i) } };
+            
+            // Append new hypotheses to the tableau
+            tab_ctx.tableau.push_back(new_tabline_P);
         }
+        else {
+            // Original is a target, new tablines are targets
+            node* new_P = reapply_special(special_predicates, deep_copy(P));
+            node* neg_P = negate_node(deep_copy(P), true);
+            neg_P = reapply_special(special_predicates, neg_P);
 
-        special_predicates.clear();
+            tabline_t new_tabline_P(new_P, neg_P);
+
+            // Copy restrictions and assumptions
+            new_tabline_P.assumptions = tabline.assumptions;
+            new_tabline_P.restrictions = tabline.restrictions;
+            
+            // Set justification to ConjunctiveIdempotence or DisjunctiveIdempotence
+            Reason justification = formula->is_conjunction() ? Reason::ConjunctiveIdempotence : Reason::DisjunctiveIdempotence;
+            new_tabline_P.justification = { justification, { static_cast<int>(i) } };
+
+            // Append new targets to the tableau
+            tab_ctx.tableau.push_back(new_tabline_P);
+            
+            // Replace hydra
+            tab_ctx.hydra_replace(i, tab_ctx.tableau.size() - 1);
+            tab_ctx.restrictions_replace(i, tab_ctx.tableau.size() - 1);
+            tab_ctx.select_targets();
+        }
 
-        i++;
+        moved = true;
     }
 
+    special_predicates.clear();
+
     return moved;
 }
 
-// Split conjunctions
-bool move_sc(context_t& tab_ctx, size_t start) {
+bool move_ci(context_t& tab_ctx, size_t start) {
     bool moved = false;
-    size_t i = start;
-
-    // Optional: Reserve capacity to prevent reallocations
-    size_t expected_additions = tab_ctx.tableau.size() - start;
-    tab_ctx.tableau.reserve(tab_ctx.tableau.size() + expected_additions * 2); // Adjust based on expected splits
-
-    while (i < tab_ctx.tableau.size()) {
-        tabline_t& tabline = tab_ctx.tableau[i];
 
-        // Skip theorems and definitions
-        if (tabline.is_theorem() || tabline.is_definition()) {
-            i++;
-            continue;
+    for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
+        if (move_ci_line(tab_ctx, i)) {
+            moved = true;
         }
+    }
 
-        std::vector<node*> special_predicates;
-        node* formula = split_special(special_predicates, tabline.formula);
+    return moved;
+}
 
-        // Check if the formula is active and a conjunction or disjunction
-        if (tabline.active && ((!tabline.target && formula->is_conjunction()) ||
-            (tabline.target && formula->is_disjunction()))) {
-            
-            // Increment count of cleanup moves
-            tab_ctx.cleanup++;
-        
-            // Mark the original conjunction as inactive and dead BEFORE modifying the vector
-            tabline.active = false;
-            tabline.dead = true;
+// Split conjunctions
+static bool move_sc_line(context_t& tab_ctx, size_t i) {
+    bool moved = false;
 
-            // Proceed with splitting the conjunction/disjunction
-            node* P = formula->children[0];
-            node* Q = formula->children[1];
+    tabline_t& tabline = tab_ctx.tableau[i];
 
-            if (!tabline.target) {
-                // Original is a hypothesis, new tablines are hypotheses
-                P = reapply_special(special_predicates, deep_copy(P));
-                Q = reapply_special(special_predicates, deep_copy(Q));
+    // Skip theorems and definitions
+    if (tabline.is_theorem() || tabline.is_definition()) {
+        return false;
+    }
 
-                tabline_t new_tabline_P(P);
-                tabline_t new_tabline_Q(Q);
+    std::vector<node*> special_predicates;
+    node* formula = split_special(special_predicates, tabline.formula);
 
-                new_tabline_P.assumptions = tabline.assumptions;
-                new_tabline_P.restrictions = tabline.restrictions;
-                new_tabline_Q.assumptions = tabline.assumptions;
-                new_tabline_Q.restrictions = tabline.restrictions;
-                
-                // Set justification to SplitConjunction
-                new_tabline_P.justification = { Reason::SplitConjunction, { static_cast<int>(i) } };
-                new_tabline_Q.justification = { Reason::SplitConjunction, { static_cast<int>(i) } };
+    // Check if the formula is active and a conjunction or disjunction
+    if (tabline.active && ((!tabline.target && formula->is_conjunction()) ||
+        (tabline.target && formula->is_disjunction()))) {
+        
+        // Increment count of cleanup moves
+        tab_ctx.cleanup++;
+    
+        // Mark the original conjunction as inactive and dead BEFORE modifying the vector
+        tab_ctx.kill_line(i);
 
-                // Append new hypotheses to the tableau
-                tab_ctx.tableau.push_back(new_tabline_P);
-                tab_ctx.tableau.push_back(new_tabline_Q);
-            }
-            else {
-                // Original is a target, new tablines are targets
-                node* neg_P = negate_node(deep_copy(P), true);
-                node* neg_Q = negate_node(deep_copy(Q), true);
+        // Proceed with splitting the conjunction/disjunction
+        node* P = formula->children[0];
+        node* Q = formula->children[1];
+
+        if (!tabline.target) {
+            // Original is a hypothesis, new tablines are hypotheses
+            P = reapply_special(special_predicates, deep_copy(P));
+            Q = reapply_special(special_predicates, deep_copy(Q));
 
-                neg_P = reapply_special(special_predicates, neg_P);
-                neg_Q = reapply_special(special_predicates, neg_Q);
+            tabline_t new_tabline_P(P);
+            tabline_t new_tabline_Q(Q);
 
-                node* new_P = reapply_special(special_predicates, deep_copy(P));
-                node* new_Q = reapply_special(special_predicates, deep_copy(Q));
+            new_tabline_P.assumptions = tabline.assumptions;
+            new_tabline_P.restrictions = tabline.restrictions;
+            new_tabline_Q.assumptions = tabline.assumptions;
+            new_tabline_Q.restrictions = tabline.restrictions;
+            
+            // Set justification to SplitConjunction
+            new_tabline_P.justification = { Reason::SplitConjunction, { static_cast<int>(i) } };
+            new_tabline_Q.justification = { Reason::SplitConjunction, { static_cast<int>(i) } };
 
-                tabline_t new_tabline_P(new_P, neg_P);
-                tabline_t new_tabline_Q(new_Q, neg_Q);
+            // Append new hypotheses to the tableau
+            tab_ctx.tableau.push_back(new_tabline_P);
+            tab_ctx.tableau.push_back(new_tabline_Q);
+        }
+        else {
+            // Original is a target, new tablines are targets
+            node* neg_P = negate_node(deep_copy(P), true);
+            node* neg_Q = negate_node(deep_copy(Q), true);
 
-                // Copy restrictions and assumptions
-                new_tabline_P.assumptions = tabline.assumptions;
-                new_tabline_P.restrictions = tabline.restrictions;
-                new_tabline_Q.assumptions = tabline.assumptions;
-                new_tabline_Q.restrictions = tabline.restrictions;
-                
-                // Set justification to SplitConjunction
-                new_tabline_P.justification = { Reason::SplitConjunction, { static_cast<int>(i) } };
-                new_tabline_Q.justification = { Reason::SplitConjunction, { static_cast<int>(i) } };
+            neg_P = reapply_special(special_predicates, neg_P);
+            neg_Q = reapply_special(special_predicates, neg_Q);
 
-                // Append new targets to the tableau
-                tab_ctx.tableau.push_back(new_tabline_P);
-                tab_ctx.tableau.push_back(new_tabline_Q);
+            node* new_P = reapply_special(special_predicates, deep_copy(P));
+            node* new_Q = reapply_special(special_predicates, deep_copy(Q));
 
-                // Split the hydra
-                tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
-                tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+            tabline_t new_tabline_P(new_P, neg_P);
+            tabline_t new_tabline_Q(new_Q, neg_Q);
 
-                // Select targets based on the updated hydra graph
-                tab_ctx.select_targets();
-            }
+            // Copy restrictions and assumptions
+            new_tabline_P.assumptions = tabline.assumptions;
+            new_tabline_P.restrictions = tabline.restrictions;
+            new_tabline_Q.assumptions = tabline.assumptions;
+            new_tabline_Q.restrictions = tabline.restrictions;
+            
+            // Set justification to SplitConjunction
+            new_tabline_P.justification = { Reason::SplitConjunction, { static_cast<int>(i) } };
+            new_tabline_Q.justification = { Reason::SplitConjunction, { static_cast<int>(i) } };
 
-            // Indicate that a move was made
-            moved = true;
-        }
+            // Append new targets to the tableau
+            tab_ctx.tableau.push_back(new_tabline_P);
+            tab_ctx.tableau.push_back(new_tabline_Q);
 
-        special_predicates.clear();
+            // Split the hydra
+            tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+            tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+
+            // Select targets based on the updated hydra graph
+            tab_ctx.select_targets();
+        }
 
-        i++;
+        // Indicate that a move was made
+        moved = true;
     }
 
+    special_predicates.clear();
+
     return moved;
 }
 
-bool move_sdi(context_t& tab_ctx, size_t start) {
+bool move_sc(context_t& tab_ctx, size_t start) {
     bool moved = false;
-    size_t i = start;
 
-    while (i < tab_ctx.tableau.size()) {
-        tabline_t& tabline = tab_ctx.tableau[i];
+    // Optional: Reserve capacity to prevent reallocations
+    size_t expected_additions = tab_ctx.tableau.size() - start;
+    tab_ctx.tableau.reserve(tab_ctx.tableau.size() + expected_additions * 2); // Adjust based on expected splits
 
-        // Skip inactive formulas
-        if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
-            i++;
-            continue;
+    for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
+        if (move_sc_line(tab_ctx, i)) {
+            moved = true;
         }
+    }
 
-        std::vector<node*> special_predicates;
-        node* formula = split_special(special_predicates, tabline.formula);
-    
-        if (!tabline.target) {
-            // **Hypothesis Case:** Look for formulas of the form (P ∨ Q) → R
-            if (formula->is_implication()) {
-                node* left = formula->children[0];  // (P ∨ Q)
-                node* right = formula->children[1]; // R
-
-                if (left->is_disjunction()) {
-                    node* P = left->children[0];
-                    node* Q = left->children[1];
-                    node* R = right;
-
-                    // Collect variables used in R, P, and Q using vars_used
-                    std::set<std::string> vars_R, vars_P, vars_Q;
-                    vars_used(vars_R, R);
-                    vars_used(vars_P, P);
-                    vars_used(vars_Q, Q);
-
-                    // Check if all variables in R are used in P and in Q
-                    bool valid = true;
-                    for (const auto& var : vars_R) {
-                        if (vars_P.find(var) == vars_P.end() || vars_Q.find(var) == vars_Q.end()) {
-                            valid = false;
-                            break;
-                        }
+    return moved;
+}
+
+static bool move_sdi_line(context_t& tab_ctx, size_t i) {
+    bool moved = false;
+
+    tabline_t& tabline = tab_ctx.tableau[i];
+
+    // Skip inactive formulas
+    if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
+        return false;
+    }
+
+    std::vector<node*> special_predicates;
+    node* formula = split_special(special_predicates, tabline.formula);
+
+    if (!tabline.target) {
+        // **Hypothesis Case:** Look for formulas of the form (P ∨ Q) → R
+        if (formula->is_implication()) {
+            node* left = formula->children[0];  // (P ∨ Q)
+            node* right = formula->children[1]; // R
+
+            if (left->is_disjunction()) {
+                node* P = left->children[0];
+                node* Q = left->children[1];
+                node* R = right;
+
+                // Collect variables used in R, P, and Q using vars_used
+                std::set<std::string> vars_R, vars_P, vars_Q;
+                vars_used(vars_R, R);
+                vars_used(vars_P, P);
+                vars_used(vars_Q, Q);
+
+                // Check if all variables in R are used in P and in Q
+                bool valid = true;
+                for (const auto& var : vars_R) {
+                    if (vars_P.find(var) == vars_P.end() || vars_Q.find(var) == vars_Q.end()) {
+                        valid = false;
+                        break;
                     }
+                }
 
-                    if (valid) {
-                        // Increment count of cleanup moves
-                        tab_ctx.cleanup++;
-
-                        // **Critical Fix: Set flags before modifying the vector**
-                        // Mark the original implication as inactive and dead
-                        tabline.active = false;
-                        tabline.dead = true;
-
-                        // Deep copy P, Q, R
-                        node* P_copy = deep_copy(P);
-                        node* Q_copy = deep_copy(Q);
-                        node* R_copy1 = deep_copy(R);
-                        node* R_copy2 = deep_copy(R);
-
-                        if (!equal(P_copy, R_copy1)) {
-                            // Create new implication P → R
-                            node* P_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ P_copy, R_copy1 });
-                            
-                            P_imp_R = reapply_special(special_predicates, P_imp_R);
-
-                            // Create new tabline as hypothesis
-                            tabline_t new_tabline_P_imp(P_imp_R);
-                            
-                            // Copy restrictions and assumptions
-                            new_tabline_P_imp.assumptions = tabline.assumptions;
-                            new_tabline_P_imp.restrictions = tabline.restrictions;
-                            
-                            // Set justification
-                            new_tabline_P_imp.justification = { Reason::SplitDisjunctiveImplication, { static_cast<int>(i) } };
-                            
-                            // Append new tabline to the tableau
-                            tab_ctx.tableau.push_back(new_tabline_P_imp);
-                        } else {
-                            // clean up unused nodes
-                            delete P_copy;
-                            delete R_copy1;
-                        }
+                if (valid) {
+                    // Increment count of cleanup moves
+                    tab_ctx.cleanup++;
 
-                        if (!equal(Q_copy, R_copy2)) {
-                            // Create new implication Q → R
-                            node* Q_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ Q_copy, R_copy2 });
+                    // **Critical Fix: Set flags before modifying the vector**
+                    // Mark the original implication as inactive and dead
+                    tab_ctx.kill_line(i);
 
-                            Q_imp_R = reapply_special(special_predicates, Q_imp_R);
-                            
-                            // Create new tabline as hypothesis
-                            tabline_t new_tabline_Q_imp(Q_imp_R);
+                    // Deep copy P, Q, R
+                    node* P_copy = deep_copy(P);
+                    node* Q_copy = deep_copy(Q);
+                    node* R_copy1 = deep_copy(R);
+                    node* R_copy2 = deep_copy(R);
 
-                            // Copy restrictions and assumptions
-                            new_tabline_Q_imp.assumptions = tabline.assumptions;
-                            new_tabline_Q_imp.restrictions = tabline.restrictions;
-                    
-                            // Set justification
-                            new_tabline_Q_imp.justification = { Reason::SplitDisjunctiveImplication, { static_cast<int>(i) } };
-
-                            // Append new tabline to the tableau
-                            tab_ctx.tableau.push_back(new_tabline_Q_imp);
-                        } else {
-                            // clean up unused nodes
-                            delete Q_copy;
-                            delete R_copy2;
-                        }
+                    if (!equal(P_copy, R_copy1)) {
+                        // Create new implication P → R
+                        node* P_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ P_copy, R_copy1 });
+                        
+                        P_imp_R = reapply_special(special_predicates, P_imp_R);
 
-                        moved = true;
+                        // Create new tabline as hypothesis
+                        tabline_t new_tabline_P_imp(P_imp_R);
+                        
+                        // Copy restrictions and assumptions
+                        new_tabline_P_imp.assumptions = tabline.assumptions;
+                        new_tabline_P_imp.restrictions = tabline.restrictions;
+                        
+                        // Set justification
+                        new_tabline_P_imp.justification = { Reason::SplitDisjunctiveImplication, { static_cast<int>(i) } };
+                        
+                        // Append new tabline to the tableau
+                        tab_ctx.tableau.push_back(new_tabline_P_imp);
+                    } else {
+                        // clean up unused nodes
+                        delete P_copy;
+                        delete R_copy1;
+                    }
+
+                    if (!equal(Q_copy, R_copy2)) {
+                        // Create new implication Q → R
+                        node* Q_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ Q_copy, R_copy2 });
+
+                        Q_imp_R = reapply_special(special_predicates, Q_imp_R);
+                        
+                        // Create new tabline as hypothesis
+                        tabline_t new_tabline_Q_imp(Q_imp_R);
+
+                        // Copy restrictions and assumptions
+                        new_tabline_Q_imp.assumptions = tabline.assumptions;
+                        new_tabline_Q_imp.restrictions = tabline.restrictions;
+                
+                        // Set justification
+                        new_tabline_Q_imp.justification = { Reason::SplitDisjunctiveImplication, { static_cast<int>(i) } };
+
+                        // Append new tabline to the tableau
+                        tab_ctx.tableau.push_back(new_tabline_Q_imp);
+                    } else {
+                        // clean up unused nodes
+                        delete Q_copy;
+                        delete R_copy2;
                     }
+
+                    moved = true;
                 }
             }
         }
-        else {
-            // **Target Case:** Look for formulas of the form (P ∨ Q) ∧ ¬R, which represent ¬((P ∨ Q) → R)
-            if (formula->is_conjunction()) {
-                node* left = formula->children[0];  // (P ∨ Q)
-                node* right = formula->children[1]; // ¬R
-
-                // Check if left is a disjunction and right is a negation
-                if (left->is_disjunction()) {
-                    node* P = left->children[0];
-                    node* Q = left->children[1];
-                    node* R = right->children[0];
-
-                    // Collect variables used in R, P, and Q using vars_used
-                    std::set<std::string> vars_R, vars_P, vars_Q;
-                    vars_used(vars_R, R);
-                    vars_used(vars_P, P);
-                    vars_used(vars_Q, Q);
-
-                    // Check if all variables in R are used in P and in Q
-                    bool valid = true;
-                    for (const auto& var : vars_R) {
-                        if (vars_P.find(var) == vars_P.end() || vars_Q.find(var) == vars_Q.end()) {
-                            valid = false;
-                            break;
-                        }
+    }
+    else {
+        // **Target Case:** Look for formulas of the form (P ∨ Q) ∧ ¬R, which represent ¬((P ∨ Q) → R)
+        if (formula->is_conjunction()) {
+            node* left = formula->children[0];  // (P ∨ Q)
+            node* right = formula->children[1]; // ¬R
+
+            // Check if left is a disjunction and right is a negation
+            if (left->is_disjunction()) {
+                node* P = left->children[0];
+                node* Q = left->children[1];
+                node* R = right->children[0];
+
+                // Collect variables used in R, P, and Q using vars_used
+                std::set<std::string> vars_R, vars_P, vars_Q;
+                vars_used(vars_R, R);
+                vars_used(vars_P, P);
+                vars_used(vars_Q, Q);
+
+                // Check if all variables in R are used in P and in Q
+                bool valid = true;
+                for (const auto& var : vars_R) {
+                    if (vars_P.find(var) == vars_P.end() || vars_Q.find(var) == vars_Q.end()) {
+                        valid = false;
+                        break;
                     }
+                }
 
-                    if (valid) {
-                        // Increment count of cleanup moves
-                        tab_ctx.cleanup++;
-
-                        bool tar1 = false; // whether to create target 1 and 2
-                        bool tar2 = false;
-
-                        // **Critical Fix: Set flags before modifying the vector**
-                        // Mark the original target as inactive and dead
-                        tabline.active = false;
-                        tabline.dead = true;
-
-                        // Deep copy P, Q, R
-                        node* P_copy = deep_copy(P);
-                        node* Q_copy = deep_copy(Q);
-                        node* R_copy1 = deep_copy(R);
-                        node* R_copy2 = deep_copy(R);
-
-                        if (!equal(P_copy, R_copy1)) {
-                            // Create new implication P → R
-                            node* P_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ P_copy, R_copy1 });
-                            node* neg_P_imp_R = negate_node(deep_copy(P_imp_R));
-                            P_imp_R = reapply_special(special_predicates, P_imp_R);
-                            neg_P_imp_R = reapply_special(special_predicates, neg_P_imp_R);
-                            
-                            // Create new tablines as target
-                            tabline_t new_tabline_neg_P_imp(neg_P_imp_R, P_imp_R);
-                            
-                            // Copy restrictions and assumptions
-                            new_tabline_neg_P_imp.assumptions = tabline.assumptions;
-                            new_tabline_neg_P_imp.restrictions = tabline.restrictions;
-                            
-                            // Set justification
-                            new_tabline_neg_P_imp.justification = { Reason::SplitDisjunctiveImplication, { static_cast<int>(i) } };
-                            
-                            // Append new tabline to the tableau
-                            tab_ctx.tableau.push_back(new_tabline_neg_P_imp);
-
-                            // target 1 created
-                            tar1 = true;
-                        }
+                if (valid) {
+                    // Increment count of cleanup moves
+                    tab_ctx.cleanup++;
+
+                    bool tar1 = false; // whether to create target 1 and 2
+                    bool tar2 = false;
+
+                    // **Critical Fix: Set flags before modifying the vector**
+                    // Mark the original target as inactive and dead
+                    tab_ctx.kill_line(i);
+
+                    // Deep copy P, Q, R
+                    node* P_copy = deep_copy(P);
+                    node* Q_copy = deep_copy(Q);
+                    node* R_copy1 = deep_copy(R);
+                    node* R_copy2 = deep_copy(R);
+
+                    if (!equal(P_copy, R_copy1)) {
+                        // Create new implication P → R
+                        node* P_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ P_copy, R_copy1 });
+                        node* neg_P_imp_R = negate_node(deep_copy(P_imp_R));
+                        P_imp_R = reapply_special(special_predicates, P_imp_R);
+                        neg_P_imp_R = reapply_special(special_predicates, neg_P_imp_R);
+                        
+                        // Create new tablines as target
+                        tabline_t new_tabline_neg_P_imp(neg_P_imp_R, P_imp_R);
+                        
+                        // Copy restrictions and assumptions
+                        new_tabline_neg_P_imp.assumptions = tabline.assumptions;
+                        new_tabline_neg_P_imp.restrictions = tabline.restrictions;
+                        
+                        // Set justification
+                        new_tabline_neg_P_imp.justification = { Reason::SplitDisjunctiveImplication, { static_cast<int>(i) } };
                         
-                        if (!equal(Q_copy, R_copy2)) {
-                            // Create new implication Q → R
-                            node* Q_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ Q_copy, R_copy2 });
-                            node* neg_Q_imp_R = negate_node(deep_copy(Q_imp_R));
-                            Q_imp_R = reapply_special(special_predicates, Q_imp_R);
-                            neg_Q_imp_R = reapply_special(special_predicates, neg_Q_imp_R);
-                            
-                            // Create new tablines as target
-                            tabline_t new_tabline_neg_Q_imp(neg_Q_imp_R, Q_imp_R);
-
-                            // Copy restrictions and assumptions
-                            new_tabline_neg_Q_imp.assumptions = tabline.assumptions;
-                            new_tabline_neg_Q_imp.restrictions = tabline.restrictions;
+                        // Append new tabline to the tableau
+                        tab_ctx.tableau.push_back(new_tabline_neg_P_imp);
+
+                        // target 1 created
+                        tar1 = true;
+                    }
                     
-                            // Set justification
-                            new_tabline_neg_Q_imp.justification = { Reason::SplitDisjunctiveImplication, { static_cast<int>(i) } };
+                    if (!equal(Q_copy, R_copy2)) {
+                        // Create new implication Q → R
+                        node* Q_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ Q_copy, R_copy2 });
+                        node* neg_Q_imp_R = negate_node(deep_copy(Q_imp_R));
+                        Q_imp_R = reapply_special(special_predicates, Q_imp_R);
+                        neg_Q_imp_R = reapply_special(special_predicates, neg_Q_imp_R);
+                        
+                        // Create new tablines as target
+                        tabline_t new_tabline_neg_Q_imp(neg_Q_imp_R, Q_imp_R);
 
-                            // Append new tabline to the tableau
-                            tab_ctx.tableau.push_back(new_tabline_neg_Q_imp);
+                        // Copy restrictions and assumptions
+                        new_tabline_neg_Q_imp.assumptions = tabline.assumptions;
+                        new_tabline_neg_Q_imp.restrictions = tabline.restrictions;
+                
+                        // Set justification
+                        new_tabline_neg_Q_imp.justification = { Reason::SplitDisjunctiveImplication, { static_cast<int>(i) } };
 
-                            // target 2 created
-                            tar2 = true;
-                        }
+                        // Append new tabline to the tableau
+                        tab_ctx.tableau.push_back(new_tabline_neg_Q_imp);
 
-                        if (tar1 && tar2) // both targets created
-                        {
-                            // Split the hydra and select targets
-                            tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
-                            tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
-                            tab_ctx.select_targets();
-
-                            moved = true;
-                        } else if (tar1 || tar2) { // one target created
-                            // Replace the hydra and select targets
-                            tab_ctx.hydra_replace(i, tab_ctx.tableau.size() - 1);
-                            tab_ctx.restrictions_replace(i, tab_ctx.tableau.size() - 1);
-                            tab_ctx.select_targets();
-
-                            moved = true;
-                        }
+                        // target 2 created
+                        tar2 = true;
+                    }
+
+                    if (tar1 && tar2) // both targets created
+                    {
+                        // Split the hydra and select targets
+                        tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+                        tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+                        tab_ctx.select_targets();
+
+                        moved = true;
+                    } else if (tar1 || tar2) { // one target created
+                        // Replace the hydra and select targets
+                        tab_ctx.hydra_replace(i, tab_ctx.tableau.size() - 1);
+                        tab_ctx.restrictions_replace(i, tab_ctx.tableau.size() - 1);
+                        tab_ctx.select_targets();
+
+                        moved = true;
                     }
                 }
             }
         }
+    }
 
-        special_predicates.clear();
+    special_predicates.clear();
 
-        i++;
+    return moved;
+}
+
+bool move_sdi(context_t& tab_ctx, size_t start) {
+    bool moved = false;
+
+    for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
+        if (move_sdi_line(tab_ctx, i)) {
+            moved = true;
+        }
     }
 
     return moved;
 }
 
-bool move_sci(context_t& tab_ctx, size_t start) {
+static bool move_sci_line(context_t& tab_ctx, size_t i) {
     bool moved = false;
-    size_t i = start;
 
-    while (i < tab_ctx.tableau.size()) {
-        tabline_t& tabline = tab_ctx.tableau[i];
+    tabline_t& tabline = tab_ctx.tableau[i];
 
-        // Skip inactive formulas
-        if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
-            i++;
-            continue;
-        }
+    // Skip inactive formulas
+    if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
+        return false;
+    }
 
-        std::vector<node*> special_predicates;
-        node* formula = split_special(special_predicates, tabline.formula);
-    
-        if (!tabline.target) {
-            // **Hypothesis Case:** Look for formulas of the form P → (Q ∧ R)
-            if (formula->is_implication()) {
-                node* antecedent = formula->children[0];  // P
-                node* consequent = formula->children[1];  // (Q ∧ R)
-
-                if (consequent->is_conjunction()) {
-                    node* Q = consequent->children[0];
-                    node* R = consequent->children[1];
-
-                    // Collect variables used in Q, R, and P using vars_used
-                    std::set<std::string> vars_Q, vars_R, vars_P;
-                    vars_used(vars_Q, Q, true);
-                    vars_used(vars_R, R, true);
-                    vars_used(vars_P, antecedent, true);
-
-                    // Check if all variables in Q and R are used in P
-                    bool valid = true;
-                    for (const auto& var : vars_Q) {
+    std::vector<node*> special_predicates;
+    node* formula = split_special(special_predicates, tabline.formula);
+
+    if (!tabline.target) {
+        // **Hypothesis Case:** Look for formulas of the form P → (Q ∧ R)
+        if (formula->is_implication()) {
+            node* antecedent = formula->children[0];  // P
+            node* consequent = formula->children[1];  // (Q ∧ R)
+
+            if (consequent->is_conjunction()) {
+                node* Q = consequent->children[0];
+                node* R = consequent->children[1];
+
+                // Collect variables used in Q, R, and P using vars_used
+                std::set<std::string> vars_Q, vars_R, vars_P;
+                vars_used(vars_Q, Q, true);
+                vars_used(vars_R, R, true);
+                vars_used(vars_P, antecedent, true);
+
+                // Check if all variables in Q and R are used in P
+                bool valid = true;
+                for (const auto& var : vars_Q) {
+                    if (vars_P.find(var) == vars_P.end()) {
+                        valid = false;
+                        break;
+                    }
+                }
+                if (valid) {
+                    for (const auto& var : vars_R) {
                         if (vars_P.find(var) == vars_P.end()) {
                             valid = false;
                             break;
                         }
                     }
-                    if (valid) {
-                        for (const auto& var : vars_R) {
-                            if (vars_P.find(var) == vars_P.end()) {
-                                valid = false;
-                                break;
-                            }
-                        }
-                    }
+                }
 
-                    if (valid) {
-                        // Increment count of cleanup moves
-                        tab_ctx.cleanup++;
-
-                        // **Critical Fix: Set flags before modifying the vector**
-                        // Mark the original implication as inactive and dead
-                        tabline.active = false;
-                        tabline.dead = true;
-
-                        // Deep copy P, Q, R
-                        node* P_copy1 = deep_copy(antecedent);
-                        node* P_copy2 = deep_copy(antecedent);
-                        node* Q_copy = deep_copy(Q);
-                        node* R_copy = deep_copy(R);
-
-                        if (!equal(P_copy1, Q_copy)) {
-                            // Create new implications P → Q
-                            node* P_imp_Q = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ P_copy1, Q_copy });
-                            P_imp_Q = reapply_special(special_predicates, P_imp_Q);
-                            
-                            // Create new tabline as hypothesis
-                            tabline_t new_tabline_P_imp_Q(P_imp_Q);
-                            
-                            // Copy restrictions and assumptions
-                            new_tabline_P_imp_Q.assumptions = tabline.assumptions;
-                            new_tabline_P_imp_Q.restrictions = tabline.restrictions;
-                            
-                            // Set justification
-                            new_tabline_P_imp_Q.justification = { Reason::SplitConjunctiveImplication, { static_cast<int>(i) } };
-                            
-                            // Append new tabline to the tableau
-                            tab_ctx.tableau.push_back(new_tabline_P_imp_Q);
-                        } else {
-                            // clean up unused nodes
-                            delete P_copy1;
-                            delete Q_copy;
-                        }
+                if (valid) {
+                    // Increment count of cleanup moves
+                    tab_ctx.cleanup++;
 
-                        if (!equal(P_copy2, R_copy)) {
-                            // Create new implications P → R
-                            node* P_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ P_copy2, R_copy });
-                            P_imp_R = reapply_special(special_predicates, P_imp_R);
-                            
-                            // Create new tabline as hypothesis
-                            tabline_t new_tabline_P_imp_R(P_imp_R);
-
-                            // Copy restrictions and assumptions
-                            new_tabline_P_imp_R.assumptions = tabline.assumptions;
-                            new_tabline_P_imp_R.restrictions = tabline.restrictions;
-                
-                            // Set justification
-                            new_tabline_P_imp_R.justification = { Reason::SplitConjunctiveImplication, { static_cast<int>(i) } };
-
-                            // Append new tabline to the tableau
-                            tab_ctx.tableau.push_back(new_tabline_P_imp_R);
-                        } else {
-                            // clean up unused nodes
-                            delete P_copy2;
-                            delete R_copy;
-                        }
+                    // **Critical Fix: Set flags before modifying the vector**
+                    // Mark the original implication as inactive and dead
+                    tab_ctx.kill_line(i);
 
-                        // Indicate that a move was made
-                        moved = true;
+                    // Deep copy P, Q, R
+                    node* P_copy1 = deep_copy(antecedent);
+                    node* P_copy2 = deep_copy(antecedent);
+                    node* Q_copy = deep_copy(Q);
+                    node* R_copy = deep_copy(R);
+
+                    if (!equal(P_copy1, Q_copy)) {
+                        // Create new implications P → Q
+                        node* P_imp_Q = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ P_copy1, Q_copy });
+                        P_imp_Q = reapply_special(special_predicates, P_imp_Q);
+                        
+                        // Create new tabline as hypothesis
+                        tabline_t new_tabline_P_imp_Q(P_imp_Q);
+                        
+                        // Copy restrictions and assumptions
+                        new_tabline_P_imp_Q.assumptions = tabline.assumptions;
+                        new_tabline_P_imp_Q.restrictions = tabline.restrictions;
+                        
+                        // Set justification
+                        new_tabline_P_imp_Q.justification = { Reason::SplitConjunctiveImplication, { static_cast<int>(i) } };
+                        
+                        // Append new tabline to the tableau
+                        tab_ctx.tableau.push_back(new_tabline_P_imp_Q);
+                    } else {
+                        // clean up unused nodes
+                        delete P_copy1;
+                        delete Q_copy;
+                    }
+
+                    if (!equal(P_copy2, R_copy)) {
+                        // Create new implications P → R
+                        node* P_imp_R = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, std::vector<node*>{ P_copy2, R_copy });
+                        P_imp_R = reapply_special(special_predicates, P_imp_R);
+                        
+                        // Create new tabline as hypothesis
+                        tabline_t new_tabline_P_imp_R(P_imp_R);
+
+                        // Copy restrictions and assumptions
+                        new_tabline_P_imp_R.assumptions = tabline.assumptions;
+                        new_tabline_P_imp_R.restrictions = tabline.restrictions;
+            
+                        // Set justification
+                        new_tabline_P_imp_R.justification = { Reason::SplitConjunctiveImplication, { static_cast<int>(i) } };
+
+                        // Append new tabline to the tableau
+                        tab_ctx.tableau.push_back(new_tabline_P_imp_R);
+                    } else {
+                        // clean up unused nodes
+                        delete P_copy2;
+                        delete R_copy;
                     }
+
+                    // Indicate that a move was made
+                    moved = true;
                 }
             }
         }
-        else {
-            // **Target Case:** Look for formulas of the form P ∧ (Q ∨ R)
-            if (formula->is_conjunction()) {
-                node* P = formula->children[0];             // P
-                node* disjunct = formula->children[1];      // (Q ∨ R)
-
-                if (disjunct->is_disjunction()) {
-                    node* Q = disjunct->children[0];
-                    node* R = disjunct->children[1];
-
-                    // Collect variables used in Q, R, and P using vars_used
-                    std::set<std::string> vars_Q, vars_R, vars_P;
-                    vars_used(vars_Q, Q, true);
-                    vars_used(vars_R, R, true);
-                    vars_used(vars_P, P, true);
-
-                    // Check if all variables in Q and R are used in P
-                    bool valid = true;
-                    for (const auto& var : vars_Q) {
+    }
+    else {
+        // **Target Case:** Look for formulas of the form P ∧ (Q ∨ R)
+        if (formula->is_conjunction()) {
+            node* P = formula->children[0];             // P
+            node* disjunct = formula->children[1];      // (Q ∨ R)
+
+            if (disjunct->is_disjunction()) {
+                node* Q = disjunct->children[0];
+                node* R = disjunct->children[1];
+
+                // Collect variables used in Q, R, and P using vars_used
+                std::set<std::string> vars_Q, vars_R, vars_P;
+                vars_used(vars_Q, Q, true);
+                vars_used(vars_R, R, true);
+                vars_used(vars_P, P, true);
+
+                // Check if all variables in Q and R are used in P
+                bool valid = true;
+                for (const auto& var : vars_Q) {
+                    if (vars_P.find(var) == vars_P.end()) {
+                        valid = false;
+                        break;
+                    }
+                }
+                if (valid) {
+                    for (const auto& var : vars_R) {
                         if (vars_P.find(var) == vars_P.end()) {
                             valid = false;
                             break;
                         }
                     }
-                    if (valid) {
-                        for (const auto& var : vars_R) {
-                            if (vars_P.find(var) == vars_P.end()) {
-                                valid = false;
-                                break;
-                            }
-                        }
-                    }
+                }
 
-                    if (valid) {
-                        // Increment count of cleanup moves
-                        tab_ctx.cleanup++;
-
-                        bool tar1 = false; // whether to create targets 1 and 2
-                        bool tar2 = false;
-
-                        // **Critical Fix: Set flags before modifying the vector**
-                        // Mark the original target as inactive and dead
-                        tabline.active = false;
-                        tabline.dead = true;
-
-                        // Deep copy P, Q, R
-                        node* P_copy1 = deep_copy(P);
-                        node* P_copy2 = deep_copy(P);
-                        node* Q_copy = deep_copy(Q);
-                        node* R_copy = deep_copy(R);
-
-                        if (!equal(P_copy1, Q_copy)) {
-                            // Create new conjunction P ∧ Q
-                            node* P_and_Q = new node(LOGICAL_BINARY, SYMBOL_AND, std::vector<node*>{ P_copy1, Q_copy });
-                            node* neg_P_and_Q = negate_node(deep_copy(P_and_Q), true);
-                            P_and_Q = reapply_special(special_predicates, P_and_Q);
-                            neg_P_and_Q = reapply_special(special_predicates, neg_P_and_Q);
-                            
-                            // Create new tabline as targets
-                            tabline_t new_tabline_neg_P_and_Q(P_and_Q, neg_P_and_Q);
-                            
-                            // Copy restrictions and assumptions
-                            new_tabline_neg_P_and_Q.assumptions = tabline.assumptions;
-                            new_tabline_neg_P_and_Q.restrictions = tabline.restrictions;
-                            
-                            // Set justification
-                            new_tabline_neg_P_and_Q.justification = { Reason::SplitConjunctiveImplication, { static_cast<int>(i) } };
-                            
-                            // Append new tabline to the tableau
-                            tab_ctx.tableau.push_back(new_tabline_neg_P_and_Q);
-
-                            // target 1 created
-                            tar1 = true;
-                        }
+                if (valid) {
+                    // Increment count of cleanup moves
+                    tab_ctx.cleanup++;
+
+                    bool tar1 = false; // whether to create targets 1 and 2
+                    bool tar2 = false;
+
+                    // **Critical Fix: Set flags before modifying the vector**
+                    // Mark the original target as inactive and dead
+                    tab_ctx.kill_line(i);
+
+                    // Deep copy P, Q, R
+                    node* P_copy1 = deep_copy(P);
+                    node* P_copy2 = deep_copy(P);
+                    node* Q_copy = deep_copy(Q);
+                    node* R_copy = deep_copy(R);
+
+                    if (!equal(P_copy1, Q_copy)) {
+                        // Create new conjunction P ∧ Q
+                        node* P_and_Q = new node(LOGICAL_BINARY, SYMBOL_AND, std::vector<node*>{ P_copy1, Q_copy });
+                        node* neg_P_and_Q = negate_node(deep_copy(P_and_Q), true);
+                        P_and_Q = reapply_special(special_predicates, P_and_Q);
+                        neg_P_and_Q = reapply_special(special_predicates, neg_P_and_Q);
+                        
+                        // Create new tabline as targets
+                        tabline_t new_tabline_neg_P_and_Q(P_and_Q, neg_P_and_Q);
                         
-                        if (!equal(P_copy2, R_copy)) {
-                            // Create new conjunction P ∧ R
-                            node* P_and_R = new node(LOGICAL_BINARY, SYMBOL_AND, std::vector<node*>{ P_copy2, R_copy });
-                            node* neg_P_and_R = negate_node(deep_copy(P_and_R), true);
-                            P_and_R = reapply_special(special_predicates, P_and_R);
-                            neg_P_and_R = reapply_special(special_predicates, neg_P_and_R);
-
-                            // Create new tabline as targets
-                            tabline_t new_tabline_neg_P_and_R(P_and_R, neg_P_and_R);
-
-                            // Copy restrictions and assumptions
-                            new_tabline_neg_P_and_R.assumptions = tabline.assumptions;
-                            new_tabline_neg_P_and_R.restrictions = tabline.restrictions;
+                        // Copy restrictions and assumptions
+                        new_tabline_neg_P_and_Q.assumptions = tabline.assumptions;
+                        new_tabline_neg_P_and_Q.restrictions = tabline.restrictions;
+                        
+                        // Set justification
+                        new_tabline_neg_P_and_Q.justification = { Reason::SplitConjunctiveImplication, { static_cast<int>(i) } };
+                        
+                        // Append new tabline to the tableau
+                        tab_ctx.tableau.push_back(new_tabline_neg_P_and_Q);
+
+                        // target 1 created
+                        tar1 = true;
+                    }
                     
-                            // Set justification
-                            new_tabline_neg_P_and_R.justification = { Reason::SplitConjunctiveImplication, { static_cast<int>(i) } };
+                    if (!equal(P_copy2, R_copy)) {
+                        // Create new conjunction P ∧ R
+                        node* P_and_R = new node(LOGICAL_BINARY, SYMBOL_AND, std::vector<node*>{ P_copy2, R_copy });
+                        node* neg_P_and_R = negate_node(deep_copy(P_and_R), true);
+                        P_and_R = reapply_special(special_predicates, P_and_R);
+                        neg_P_and_R = reapply_special(special_predicates, neg_P_and_R);
 
-                            // Append new tabline to the tableau
-                            tab_ctx.tableau.push_back(new_tabline_neg_P_and_R);
+                        // Create new tabline as targets
+                        tabline_t new_tabline_neg_P_and_R(P_and_R, neg_P_and_R);
 
-                            // target 2 created
-                            tar2 = true;
-                        }
+                        // Copy restrictions and assumptions
+                        new_tabline_neg_P_and_R.assumptions = tabline.assumptions;
+                        new_tabline_neg_P_and_R.restrictions = tabline.restrictions;
+                
+                        // Set justification
+                        new_tabline_neg_P_and_R.justification = { Reason::SplitConjunctiveImplication, { static_cast<int>(i) } };
 
-                        if (tar1 && tar2) // both targets created
-                        {
-                            // Split the hydra and select targets
-                            tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
-                            tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
-                            tab_ctx.select_targets();
-
-                            moved = true;
-                        } else if (tar1 || tar2) { // one target created
-                            // Replace the hydra and select targets
-                            tab_ctx.hydra_replace(i, tab_ctx.tableau.size() - 1);
-                            tab_ctx.restrictions_replace(i, tab_ctx.tableau.size() - 1);
-                            tab_ctx.select_targets();
-
-                            moved = true;
-                        }
+                        // Append new tabline to the tableau
+                        tab_ctx.tableau.push_back(new_tabline_neg_P_and_R);
+
+                        // target 2 created
+                        tar2 = true;
+                    }
+
+                    if (tar1 && tar2) // both targets created
+                    {
+                        // Split the hydra and select targets
+                        tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+                        tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+                        tab_ctx.select_targets();
+
+                        moved = true;
+                    } else if (tar1 || tar2) { // one target created
+                        // Replace the hydra and select targets
+                        tab_ctx.hydra_replace(i, tab_ctx.tableau.size() - 1);
+                        tab_ctx.restrictions_replace(i, tab_ctx.tableau.size() - 1);
+                        tab_ctx.select_targets();
+
+                        moved = true;
                     }
                 }
             }
         }
+    }
 
-        special_predicates.clear();
+    special_predicates.clear();
+
+    return moved;
+}
+
+bool move_sci(context_t& tab_ctx, size_t start) {
+    bool moved = false;
 
-        i++;
+    for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
+        if (move_sci_line(tab_ctx, i)) {
+            moved = true;
+        }
     }
 
     return moved;
 }
 
-bool move_ni(context_t& tab_ctx, size_t start) {
+static bool move_ni_line(context_t& tab_ctx, size_t i) {
     bool moved = false;
-    size_t i = start;
 
-    while (i < tab_ctx.tableau.size()) {
-        tabline_t& tabline = tab_ctx.tableau[i];
+    tabline_t& tabline = tab_ctx.tableau[i];
 
-        // Skip inactive formulas
-        if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
-            i++;
-            continue;
-        }
+    // Skip inactive formulas
+    if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
+        return false;
+    }
 
-        std::vector<node*> special_predicates;
-        node* formula = split_special(special_predicates, tabline.formula);
-    
-        if (!tabline.target) {
-            // **Hypothesis Case:** Look for formulas of the form ¬(P → Q)
-            if (formula->is_negation()) {
-                node* inner = formula->children[0];
-                if (inner->is_implication()) {
-                    node* P = inner->children[0];
-                    node* Q = inner->children[1];
-
-                    // Collect variables used in Q, P
-                    std::set<std::string> vars_Q, vars_P;
-                    vars_used(vars_Q, Q, true);
-                    vars_used(vars_P, P, true);
-
-                    // Check if all variables in Q are used in P
-                    bool valid = true;
-                    for (const auto& var : vars_Q) {
-                        if (vars_P.find(var) == vars_P.end()) {
-                            valid = false;
-                            break;
-                        }
-                    }
+    std::vector<node*> special_predicates;
+    node* formula = split_special(special_predicates, tabline.formula);
 
-                    if (valid) {
-                        // Increment count of cleanup moves
-                        tab_ctx.cleanup++;
-
-                        // **Critical Fix: Set flags before modifying the vector**
-                        // Mark the original negated implication as inactive and dead
-                        tabline.active = false;
-                        tabline.dead = true;
-
-                        // Deep copy P, Q
-                        node* P_copy = deep_copy(P);
-                        node* Q_copy = deep_copy(Q);
-                        node* neg_Q_copy = negate_node(deep_copy(Q));
-                        P_copy = reapply_special(special_predicates, P_copy);
-                        Q_copy = reapply_special(special_predicates, Q_copy);
-                        neg_Q_copy = reapply_special(special_predicates, neg_Q_copy);
-                            
-                        // Create new hypothesis P
-                        tabline_t new_hypothesis_P(P_copy);
-                        new_hypothesis_P.target = false;
-                        new_hypothesis_P.active = true;
-                        new_hypothesis_P.justification = { Reason::NegatedImplication, { static_cast<int>(i) } };
-
-                        // Create new target Q
-                        tabline_t new_target_Q(neg_Q_copy, Q_copy); // Assuming constructor takes formula and negation
-                        new_target_Q.target = true;
-                        new_target_Q.active = true;
-                        new_target_Q.justification = { Reason::NegatedImplication, { static_cast<int>(i) } };
+    if (!tabline.target) {
+        // **Hypothesis Case:** Look for formulas of the form ¬(P → Q)
+        if (formula->is_negation()) {
+            node* inner = formula->children[0];
+            if (inner->is_implication()) {
+                node* P = inner->children[0];
+                node* Q = inner->children[1];
+
+                // Collect variables used in Q, P
+                std::set<std::string> vars_Q, vars_P;
+                vars_used(vars_Q, Q, true);
+                vars_used(vars_P, P, true);
+
+                // Check if all variables in Q are used in P
+                bool valid = true;
+                for (const auto& var : vars_Q) {
+                    if (vars_P.find(var) == vars_P.end()) {
+                        valid = false;
+                        break;
+                    }
+                }
 
-                        // Copy restrictions and assumptions
-                        new_hypothesis_P.assumptions = tabline.assumptions;
-                        new_hypothesis_P.restrictions = tabline.restrictions;
-                        new_target_Q.assumptions = tabline.assumptions;
-                        new_target_Q.restrictions = tabline.restrictions;
-                    
-                        // Append new hypothesis and target to the tableau
-                        tab_ctx.tableau.push_back(new_hypothesis_P);
-                        tab_ctx.tableau.push_back(new_target_Q);
+                if (valid) {
+                    // Increment count of cleanup moves
+                    tab_ctx.cleanup++;
+
+                    // **Critical Fix: Set flags before modifying the vector**
+                    // Mark the original negated implication as inactive and dead
+                    tab_ctx.kill_line(i);
+
+                    // Deep copy P, Q
+                    node* P_copy = deep_copy(P);
+                    node* Q_copy = deep_copy(Q);
+                    node* neg_Q_copy = negate_node(deep_copy(Q));
+                    P_copy = reapply_special(special_predicates, P_copy);
+                    Q_copy = reapply_special(special_predicates, Q_copy);
+                    neg_Q_copy = reapply_special(special_predicates, neg_Q_copy);
+                        
+                    // Create new hypothesis P
+                    tabline_t new_hypothesis_P(P_copy);
+                    new_hypothesis_P.target = false;
+                    new_hypothesis_P.active = true;
+                    new_hypothesis_P.justification = { Reason::NegatedImplication, { static_cast<int>(i) } };
+
+                    // Create new target Q
+                    tabline_t new_target_Q(neg_Q_copy, Q_copy); // Assuming constructor takes formula and negation
+                    new_target_Q.target = true;
+                    new_target_Q.active = true;
+                    new_target_Q.justification = { Reason::NegatedImplication, { static_cast<int>(i) } };
+
+                    // Copy restrictions and assumptions
+                    new_hypothesis_P.assumptions = tabline.assumptions;
+                    new_hypothesis_P.restrictions = tabline.restrictions;
+                    new_target_Q.assumptions = tabline.assumptions;
+                    new_target_Q.restrictions = tabline.restrictions;
+                
+                    // Append new hypothesis and target to the tableau
+                    tab_ctx.tableau.push_back(new_hypothesis_P);
+                    tab_ctx.tableau.push_back(new_target_Q);
 
-                        // Add restriction to the new hypothesis
-                        new_hypothesis_P.restrictions.push_back(static_cast<int>(tab_ctx.tableau.size() - 1));
+                    // Add restriction to the new hypothesis
+                    new_hypothesis_P.restrictions.push_back(static_cast<int>(tab_ctx.tableau.size() - 1));
 
-                        moved = true;
-                    }
+                    moved = true;
                 }
             }
         }
-        else {
-            // **Target Case:** Look for formulas of the form P → Q
-            if (formula->is_implication()) {
-                // Increment count of cleanup moves
-                tab_ctx.cleanup++;
-        
-                node* P = formula->children[0];
-                node* Q = formula->children[1];
-
-                // Deep copy P and Q
-                node* P_copy = deep_copy(P);
-                node* Q_copy = deep_copy(Q);
-                P_copy = disjunction_to_implication(P_copy);
-                node* neg_P_copy = negate_node(deep_copy(P));
-                node* neg_Q_copy = negate_node(deep_copy(Q), true);
-                P_copy = reapply_special(special_predicates, P_copy);
-                Q_copy = reapply_special(special_predicates, Q_copy);
-                neg_P_copy = reapply_special(special_predicates, neg_P_copy);
-                neg_Q_copy = reapply_special(special_predicates, neg_Q_copy);
-                        
-                // Create new target tablines
-                tabline_t new_tabline_neg_P(neg_P_copy, P_copy); // Assuming constructor takes formula and negation
-                tabline_t new_tabline_neg_Q(Q_copy, neg_Q_copy);
-
-                // Copy restrictions and assumptions
-                new_tabline_neg_P.assumptions = tabline.assumptions;
-                new_tabline_neg_P.restrictions = tabline.restrictions;
-                new_tabline_neg_Q.assumptions = tabline.assumptions;
-                new_tabline_neg_Q.restrictions = tabline.restrictions;
-                
-                // Set justifications
-                new_tabline_neg_P.justification = { Reason::NegatedImplication, { static_cast<int>(i) } };
-                new_tabline_neg_Q.justification = { Reason::NegatedImplication, { static_cast<int>(i) } };
+    }
+    else {
+        // **Target Case:** Look for formulas of the form P → Q
+        if (formula->is_implication()) {
+            // Increment count of cleanup moves
+            tab_ctx.cleanup++;
+    
+            node* P = formula->children[0];
+            node* Q = formula->children[1];
 
-                // Append new target tablines to the tableau
-                tab_ctx.tableau.push_back(new_tabline_neg_P);
-                tab_ctx.tableau.push_back(new_tabline_neg_Q);
+            // Deep copy P and Q
+            node* P_copy = deep_copy(P);
+            node* Q_copy = deep_copy(Q);
+            P_copy = disjunction_to_implication(P_copy);
+            node* neg_P_copy = negate_node(deep_copy(P));
+            node* neg_Q_copy = negate_node(deep_copy(Q), true);
+            P_copy = reapply_special(special_predicates, P_copy);
+            Q_copy = reapply_special(special_predicates, Q_copy);
+            neg_P_copy = reapply_special(special_predicates, neg_P_copy);
+            neg_Q_copy = reapply_special(special_predicates, neg_Q_copy);
+                    
+            // Create new target tablines
+            tabline_t new_tabline_neg_P(neg_P_copy, P_copy); // Assuming constructor takes formula and negation
+            tabline_t new_tabline_neg_Q(Q_copy, neg_Q_copy);
+
+            // Copy restrictions and assumptions
+            new_tabline_neg_P.assumptions = tabline.assumptions;
+            new_tabline_neg_P.restrictions = tabline.restrictions;
+            new_tabline_neg_Q.assumptions = tabline.assumptions;
+            new_tabline_neg_Q.restrictions = tabline.restrictions;
+            
+            // Set justifications
+            new_tabline_neg_P.justification = { Reason::NegatedImplication, { static_cast<int>(i) } };
+            new_tabline_neg_Q.justification = { Reason::NegatedImplication, { static_cast<int>(i) } };
 
-                // **Critical Fix: Set flags before hydra operations**
-                // Already set flags before modifying the vector
+            // Append new target tablines to the tableau
+            tab_ctx.tableau.push_back(new_tabline_neg_P);
+            tab_ctx.tableau.push_back(new_tabline_neg_Q);
 
-                // Mark the original implication as inactive and dead
-                tabline.active = false;
-                tabline.dead = true;
+            // **Critical Fix: Set flags before hydra operations**
+            // Already set flags before modifying the vector
 
-                // Split the hydra and select targets
-                tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
-                tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
-                tab_ctx.select_targets();
+            // Mark the original implication as inactive and dead
+            tab_ctx.kill_line(i);
 
-                moved = true;
-            }
+            // Split the hydra and select targets
+            tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+            tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+            tab_ctx.select_targets();
+
+            moved = true;
         }
+    }
 
-        special_predicates.clear();
+    special_predicates.clear();
+
+    return moved;
+}
+
+bool move_ni(context_t& tab_ctx, size_t start) {
+    bool moved = false;
 
-        i++;
+    for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
+        if (move_ni_line(tab_ctx, i)) {
+            moved = true;
+        }
     }
 
     return moved;
 }
 
-bool move_me(context_t& tab_ctx, size_t start) {
+static bool move_me_line(context_t& tab_ctx, size_t i) {
     bool moved = false;
-    size_t i = start;
 
-    while (i < tab_ctx.tableau.size()) {
-        tabline_t& tabline = tab_ctx.tableau[i];
+    tabline_t& tabline = tab_ctx.tableau[i];
 
-        // Skip inactive formulas
-        if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
-            i++;
-            continue;
-        }
+    // Skip inactive formulas
+    if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
+        return false;
+    }
 
-        if (!tabline.target) {
-            std::vector<node*> special_predicates;
-            node* formula = split_special(special_predicates, tabline.formula);
-    
-            // **Target Case:** Look for formulas of the form P ↔ Q
-            if (formula->is_equivalence()) {
-                // Increment count of cleanup moves
-                tab_ctx.cleanup++;
-
-                node* P = formula->children[0];
-                node* Q = formula->children[1];
-
-                // Deep copy P and Q
-                node* P_copy1 = deep_copy(P);
-                node* P_copy2 = deep_copy(P);
-                node* Q_copy1 = deep_copy(Q);
-                node* Q_copy2 = deep_copy(Q);
-                std::vector<node*> children1, children2;
-                children1.push_back(P_copy1);
-                children1.push_back(Q_copy1);
-                children2.push_back(Q_copy2);
-                children2.push_back(P_copy2);
-                node* P_implies_Q = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, children1);
-                node* Q_implies_P = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, children2);
-                P_implies_Q = reapply_special(special_predicates, P_implies_Q);
-                Q_implies_P = reapply_special(special_predicates, Q_implies_P);
-                
-                // Create new target tablines
-                tabline_t new_tabline_P_implies_Q(P_implies_Q);
-                tabline_t new_tabline_Q_implies_P(Q_implies_P);
-                
-                // Copy restrictions and assumptions
-                new_tabline_P_implies_Q.assumptions = tabline.assumptions;
-                new_tabline_P_implies_Q.restrictions = tabline.restrictions;
-                new_tabline_Q_implies_P.assumptions = tabline.assumptions;
-                new_tabline_Q_implies_P.restrictions = tabline.restrictions;
-                
-                // Set justifications
-                new_tabline_P_implies_Q.justification = { Reason::MaterialEquivalence, { static_cast<int>(i) } };
-                new_tabline_Q_implies_P.justification = { Reason::MaterialEquivalence, { static_cast<int>(i) } };
+    if (!tabline.target) {
+        std::vector<node*> special_predicates;
+        node* formula = split_special(special_predicates, tabline.formula);
 
-                // Mark the original equivalence as inactive and dead
-                tabline.active = false;
-                tabline.dead = true;
+        // **Target Case:** Look for formulas of the form P ↔ Q
+        if (formula->is_equivalence()) {
+            // Increment count of cleanup moves
+            tab_ctx.cleanup++;
 
-                // Append new target tablines to the tableau
-                tab_ctx.tableau.push_back(new_tabline_P_implies_Q);
-                tab_ctx.tableau.push_back(new_tabline_Q_implies_P);
+            node* P = formula->children[0];
+            node* Q = formula->children[1];
 
-                moved = true;
-            }
+            // Deep copy P and Q
+            node* P_copy1 = deep_copy(P);
+            node* P_copy2 = deep_copy(P);
+            node* Q_copy1 = deep_copy(Q);
+            node* Q_copy2 = deep_copy(Q);
+            std::vector<node*> children1, children2;
+            children1.push_back(P_copy1);
+            children1.push_back(Q_copy1);
+            children2.push_back(Q_copy2);
+            children2.push_back(P_copy2);
+            node* P_implies_Q = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, children1);
+            node* Q_implies_P = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, children2);
+            P_implies_Q = reapply_special(special_predicates, P_implies_Q);
+            Q_implies_P = reapply_special(special_predicates, Q_implies_P);
+            
+            // Create new target tablines
+            tabline_t new_tabline_P_implies_Q(P_implies_Q);
+            tabline_t new_tabline_Q_implies_P(Q_implies_P);
+            
+            // Copy restrictions and assumptions
+            new_tabline_P_implies_Q.assumptions = tabline.assumptions;
+            new_tabline_P_implies_Q.restrictions = tabline.restrictions;
+            new_tabline_Q_implies_P.assumptions = tabline.assumptions;
+            new_tabline_Q_implies_P.restrictions = tabline.restrictions;
+            
+            // Set justifications
+            new_tabline_P_implies_Q.justification = { Reason::MaterialEquivalence, { static_cast<int>(i) } };
+            new_tabline_Q_implies_P.justification = { Reason::MaterialEquivalence, { static_cast<int>(i) } };
+
+            // Mark the original equivalence as inactive and dead
+            tab_ctx.kill_line(i);
 
-            special_predicates.clear();
+            // Append new target tablines to the tableau
+            tab_ctx.tableau.push_back(new_tabline_P_implies_Q);
+            tab_ctx.tableau.push_back(new_tabline_Q_implies_P);
+
+            moved = true;
         }
-        else {
-            std::vector<node*> special_predicates;
-            node* negation = split_special(special_predicates, tabline.negation);
-            
-            // **Target Case:** Look for formulas of the form P ↔ Q
-            if (negation->is_equivalence()) {
-                // Increment count of cleanup moves
-                tab_ctx.cleanup++;
-        
-                node* P = negation->children[0];
-                node* Q = negation->children[1];
-
-                // Deep copy P and Q
-                node* P_copy1 = deep_copy(P);
-                node* P_copy2 = deep_copy(P);
-                node* Q_copy1 = deep_copy(Q);
-                node* Q_copy2 = deep_copy(Q);
-                std::vector<node*> children1, children2;
-                children1.push_back(P_copy1);
-                children1.push_back(Q_copy1);
-                children2.push_back(Q_copy2);
-                children2.push_back(P_copy2);
-                node* P_implies_Q = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, children1);
-                node* Q_implies_P = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, children2);
-
-                std::set<std::string> common_vars = find_common_variables(P_implies_Q, Q_implies_P);
-
-                // If there are common variables, rename them in the entire implication_copy
-                if (!common_vars.empty()) {
-                    // Create a rename list based on common variables
-                    std::vector<std::pair<std::string, std::string>> rename_list = vars_rename_list(tab_ctx, common_vars);
-
-                    // Rename variables in the entire implication_copy
-                     rename_vars(Q_implies_P, rename_list);
-                }
 
-                node* neg1 = negate_node(deep_copy(P_implies_Q));
-                node* neg2 = negate_node(deep_copy(Q_implies_P));
-                P_implies_Q = reapply_special(special_predicates, P_implies_Q);
-                Q_implies_P = reapply_special(special_predicates, Q_implies_P);
-                neg1 = reapply_special(special_predicates, neg1);
-                neg2 = reapply_special(special_predicates, neg2);
-                
-                // Create new target tablines
-                tabline_t new_tabline_P_implies_Q(neg1, P_implies_Q);
-                tabline_t new_tabline_Q_implies_P(neg2, Q_implies_P);
-                
-                // Copy restrictions and assumptions
-                new_tabline_P_implies_Q.assumptions = tabline.assumptions;
-                new_tabline_P_implies_Q.restrictions = tabline.restrictions;
-                new_tabline_Q_implies_P.assumptions = tabline.assumptions;
-                new_tabline_Q_implies_P.restrictions = tabline.restrictions;
-                
-                // Set justifications
-                new_tabline_P_implies_Q.justification = { Reason::MaterialEquivalence, { static_cast<int>(i) } };
-                new_tabline_Q_implies_P.justification = { Reason::MaterialEquivalence, { static_cast<int>(i) } };
+        special_predicates.clear();
+    }
+    else {
+        std::vector<node*> special_predicates;
+        node* negation = split_special(special_predicates, tabline.negation);
+        
+        // **Target Case:** Look for formulas of the form P ↔ Q
+        if (negation->is_equivalence()) {
+            // Increment count of cleanup moves
+            tab_ctx.cleanup++;
+    
+            node* P = negation->children[0];
+            node* Q = negation->children[1];
+
+            // Deep copy P and Q
+            node* P_copy1 = deep_copy(P);
+            node* P_copy2 = deep_copy(P);
+            node* Q_copy1 = deep_copy(Q);
+            node* Q_copy2 = deep_copy(Q);
+            std::vector<node*> children1, children2;
+            children1.push_back(P_copy1);
+            children1.push_back(Q_copy1);
+            children2.push_back(Q_copy2);
+            children2.push_back(P_copy2);
+            node* P_implies_Q = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, children1);
+            node* Q_implies_P = new node(LOGICAL_BINARY, SYMBOL_IMPLIES, children2);
+
+            std::set<std::string> common_vars = find_common_variables(P_implies_Q, Q_implies_P);
+
+            // If there are common variables, rename them in the entire implication_copy
+            if (!common_vars.empty()) {
+                // Create a rename list based on common variables
+                std::vector<std::pair<std::string, std::string>> rename_list = vars_rename_list(tab_ctx, common_vars);
+
+                // Rename variables in the entire implication_copy
+                 rename_vars(Q_implies_P, rename_list);
+            }
 
-                // **Critical Fix: Set flags before hydra operations**
-                // Already set flags before modifying the vector
+            node* neg1 = negate_node(deep_copy(P_implies_Q));
+            node* neg2 = negate_node(deep_copy(Q_implies_P));
+            P_implies_Q = reapply_special(special_predicates, P_implies_Q);
+            Q_implies_P = reapply_special(special_predicates, Q_implies_P);
+            neg1 = reapply_special(special_predicates, neg1);
+            neg2 = reapply_special(special_predicates, neg2);
+            
+            // Create new target tablines
+            tabline_t new_tabline_P_implies_Q(neg1, P_implies_Q);
+            tabline_t new_tabline_Q_implies_P(neg2, Q_implies_P);
+            
+            // Copy restrictions and assumptions
+            new_tabline_P_implies_Q.assumptions = tabline.assumptions;
+            new_tabline_P_implies_Q.restrictions = tabline.restrictions;
+            new_tabline_Q_implies_P.assumptions = tabline.assumptions;
+            new_tabline_Q_implies_P.restrictions = tabline.restrictions;
+            
+            // Set justifications
+            new_tabline_P_implies_Q.justification = { Reason::MaterialEquivalence, { static_cast<int>(i) } };
+            new_tabline_Q_implies_P.justification = { Reason::MaterialEquivalence, { static_cast<int>(i) } };
 
-                // Mark the original equivalence as inactive and dead
-                tabline.active = false;
-                tabline.dead = true;
+            // **Critical Fix: Set flags before hydra operations**
+            // Already set flags before modifying the vector
 
-                // Append new target tablines to the tableau
-                tab_ctx.tableau.push_back(new_tabline_P_implies_Q);
-                tab_ctx.tableau.push_back(new_tabline_Q_implies_P);
-                
-                // Split the hydra and select targets
-                tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
-                tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
-                tab_ctx.select_targets();
+            // Mark the original equivalence as inactive and dead
+            tab_ctx.kill_line(i);
 
-                moved = true;
-            }
+            // Append new target tablines to the tableau
+            tab_ctx.tableau.push_back(new_tabline_P_implies_Q);
+            tab_ctx.tableau.push_back(new_tabline_Q_implies_P);
+            
+            // Split the hydra and select targets
+            tab_ctx.hydra_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+            tab_ctx.restrictions_split(i, tab_ctx.tableau.size() - 2, tab_ctx.tableau.size() - 1);
+            tab_ctx.select_targets();
 
-            special_predicates.clear();
+            moved = true;
         }
 
-        i++;
+        special_predicates.clear();
+    }
+
+    return moved;
+}
+
+bool move_me(context_t& tab_ctx, size_t start) {
+    bool moved = false;
+
+    for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
+        if (move_me_line(tab_ctx, i)) {
+            moved = true;
+        }
     }
 
     return moved;
@@ -1934,7 +2135,7 @@ bool conditional_premise(context_t& tab_ctx, int index) {
     new_hypothesis.restrictions.push_back(static_cast<int>(tab_ctx.tableau.size() + 1));
 
     // Deactivate the original formula (must be done before invalidating tableau with push_backs)
-    tabline.active = false;
+    tab_ctx.set_active(index, false);
 
     // Append new hypothesis and target to the tableau
     tab_ctx.tableau.push_back(new_hypothesis);
@@ -1950,29 +2151,33 @@ bool conditional_premise(context_t& tab_ctx, int index) {
     return true;
 }
 
+static bool move_cp_line(context_t& tab_ctx, size_t i) {
+    tabline_t& tabline = tab_ctx.tableau[i];
+
+    if (tabline.active && tabline.target) {
+        // Ensure the negation field exists and is an implication
+        if (tabline.negation && unwrap_special(tabline.negation)->is_implication()) {
+            // Increment count of cleanup moves
+            tab_ctx.cleanup++;
+
+            // **Critical Fix: Set flags before modifying the vector**
+            // Mark the original target as inactive and dead
+            tab_ctx.kill_line(i);
+
+            // Apply conditional_premise
+            return conditional_premise(tab_ctx, i);
+        }
+    }
+
+    return false;
+}
+
 bool move_cp(context_t& tab_ctx, size_t start) {
     bool moved = false;
 
     for (size_t i = start; i < tab_ctx.tableau.size(); ++i) {
-        tabline_t& tabline = tab_ctx.tableau[i];
-
-        if (tabline.active && tabline.target) {
-            // Ensure the negation field exists and is an implication
-            if (tabline.negation && unwrap_special(tabline.negation)->is_implication()) {
-                // Increment count of cleanup moves
-                tab_ctx.cleanup++;
-
-                // **Critical Fix: Set flags before modifying the vector**
-                // Mark the original target as inactive and dead
-                tabline.active = false;
-                tabline.dead = true;
-
-                // Apply conditional_premise
-                bool success = conditional_premise(tab_ctx, i);
-                if (success) {
-                    moved = true;
-                }
-            }
+        if (move_cp_line(tab_ctx, i)) {
+            moved = true;
         }
     }
 
@@ -2046,7 +2251,7 @@ bool move_sd(context_t& tab_ctx, size_t line) {
     hyp2b.restrictions = tabline.restrictions;
     
     // Deactivate the original formula
-    tabline.active = false;
+    tab_ctx.set_active(line, false);
     tabline.split = true;
 
     // Append new hypothesises to the tableau
@@ -2059,150 +2264,98 @@ bool move_sd(context_t& tab_ctx, size_t line) {
     return true;
 }
 
-bool cleanup_moves(context_t& tab_ctx, size_t start_line) {
-    bool moved = false, moved1;
-    size_t start = start_line;
-    size_t current_size = tab_ctx.tableau.size();
+// Classifies a line once by the top level shape of its matrix and applies the
+// single cleanup move for that shape, after skolemizing it. Where several moves
+// share a shape they are tried in the order the individual passes used to run.
+static bool cleanup_line(context_t& tab_ctx, size_t i) {
+    bool moved = skolemize_line(tab_ctx, i);
 
-    tab_ctx.kill_duplicates(start);
-    tab_ctx.get_ltor();
-    
-    while (start < current_size) {
-        // Apply moves in the specified order
+    const tabline_t& tabline = tab_ctx.tableau[i];
 
-        // 1. skolemize_all
-        moved1 = false;
-        if (skolemize_all(tab_ctx, start)) {
-            moved = moved1 = true;
-        }
+    if (!tabline.active || tabline.is_theorem() || tabline.is_definition()) {
+        return moved;
+    }
 
-#if DEBUG_CLEANUP
-        if (moved1) {
-            std::cout << "skolemize:" << std::endl;
-            print_tableau(tab_ctx);
-            std::cout << std::endl;
-        }
-#endif
+    if (tabline.target) {
+        node* negation = unwrap_special(tabline.negation);
+        node* formula = unwrap_special(tabline.formula);
 
-        // 2. move_me
-        moved1 = false;
-        if (move_me(tab_ctx, start)) {
-            moved = moved1 = true;
+        if (negation->is_equivalence()) {
+            return move_me_line(tab_ctx, i) || moved;
         }
 
- #if DEBUG_CLEANUP
-        if (moved1) {
-            std::cout << "material equivalence:" << std::endl;
-            print_tableau(tab_ctx);
-            std::cout << std::endl;
-        }
-#endif
-        // 3. move_cp
-        moved1 = false;
-        if (move_cp(tab_ctx, start)) {
-            moved = moved1 = true;
+        if (negation->is_implication()) {
+            return move_cp_line(tab_ctx, i) || moved;
         }
 
-#if DEBUG_CLEANUP
-        if (moved1) {
-            std::cout << "conditional premise:" << std::endl;
-            print_tableau(tab_ctx);
-            std::cout << std::endl;
+        if (formula->is_disjunction()) {
+            return move_sc_line(tab_ctx, i) || move_ci_line(tab_ctx, i) || moved;
         }
-#endif
 
-        // 4. move_sc
-        moved1 = false;
-        if (move_sc(tab_ctx, start)) {
-            moved = moved1 = true;
+        if (formula->is_implication()) {
+            return move_ni_line(tab_ctx, i) || moved;
         }
 
-#if DEBUG_CLEANUP
-        if (moved1) {
-            std::cout << "split conjunctions:" << std::endl;
-            print_tableau(tab_ctx);
-            std::cout << std::endl;
+        if (formula->is_conjunction()) {
+            return move_sdi_line(tab_ctx, i) || move_sci_line(tab_ctx, i) ||
+                   move_di_line(tab_ctx, i) || moved;
         }
-#endif
+    } else {
+        node* formula = unwrap_special(tabline.formula);
 
-        // 5. move_ni
-        moved1 = false;
-        if (move_ni(tab_ctx, start)) {
-            moved = moved1 = true;
+        if (formula->is_equivalence()) {
+            return move_me_line(tab_ctx, i) || moved;
         }
 
-#if DEBUG_CLEANUP
-        if (moved1) {
-            std::cout << "negated implication:" << std::endl;
-            print_tableau(tab_ctx);
-            std::cout << std::endl;
+        if (formula->is_conjunction()) {
+            return move_sc_line(tab_ctx, i) || move_ci_line(tab_ctx, i) || moved;
         }
-#endif
 
-        // 6. move_sdi
-        moved1 = false;
-        if (move_sdi(tab_ctx, start)) {
-            moved = moved1 = true;
+        if (formula->is_negation()) {
+            return move_ni_line(tab_ctx, i) || moved;
         }
 
-#if DEBUG_CLEANUP
-        if (moved1) {
-            std::cout << "split disjunctive implication:" << std::endl;
-            print_tableau(tab_ctx);
-            std::cout << std::endl;
+        if (formula->is_implication()) {
+            return move_sdi_line(tab_ctx, i) || move_sci_line(tab_ctx, i) ||
+                   move_di_line(tab_ctx, i) || moved;
         }
-#endif
 
-        // 7. move_sci
-        moved1 = false;
-        if (move_sci(tab_ctx, start)) {
-            moved = moved1 = true;
+        if (formula->is_disjunction()) {
+            return move_di_line(tab_ctx, i) || moved;
         }
+    }
 
-#if DEBUG_CLEANUP
-        if (moved1) {
-            std::cout << "split conjunctive implication:" << std::endl;
-            print_tableau(tab_ctx);
-            std::cout << std::endl;
-        }
-#endif
+    return moved;
+}
 
-        // 8. move_di
-        moved1 = false;
-        if (move_di(tab_ctx, start)) {
-            moved = moved1 = true;
-        }
+bool cleanup_moves(context_t& tab_ctx, size_t start_line) {
+    bool moved = false;
 
-#if DEBUG_CLEANUP
-        if (moved1) {
-            std::cout << "disjunctive idempotence:" << std::endl;
-            print_tableau(tab_ctx);
-            std::cout << std::endl;
+    tab_ctx.kill_duplicates(start_line);
+    tab_ctx.get_ltor();
+    
+    // Each line is dispatched exactly once, lines added by a move are queued at
+    // the end of the tableau and are reached by the same loop
+    for (size_t i = start_line; i < tab_ctx.tableau.size(); ++i) {
+        // A cleanup move adds at most two lines, make sure that can't reallocate
+        // the tableau while the move holds a reference to line i
+        if (tab_ctx.tableau.capacity() < tab_ctx.tableau.size() + 2) {
+            tab_ctx.tableau.reserve(2*tab_ctx.tableau.size() + 2);
         }
-#endif
 
-        // 9. move_ci
-        moved1 = false;
-        if (move_ci(tab_ctx, start)) {
-            moved = moved1 = true;
-        }
+        if (cleanup_line(tab_ctx, i)) {
+            moved = true;
 
 #if DEBUG_CLEANUP
-        if (moved1) {
-            std::cout << "conjunctive idempotence:" << std::endl;
+            std::cout << "cleanup line " << i + 1 << ":" << std::endl;
             print_tableau(tab_ctx);
             std::cout << std::endl;
-        }
 #endif
-
-        tab_ctx.kill_duplicates(start);
-        tab_ctx.get_ltor();
-    
-        // Update start_line to previous current_size before moves were applied
-        start = current_size;
-        // Update current_size to the new size of the tableau
-        current_size = tab_ctx.tableau.size();
+        }
     }
+
+    tab_ctx.kill_duplicates(start_line);
+    tab_ctx.get_ltor();
     
     // Updates constants fields of all lines, starting at upto
     tab_ctx.get_constants();
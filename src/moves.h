@@ -5,6 +5,7 @@
 #include "context.h"
 #include "substitute.h"
 #include "unify.h"
+#include "rewrite.h"
 #include <vector>
 #include <string>
 
@@ -22,10 +23,12 @@ void parameterize_all(context_t& tab_ctx);
 // with the new substitution that must be performed by the caller
 node* skolemize(context_t& ctx, node* formula, const std::vector<std::string>& universals, Substitution& subst);
 
-// Skolemizes an arbitrary formula, returning the result
-node* skolem_form(context_t& ctx, node* formula);
+// Skolemizes an arbitrary formula, returning the result. If copy is not null it
+// is set to an independent copy of the result, built in the same traversal, e.g.
+// for negating a target
+node* skolem_form(context_t& ctx, node* formula, node** copy = nullptr);
 
-// Skolemizes all active formulas
+// Skolemizes all active formulas which are not yet marked as skolemized
 bool skolemize_all(context_t& tab_ctx, size_t start = 0);
 
 // Applies modus ponens to the given implication and unit clauses.
@@ -34,10 +37,14 @@ bool skolemize_all(context_t& tab_ctx, size_t start = 0);
 // - unit_clauses: The unit clause formula list P_1, Q_1, ..., R_1.
 // - ctx_var: The context for variable indexing and renaming.
 // - combined_subst: a presumably empty Substitution structure, which will be assigned
-//   with all substitutions made by modus_ponens
+//   with all substitutions made by modus_ponens to variables of the implication
+// - specials: optional special predicates peeled off the lines, each with its bank, 0
+//   for the implication and i + 1 for unit clause i. On success each is replaced by a
+//   new node with the substitutions made to the variables of its line applied.
 // Returns:
 // - A new node representing the result of modus ponens, or nullptr if unification fails.
-node* modus_ponens(Substitution& combined_subst, context_t& ctx_var, node* implication, const std::vector<node*>& unit_clauses, bool silent=false);
+node* modus_ponens(Substitution& combined_subst, context_t& ctx_var, node* implication, const std::vector<node*>& unit_clauses, bool silent=false,
+                   std::vector<std::pair<node*, int>>* specials=nullptr);
 
 // Applies modus tollens to the given implication and unit clauses.
 // Parameters:
@@ -45,10 +52,12 @@ node* modus_ponens(Substitution& combined_subst, context_t& ctx_var, node* impli
 // - unit_clauses: The unit clause formula list P_1, Q_1, ..., R_1.
 // - ctx_var: The context for variable indexing and renaming.
 // - combined_subst: a presumably empty Substitution structure, which will be assigned
-//   with all substitutions made by modus_ponens
+//   with all substitutions made by modus_ponens to variables of the implication
+// - specials: optional special predicates peeled off the lines, as for modus_ponens
 // Returns:
 // - A new node representing the result of modus ponens, or nullptr if unification fails.
-node* modus_tollens(Substitution& combined_subst, context_t& ctx_var, node* implication, const std::vector<node*>& unit_clauses, bool silent=false);
+node* modus_tollens(Substitution& combined_subst, context_t& ctx_var, node* implication, const std::vector<node*>& unit_clauses, bool silent=false,
+                    std::vector<std::pair<node*, int>>* specials=nullptr);
 
 // Performs modus ponens\tollens on specified lines where implication_line is the line
 // number of the implication, other_lines are the line numbers of the unit lines,
@@ -62,6 +71,10 @@ bool move_mpt(context_t& ctx, int implication_line, const std::vector<int>& othe
 // rewrite_line in the tableau
 bool move_rewrite(context_t& ctx, int formula_line, int rewrite_line, bool silent=false);
 
+// Rewrite the formula with index formula_line to normal form using all the rewrite
+// rules with the given indices in the tableau
+bool move_normalise(context_t& ctx, int formula_line, const std::vector<int>& rewrite_lines, bool silent=false);
+
 // Function to apply disjunctive idempotence: P ∨ P -> P
 bool move_di(context_t& tab_ctx, size_t start = 0);
 
@@ -92,7 +105,8 @@ bool conditional_premise(context_t& tab_ctx, int index);
 // Apply conditional premise to all lines
 bool move_cp(context_t& tab_ctx, size_t start = 0);
 
-// Apply all cleanup moves
+// Apply all cleanup moves, each line from start_line on is classified once by its
+// shape and handed to the matching move, new lines are processed as they appear
 bool cleanup_moves(context_t& tab_ctx, size_t start_line = 0);
 
 // Apply only skolemize and move_me for definitions
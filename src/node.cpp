@@ -3,6 +3,7 @@
 #include "node.h"
 #include <stdexcept>
 #include <iostream>
+#include <cctype>
 
 variable_data* deep_copy(variable_data* vdata) {
     return new variable_data{vdata->var_kind, vdata->bound, vdata->shared, vdata->structure, vdata->arity, vdata->name};
@@ -257,18 +258,112 @@ void mark_shared(node* current, const std::set<std::string>& var_names) {
     }
 }
 
-void vars_used(std::set<std::string>& variables, const node* root, bool include_params, bool include_bound) {
-    // If the current node is a VARIABLE, add its name to the set
-    if (root->type == VARIABLE && (root->vdata->var_kind == INDIVIDUAL || root->vdata->var_kind == PARAMETER) &&
-            (include_params || (root->vdata->var_kind != PARAMETER && root->vdata->var_kind != FUNCTION)) &&
-            (include_bound || !root->vdata->bound)) {
-        variables.insert(root->name());
+uint64_t var_bit(const std::string& name) {
+    return uint64_t(1) << (std::hash<std::string>()(name) % 64);
+}
+
+// What annotate_node gathers besides the depths. Variables are collected as by vars_used
+// with the given flags, only if collect_vars is set.
+struct annotation {
+    bool collect_vars = true;
+    bool include_params = false;
+    bool include_bound = false;
+    bool hash = true;                 // Whether to compute the structural hash
+    std::vector<const std::string*> binders; // Variables bound by the enclosing quantifiers, innermost last
+    std::vector<std::string> vars;
+    uint64_t var_mask = 0;
+    bool shared = false;
+};
+
+// Returns the structural hash of the node, or 0 if not asked for, and accumulates the
+// other properties. Bound individual variables are hashed by how many quantifiers out
+// they are bound, not by name, so that formulas equal up to renaming them hash equally.
+static size_t annotate_node(const node* n, annotation& a, size_t& depth, size_t& term_depth) {
+    size_t hash = 0;
+
+    if (n->type == VARIABLE) {
+        VariableKind kind = n->vdata->var_kind;
+        if (a.collect_vars && (kind == INDIVIDUAL || kind == PARAMETER) &&
+                (a.include_params || kind != PARAMETER) && (a.include_bound || !n->vdata->bound)) {
+            a.vars.push_back(n->vdata->name);
+        }
+        if (kind == INDIVIDUAL) {
+            a.var_mask |= var_bit(n->vdata->name);
+            a.shared |= n->vdata->shared;
+        }
     }
 
-    // Recursively traverse all child nodes
-    for (const auto& child : root->children) {
-        vars_used(variables, child, include_params, include_bound);
+    if (a.hash) {
+        hash = static_cast<size_t>(n->type) * 31 + static_cast<size_t>(n->symbol);
+        if (n->type == VARIABLE) {
+            size_t index = 0;
+            if (n->vdata->var_kind == INDIVIDUAL) {
+                for (size_t i = a.binders.size(); i > 0; --i) {
+                    if (*a.binders[i - 1] == n->vdata->name) {
+                        index = a.binders.size() - i + 1;
+                        break;
+                    }
+                }
+            }
+            hash = hash * 31 + (index ? index : std::hash<std::string>()(n->vdata->name));
+            hash = hash * 31 + static_cast<size_t>(n->vdata->var_kind);
+        }
+    }
+
+    // The variable of a quantifier is bound in all of its children, itself included
+    bool binds = a.hash && n->type == QUANTIFIER && !n->children.empty() &&
+                 n->children[0]->type == VARIABLE;
+    if (binds) {
+        a.binders.push_back(&n->children[0]->vdata->name);
+    }
+
+    size_t max_depth = 0, max_child_term_depth = 0;
+    for (const node* child : n->children) {
+        size_t child_depth, child_term_depth;
+        size_t child_hash = annotate_node(child, a, child_depth, child_term_depth);
+        if (a.hash) {
+            hash = hash * 1000003 ^ child_hash;
+        }
+        max_depth = std::max(max_depth, child_depth);
+        max_child_term_depth = std::max(max_child_term_depth, child_term_depth);
+    }
+
+    if (binds) {
+        a.binders.pop_back();
     }
+
+    depth = max_depth + 1;
+    term_depth = n->is_term() ? depth : max_child_term_depth;
+
+    return hash;
+}
+
+node_info annotate(const node* formula) {
+    node_info info;
+    annotation a;
+
+    info.hash = annotate_node(formula, a, info.depth, info.term_depth);
+
+    std::sort(a.vars.begin(), a.vars.end());
+    a.vars.erase(std::unique(a.vars.begin(), a.vars.end()), a.vars.end());
+    info.free_vars = std::move(a.vars);
+    info.ground = info.free_vars.empty();
+    info.var_mask = a.var_mask;
+    info.shared = a.shared;
+
+    return info;
+}
+
+void vars_used(std::set<std::string>& variables, const node* root, bool include_params, bool include_bound) {
+    annotation a;
+    a.include_params = include_params;
+    a.include_bound = include_bound;
+    a.hash = false;
+
+    size_t depth, term_depth;
+    annotate_node(root, a, depth, term_depth);
+
+    variables.insert(a.vars.begin(), a.vars.end());
 }
 
 // Function to find common variables between two formulas
@@ -292,17 +387,7 @@ std::set<std::string> find_common_variables(const node* formula1, const node* fo
 }
 
 bool node::has_shared_vars() const {
-    if (is_shared_variable()) {
-        return true;
-    }
-
-    for (node* n : children) {
-        if (n->has_shared_vars()) {
-            return true;
-        }
-    }
-
-    return false;
+    return annotate(this).shared;
 }
 
 std::string remove_subscript(const std::string& var_name) {
@@ -358,6 +443,191 @@ std::string append_unicode_subscript(const std::string& base, int index) {
     return base + subscript;
 }
 
+// Write a variable name, with a subscript 0-9 in unicode
+static void write_unicode_name(std::ostream& os, const std::string& name) {
+    size_t pos = name.rfind('_');
+    if (pos != std::string::npos && pos + 1 < name.size()) {
+        int index = 0;
+        bool all_digits = true;
+        for (size_t i = pos + 1; i < name.size() && all_digits; ++i) {
+            all_digits = std::isdigit(static_cast<unsigned char>(name[i]));
+            index = std::min(10 * index + (name[i] - '0'), 10); // only 0-9 are needed
+        }
+
+        if (all_digits && index <= 9) {
+            const char subscript[] = { static_cast<char>(0xE2), static_cast<char>(0x82), static_cast<char>(0x80 + index) };
+            os.write(name.data(), pos);
+            os.write(subscript, sizeof(subscript));
+            return;
+        }
+    }
+
+    os << name;
+}
+
+bool node::needs_parentheses(const node *child, ChildPosition position) const {
+    symbol_enum parent_symbol = type == APPLICATION ? children[0]->symbol : symbol;
+    symbol_enum child_symbol = child->type == APPLICATION ? child->children[0]->symbol : child->symbol;
+
+    const PrecedenceInfo& parentPrecInfo = getPrecedenceInfo(parent_symbol);
+    const PrecedenceInfo& childPrecInfo = getPrecedenceInfo(child_symbol);
+
+    // If the child is a simple variable or constant, it is written as is
+    if (child->type == VARIABLE || child->type == CONSTANT ||
+        child->type == TUPLE || child->type == QUANTIFIER ||
+         (child->type == APPLICATION && childPrecInfo.fixity == Fixity::FUNCTIONAL)) {
+        return false;
+    }
+
+    // Handle parentheses based on precedence and associativity
+    if (childPrecInfo.precedence < parentPrecInfo.precedence) {
+        return false;
+    }
+
+    if (childPrecInfo.precedence == parentPrecInfo.precedence) {
+        return (parent_symbol != child_symbol) ||
+               (parentPrecInfo.associativity == Associativity::LEFT && position == ChildPosition::RIGHT) ||
+               (parentPrecInfo.associativity == Associativity::RIGHT && position == ChildPosition::LEFT);
+    }
+
+    return true;
+}
+
+void node::write_child(std::ostream& os, const node *child, OutputFormat format, ChildPosition position) const {
+    if (needs_parentheses(child, position)) {
+        os << "(";
+        child->write(os, format);
+        os << ")";
+    } else {
+        child->write(os, format);
+    }
+}
+
+void node::write(std::ostream& os, OutputFormat format) const {
+    const PrecedenceInfo& precInfo = getPrecedenceInfo(symbol);
+    const std::string_view op = format == REPR ? precInfo.repr : precInfo.unicode;
+
+    switch (type) {
+        case VARIABLE:
+            if (format == UNICODE) {
+                write_unicode_name(os, vdata->name);
+                if (vdata->var_kind == INDIVIDUAL && !vdata->bound) {
+                     os << "'";
+                }
+            } else { // REPR
+                os << vdata->name;
+            }
+            break;
+        case CONSTANT:
+            os << op;
+            break;
+        case LOGICAL_UNARY:
+            if (symbol == SYMBOL_NOT && children[0]->type == APPLICATION &&
+                children[0]->children[0]->type == BINARY_PRED &&
+                children[0]->children[0]->symbol == SYMBOL_EQUALS) { // neq
+                    children[0]->children[1]->write(os, format);
+                    os << (format == REPR ? " \\neq " : " ≠ ");
+                    children[0]->children[2]->write(os, format);
+            } else {
+                os << op;
+                if (format == REPR) {
+                    os << " ";
+                }
+                write_child(os, children[0], format, ChildPosition::LEFT);
+            }
+            break;
+        case LOGICAL_BINARY:
+            if (is_special_implication()) {
+                // print special constraints in square brackets
+                const node* special = children[0];
+                const node* formula = children[1];
+                os << "[";
+                special->children[1]->write(os, format);
+                os << ":";
+                special->children[0]->write(os, format);
+                while (formula->is_special_implication()) {
+                    special = formula->children[0];
+                    formula = formula->children[1];
+                    os << ", ";
+                    special->children[1]->write(os, format);
+                    os << ":";
+                    special->children[0]->write(os, format);
+                }
+                os << "] ";
+                formula->write(os, format);
+            } else {
+                write_child(os, children[0], format, ChildPosition::LEFT);
+                os << " " << op << " ";
+                write_child(os, children[1], format, ChildPosition::RIGHT);
+            }
+            break;
+        case APPLICATION:
+            if (children[0]->is_predicate() && children[0]->vdata->structure) {
+                children[1]->write(os, format);
+                os << ":";
+                children[0]->write(os, format);
+            } else {
+                // If the operator is a variable or application
+                children[0]->write(os, format); // Print the operator
+                os << "(";
+                for (size_t i = 1; i < children.size(); ++i) {
+                    if (i > 1) os << ", ";
+                    children[i]->write(os, format);  // Print the arguments
+                }
+                os << ")";
+            }
+            break;
+        case BINARY_PRED:
+        case BINARY_OP:
+            if (precInfo.fixity == Fixity::INFIX) {
+                write_child(os, children[0], format, ChildPosition::LEFT);
+                os << " " << op << " "; // Print the operator
+                write_child(os, children[1], format, ChildPosition::RIGHT);
+            }
+            break;
+        case UNARY_PRED:
+        case UNARY_OP:
+            if (precInfo.fixity == Fixity::FUNCTIONAL) {
+                    os << op << "(";
+                    children[0]->write(os, format);  // Print the argument
+                    os << ")";
+            }
+            break;
+        case TUPLE:
+            os << "(";
+            for (size_t i = 0; i < children.size(); ++i) {
+                if (i > 0) os << ", ";
+                children[i]->write(os, format);
+            }
+            os << ")";
+            break;
+        case QUANTIFIER:
+            os << op;
+            if (format == REPR) {
+                os << " ";
+            }
+            if (is_special_binder()) {
+                const node* special = children[1]->children[0];
+                special->children[1]->write(os, format);
+                os << ":";
+                special->children[0]->write(os, format);
+                os << " ";
+                write_child(os, children[1]->children[1], format, ChildPosition::BODY);
+            } else if (is_element_quantifier()) {
+                children[1]->children[0]->write(os, format);
+                os << " ";
+                write_child(os, children[1]->children[1], format, ChildPosition::BODY);
+            } else {
+                children[0]->write(os, format);
+                os << " ";
+                write_child(os, children[1], format, ChildPosition::BODY);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
 // Rename all variables according to a list of renames
 void rename_vars(node* root, const std::vector<std::pair<std::string, std::string>>& renaming_pairs) {
     // Check if the current node is a VARIABLE and needs renaming
@@ -600,17 +870,10 @@ void node_get_constants(std::vector<std::string>& constants, const node* formula
     if (std::find(constant_node_types.begin(), constant_node_types.end(), formula->type) != constant_node_types.end()) {
         symbol_enum sym = formula->symbol;
         if (sym >= SYMBOL_EQUALS) { // Assuming constants are ordered after SYMBOL_EQUALS
-            // Find the Unicode representation from precedenceTable
-            auto it = precedenceTable.find(sym);
-            if (it != precedenceTable.end()) {
-                const std::string& unicode_str = it->second.unicode;
-                // Add the constant if it's not already in the list
-                if (std::find(constants.begin(), constants.end(), unicode_str) == constants.end()) {
-                    constants.push_back(unicode_str);
-                }
-            }
-            else {
-                std::cerr << "Warning: Symbol not found in precedenceTable." << std::endl;
+            const std::string_view unicode_str = precedenceTable[sym].unicode;
+            // Add the constant if it's not already in the list
+            if (std::find(constants.begin(), constants.end(), unicode_str) == constants.end()) {
+                constants.emplace_back(unicode_str);
             }
         }
     }
@@ -624,45 +887,18 @@ void node_get_constants(std::vector<std::string>& constants, const node* formula
 // Return true if all variables on right side of implication are found on the left side
 // and max_term_size of right side is at most that of the left side
 void left_to_right(bool& ltor, bool& rtol, bool& ltor_safe, bool& rtol_safe, const node* implication) {
-    // Extract left (premise) and right (conclusion) sub-nodes
-    const node* premise = implication->children[0];
-    const node* conclusion = implication->children[1];
-    
-    // Retrieve variables used in premise and conclusion
-    std::set<std::string> premise_vars;
-    vars_used(premise_vars, premise, false, false);
-
-    std::set<std::string> conclusion_vars;
-    vars_used(conclusion_vars, conclusion, false, false);
-
-    size_t left_term_depth = max_term_depth(premise);
-    size_t right_term_depth = max_term_depth(conclusion);
-
-    ltor_safe = right_term_depth <= left_term_depth;
-    
-    ltor = true;
-    
-    // Check if all variables in conclusion are present in premise
-    for (const auto& var : conclusion_vars) {
-        if (premise_vars.find(var) == premise_vars.end()) {
-            // Variable in conclusion not found in premise
-            ltor = false;
-            break;
-        }
-    }
-
-    rtol_safe = left_term_depth <= right_term_depth;
-    
-    rtol = true;
-
-    // Check if all variables in conclusion are present in premise
-    for (const auto& var : premise_vars) {
-        if (conclusion_vars.find(var) == conclusion_vars.end()) {
-            // Variable in conclusion not found in premise
-            rtol = false;
-            break;
-        }
-    }
+    // Variables and term depths of the premise and conclusion
+    node_info premise = annotate(implication->children[0]);
+    node_info conclusion = annotate(implication->children[1]);
+
+    ltor_safe = conclusion.term_depth <= premise.term_depth;
+    rtol_safe = premise.term_depth <= conclusion.term_depth;
+
+    // Check if all variables in conclusion are present in premise and vice versa
+    ltor = std::includes(premise.free_vars.begin(), premise.free_vars.end(),
+                         conclusion.free_vars.begin(), conclusion.free_vars.end());
+    rtol = std::includes(conclusion.free_vars.begin(), conclusion.free_vars.end(),
+                         premise.free_vars.begin(), premise.free_vars.end());
 }
 
 // Given a formula which is wrapped in special implications, remove the
@@ -737,18 +973,13 @@ size_t formula_depth(const node* formula) {
 
 // Return the maximum term depth of a formula
 size_t max_term_depth(const node* formula) {
-    if (formula->is_term()) {
-        return formula_depth(formula);
-    }
+    annotation a;
+    a.collect_vars = false;
+    a.hash = false;
 
-    size_t max_depth = 0;
+    size_t depth, term_depth;
+    annotate_node(formula, a, depth, term_depth);
 
-    for (node* child : formula->children) {
-        size_t depth = max_term_depth(child);
-        if (depth > max_depth) {
-            max_depth = depth;
-        }
-    }
+    return term_depth;
+}
 
-    return max_depth;
-}
\ No newline at end of file
@@ -3,12 +3,14 @@
 
 #include "symbol_enum.h"
 #include "precedence.h"
+#include "node_list.h"
 #include <vector>
 #include <string>
 #include <sstream>
 #include <iostream>
 #include <set>
 #include <algorithm>
+#include <cstdint>
 
 enum OutputFormat {
     REPR,    // Re-parsable string format
@@ -59,7 +61,7 @@ public:
     node_type type;
     symbol_enum symbol;
     variable_data* vdata; // Pointer to vdata for VARIABLE nodes
-    std::vector<node*> children;
+    node_list children; // Inline storage for up to three children
 
     node(node_type t, const std::string& name)
         : type(VARIABLE), symbol(SYMBOL_NONE), vdata(new variable_data{INDIVIDUAL, false, false, false, 0, name}), children() {}
@@ -182,159 +184,34 @@ public:
     
     // Print function that accepts an OutputFormat enum
     void print(OutputFormat format = REPR) const {
-        std::cout << to_string(format) << std::endl;
+        write(std::cout, format);
+        std::cout << std::endl;
     }
 
+    // Write the formula to the stream in a single pass ("repr" or "unicode")
+    void write(std::ostream& os, OutputFormat format = REPR) const;
+
     // Helper to generate string based on format type ("repr" or "unicode")
     std::string to_string(OutputFormat format = REPR) const {
         std::ostringstream oss;
-        PrecedenceInfo precInfo = getPrecedenceInfo(symbol);
-
-        switch (type) {
-            case VARIABLE:
-                if (format == UNICODE) {
-                    int subscript = get_subscript(name());
-                    if (subscript >= 0 && subscript <= 9) {
-                        std::string base = remove_subscript(name());
-                        std::string subscript_unicode = append_unicode_subscript(base, subscript);
-                        oss << subscript_unicode;
-                    } else {
-                        oss << name();
-                    }
-                    if (vdata->var_kind == INDIVIDUAL && !vdata->bound) {
-                         oss << "'";
-                    }
-                } else { // REPR
-                    oss << name();
-                }
-                break;
-            case CONSTANT:
-                oss << (format == REPR ? precInfo.repr : precInfo.unicode);
-                break;
-            case LOGICAL_UNARY:
-                if (symbol == SYMBOL_NOT && children[0]->type == APPLICATION &&
-                    children[0]->children[0]->type == BINARY_PRED &&
-                    children[0]->children[0]->symbol == SYMBOL_EQUALS) { // neq
-                        oss << children[0]->children[1]->to_string(format) <<
-                           (format == REPR ? " \\neq " : " ≠ ") <<
-                           children[0]->children[2]->to_string(format);
-                } else {
-                    oss << (format == REPR ? precInfo.repr + " " : precInfo.unicode);
-                    oss << parenthesize(children[0], format, "left");
-                }
-                break;
-            case LOGICAL_BINARY:
-                if (is_special_implication()) {
-                    // print special constraints in square brackets
-                    node* special = children[0];
-                    node* formula = children[1];
-                    oss << "[";
-                    oss << special->children[1]->to_string(format) << ":" << special->children[0]->to_string(format);
-                    while (formula->is_special_implication()) {
-                        special = formula->children[0];
-                        formula = formula->children[1];
-                        oss << ", ";
-                        oss << special->children[1]->to_string(format) << ":" << special->children[0]->to_string(format);
-                    }
-                    oss << "] ";
-                    oss << formula->to_string(format);
-                } else {
-                    oss << parenthesize(children[0], format, "left") + " ";
-                    oss << (format == REPR ? precInfo.repr : precInfo.unicode);
-                    oss << " " << parenthesize(children[1], format, "right");
-                }
-                break;
-            case APPLICATION:
-                if (children[0]->is_predicate() && children[0]->vdata->structure) {
-                    oss << children[1]->to_string(format) << ":" << children[0]->to_string(format);
-                } else {
-                    // If the operator is a variable or application
-                    oss << children[0]->to_string(format) << "("; // Print the operator
-                    for (size_t i = 1; i < children.size(); ++i) {
-                        if (i > 1) oss << ", ";
-                        oss << children[i]->to_string(format);  // Print the arguments
-                    }
-                    oss << ")";
-                }
-                break;
-            case BINARY_PRED:
-            case BINARY_OP:
-                if (precInfo.fixity == Fixity::INFIX) {
-                    oss << parenthesize(children[0], format, "left") << " ";
-                    oss << (format == REPR ? precInfo.repr : precInfo.unicode) << " "; // Print the operator
-                    oss << parenthesize(children[1], format, "right");
-                }
-                break;
-            case UNARY_PRED:
-            case UNARY_OP:
-                if (precInfo.fixity == Fixity::FUNCTIONAL) {
-                        oss << (format == REPR ? precInfo.repr : precInfo.unicode) << "(";
-                        oss << children[0]->to_string(format);  // Print the argument
-                        oss << ")";
-                }
-                break;
-            case TUPLE:
-                oss << "(";
-                for (size_t i = 0; i < children.size(); ++i) {
-                    if (i > 0) oss << ", ";
-                    oss << children[i]->to_string(format);
-                }
-                oss << ")";
-                break;
-            case QUANTIFIER:
-                oss << (format == REPR ? precInfo.repr + " " : precInfo.unicode);
-                if (is_special_binder()) {
-                    node* special = children[1]->children[0];
-                    oss << special->children[1]->to_string(format) << ":" << special->children[0]->to_string(format) << " ";
-                    oss << parenthesize(children[1]->children[1], format, "true");
-                } else if (is_element_quantifier()) {
-                    oss << children[1]->children[0]->to_string(format) << " ";
-                    oss << parenthesize(children[1]->children[1], format, "true");
-                } else {
-                    oss << children[0]->to_string(format) << " ";
-                    oss << parenthesize(children[1], format, "true");
-                }
-                break;
-            default:
-                break;
-        }
+        write(oss, format);
         return oss.str();
     }
 
 private:
 
-    // Helper function to parenthesize based on precedence and associativity
-    std::string parenthesize(const node *child, OutputFormat format, const std::string& childPosition) const {
-        symbol_enum parent_symbol = type == APPLICATION ? children[0]->symbol : symbol;
-        symbol_enum child_symbol = child->type == APPLICATION ? child->children[0]->symbol : child->symbol;
+    // Position of a child relative to its parent's operator
+    enum class ChildPosition {
+        LEFT,
+        RIGHT,
+        BODY
+    };
 
-        PrecedenceInfo parentPrecInfo = getPrecedenceInfo(parent_symbol);
-        PrecedenceInfo childPrecInfo = getPrecedenceInfo(child_symbol);
-
-        // If the child is a simple variable or constant, return it as is
-        if (child->type == VARIABLE || child->type == CONSTANT ||
-            child->type == TUPLE || child->type == QUANTIFIER ||
-             (child->type == APPLICATION && childPrecInfo.fixity == Fixity::FUNCTIONAL)) {
-            return child->to_string(format);
-        }
+    // Helper function to decide parentheses based on precedence and associativity
+    bool needs_parentheses(const node *child, ChildPosition position) const;
 
-        // Handle parentheses based on precedence and associativity
-        if (childPrecInfo.precedence < parentPrecInfo.precedence) {
-            return child->to_string(format);
-        }
-
-        if (childPrecInfo.precedence == parentPrecInfo.precedence) {
-            if ((parent_symbol != child_symbol) ||
-                (parentPrecInfo.associativity == Associativity::LEFT && childPosition == "right") ||
-                (parentPrecInfo.associativity == Associativity::RIGHT && childPosition == "left")) {
-                return "(" + child->to_string(format) + ")";
-            } else {
-                return child->to_string(format);
-            }
-        }
-
-        return "(" + child->to_string(format) + ")";
-    }
+    // Write a child, parenthesized if necessary
+    void write_child(std::ostream& os, const node *child, OutputFormat format, ChildPosition position) const;
 };
 
 node* deep_copy(const node* n);
@@ -375,4 +252,24 @@ size_t formula_depth(const node* formula);
 
 size_t max_term_depth(const node* formula);
 
+// Properties of a formula or term gathered in a single traversal
+struct node_info {
+    std::vector<std::string> free_vars; // Sorted names of unbound individual variables, as vars_used(.., false, false)
+    size_t depth = 0;                   // As formula_depth
+    size_t term_depth = 0;              // As max_term_depth
+    bool ground = true;                 // Whether there are no free variables
+    size_t hash = 0;                    // Structural hash, the same for formulas differing only in the
+                                        // names of bound variables. Only a prefilter, equal must still be checked
+    uint64_t var_mask = 0;              // Union of var_bit of every individual variable, bound or free
+    bool shared = false;                // Whether any individual variable is shared, as has_shared_vars
+};
+
+// Gathers all of the above in one traversal. vars_used, find_common_variables,
+// max_term_depth and has_shared_vars use the same traversal.
+node_info annotate(const node* formula);
+
+// Bit standing for the variable name in a node_info::var_mask. A variable can only
+// occur in a formula if its bit is set in the formula's mask.
+uint64_t var_bit(const std::string& name);
+
 #endif // NODE_H
\ No newline at end of file
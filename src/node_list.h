@@ -0,0 +1,178 @@
+// node_list.h
+
+#ifndef NODE_LIST_H
+#define NODE_LIST_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <initializer_list>
+
+class node;
+
+// The children of a node. Up to three children are stored inline, which covers every
+// node type except applications and tuples with more arguments, so that most nodes
+// need no allocation for their children. Larger lists spill to the heap. Behaves like
+// the std::vector<node*> it replaces and converts to and from one.
+class node_list {
+public:
+    using value_type = node*;
+    using iterator = node**;
+    using const_iterator = node* const*;
+
+    node_list() {}
+
+    node_list(const std::vector<node*>& list) {
+        assign(list.begin(), list.end());
+    }
+
+    node_list(std::initializer_list<node*> list) {
+        assign(list.begin(), list.end());
+    }
+
+    node_list(const node_list& other) {
+        assign(other.begin(), other.end());
+    }
+
+    node_list(node_list&& other) noexcept {
+        take(other);
+    }
+
+    ~node_list() {
+        release();
+    }
+
+    node_list& operator=(const node_list& other) {
+        if (this != &other) {
+            length = 0;
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    node_list& operator=(node_list&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    node_list& operator=(const std::vector<node*>& list) {
+        length = 0;
+        assign(list.begin(), list.end());
+        return *this;
+    }
+
+    operator std::vector<node*>() const {
+        return std::vector<node*>(begin(), end());
+    }
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    node*& operator[](size_t i) { return data()[i]; }
+    node* operator[](size_t i) const { return data()[i]; }
+
+    node*& front() { return data()[0]; }
+    node* front() const { return data()[0]; }
+    node*& back() { return data()[length - 1]; }
+    node* back() const { return data()[length - 1]; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + length; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + length; }
+
+    void push_back(node* child) {
+        reserve(length + 1);
+        data()[length++] = child;
+    }
+
+    void emplace_back(node* child) {
+        push_back(child);
+    }
+
+    void pop_back() {
+        length--;
+    }
+
+    void clear() {
+        length = 0;
+    }
+
+    iterator insert(iterator pos, node* child) {
+        size_t i = pos - begin();
+        reserve(length + 1);
+        std::copy_backward(begin() + i, end(), end() + 1);
+        data()[i] = child;
+        length++;
+        return begin() + i;
+    }
+
+    iterator erase(iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(iterator first, iterator last) {
+        iterator new_end = std::copy(last, end(), first);
+        length = static_cast<uint32_t>(new_end - begin());
+        return first;
+    }
+
+    void reserve(size_t n) {
+        if (n <= capacity) {
+            return;
+        }
+
+        size_t new_capacity = std::max<size_t>(n, 2*capacity);
+        node** new_heap = new node*[new_capacity];
+        std::copy(begin(), end(), new_heap);
+        release();
+        heap = new_heap;
+        capacity = static_cast<uint32_t>(new_capacity);
+    }
+
+private:
+    static constexpr uint32_t INLINE_CAPACITY = 3;
+
+    union {
+        node* inline_children[INLINE_CAPACITY];
+        node** heap;
+    };
+    uint32_t length = 0;
+    uint32_t capacity = INLINE_CAPACITY;
+
+    node** data() { return capacity == INLINE_CAPACITY ? inline_children : heap; }
+    node* const* data() const { return capacity == INLINE_CAPACITY ? inline_children : heap; }
+
+    template <typename It>
+    void assign(It first, It last) {
+        reserve(length + (last - first));
+        for (; first != last; ++first) {
+            data()[length++] = *first;
+        }
+    }
+
+    void release() {
+        if (capacity != INLINE_CAPACITY) {
+            delete[] heap;
+            capacity = INLINE_CAPACITY;
+        }
+    }
+
+    void take(node_list& other) {
+        length = other.length;
+        capacity = other.capacity;
+        if (other.capacity == INLINE_CAPACITY) {
+            std::copy(other.inline_children, other.inline_children + other.length, inline_children);
+        } else {
+            heap = other.heap;
+            other.capacity = INLINE_CAPACITY;
+        }
+        other.length = 0;
+    }
+};
+
+#endif // NODE_LIST_H
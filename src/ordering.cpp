@@ -0,0 +1,156 @@
+// ordering.cpp
+
+#include "ordering.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// Arguments of a term, i.e. children without the function symbol of an application
+static std::vector<const node*> term_args(const node* t) {
+    size_t start = t->type == APPLICATION ? 1 : 0;
+    return std::vector<const node*>(t->children.begin() + start, t->children.end());
+}
+
+// Key identifying the head symbol of a term for the precedence
+static std::string precedence_key(const node* t) {
+    switch (t->type) {
+    case VARIABLE:
+        return "v:" + t->name();
+    case APPLICATION:
+        return "f:" + t->children[0]->name();
+    case TUPLE:
+        return "t";
+    default:
+        return "#" + std::to_string(static_cast<int>(t->symbol));
+    }
+}
+
+// Precedence on head symbols: higher arity is greater, ties broken by key
+static int compare_heads(const node* s, const node* t) {
+    size_t arity_s = term_args(s).size();
+    size_t arity_t = term_args(t).size();
+    if (arity_s != arity_t) {
+        return arity_s > arity_t ? 1 : -1;
+    }
+
+    return precedence_key(s).compare(precedence_key(t));
+}
+
+// Number of symbols and variables in the term, and occurrences of each variable
+static size_t term_weight(const node* t, std::map<std::string, int>& var_counts) {
+    if (t->is_free_variable()) {
+        var_counts[t->name()]++;
+        return 1;
+    }
+
+    size_t weight = 1;
+    for (const node* arg : term_args(t)) {
+        weight += term_weight(arg, var_counts);
+    }
+
+    return weight;
+}
+
+static bool occurs_in(const node* var, const node* t) {
+    if (t->is_free_variable()) {
+        return t->name() == var->name();
+    }
+
+    for (const node* arg : term_args(t)) {
+        if (occurs_in(var, arg)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool kbo_greater(const node* s, const node* t) {
+    if (s->is_free_variable()) {
+        return false; // A variable is not greater than anything
+    }
+
+    std::map<std::string, int> vars_s, vars_t;
+    size_t weight_s = term_weight(s, vars_s);
+    size_t weight_t = term_weight(t, vars_t);
+
+    // Every variable must occur at least as often in s as in t
+    for (const auto& [var, count] : vars_t) {
+        auto it = vars_s.find(var);
+        if (it == vars_s.end() || it->second < count) {
+            return false;
+        }
+    }
+
+    if (weight_s != weight_t) {
+        return weight_s > weight_t;
+    }
+
+    if (t->is_free_variable()) {
+        return false; // Same weight, so s can't properly contain t
+    }
+
+    int cmp = compare_heads(s, t);
+    if (cmp != 0) {
+        return cmp > 0;
+    }
+
+    // Same head, compare arguments lexicographically
+    std::vector<const node*> args_s = term_args(s);
+    std::vector<const node*> args_t = term_args(t);
+    for (size_t i = 0; i < args_s.size(); ++i) {
+        if (!equal(args_s[i], args_t[i])) {
+            return kbo_greater(args_s[i], args_t[i]);
+        }
+    }
+
+    return false; // Equal terms
+}
+
+static bool lpo_greater(const node* s, const node* t) {
+    if (s->is_free_variable()) {
+        return false;
+    }
+
+    if (t->is_free_variable()) {
+        return occurs_in(t, s);
+    }
+
+    std::vector<const node*> args_s = term_args(s);
+    std::vector<const node*> args_t = term_args(t);
+
+    // Some argument of s is at least t
+    for (const node* arg : args_s) {
+        if (equal(arg, t) || lpo_greater(arg, t)) {
+            return true;
+        }
+    }
+
+    // Otherwise s must be greater than all arguments of t
+    for (const node* arg : args_t) {
+        if (!lpo_greater(s, arg)) {
+            return false;
+        }
+    }
+
+    int cmp = compare_heads(s, t);
+    if (cmp != 0) {
+        return cmp > 0;
+    }
+
+    for (size_t i = 0; i < args_s.size(); ++i) {
+        if (!equal(args_s[i], args_t[i])) {
+            return lpo_greater(args_s[i], args_t[i]);
+        }
+    }
+
+    return false; // Equal terms
+}
+
+bool term_greater(const node* s, const node* t, TermOrdering ordering) {
+    if (ordering == TermOrdering::LPO) {
+        return lpo_greater(s, t);
+    }
+
+    return kbo_greater(s, t);
+}
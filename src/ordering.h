@@ -0,0 +1,21 @@
+// ordering.h
+
+#ifndef ORDERING_H
+#define ORDERING_H
+
+#include "node.h"
+
+// Simplification orderings on terms. Free variables are variables of the ordering,
+// everything else (parameters, constants, functions, operators) is a symbol.
+// Symbols are ordered by arity, then by name/symbol number, and all symbols and
+// variables have weight 1.
+enum class TermOrdering {
+    KBO, // Knuth-Bendix ordering
+    LPO  // lexicographic path ordering
+};
+
+// Whether s is strictly greater than t in the given ordering. If neither
+// term_greater(s, t) nor term_greater(t, s) the terms are incomparable (or equal).
+bool term_greater(const node* s, const node* t, TermOrdering ordering = TermOrdering::KBO);
+
+#endif // ORDERING_H
@@ -0,0 +1,195 @@
+// proof_cache.cpp
+
+#include "proof_cache.h"
+#include "precedence.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdint>
+#include <cerrno>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PROOF_CACHE_DIR ".proof_cache" // directory the cache is kept in
+
+// Version of the cached results, to be incremented with any change to the search or to
+// what it prints, so that results of earlier versions are not reused
+#define PROOF_CACHE_VERSION 2
+
+// Writes the formula with variables bound in it named by the depth of their binder, so
+// that formulas equal() to each other are written the same way
+static void canonical(std::string& out, const node* formula, std::vector<std::string>& bound) {
+    if (formula->type == VARIABLE) {
+        const std::string& name = formula->vdata->name;
+        if (formula->vdata->var_kind == INDIVIDUAL) {
+            for (size_t i = bound.size(); i > 0; --i) {
+                if (bound[i - 1] == name) {
+                    out += "#" + std::to_string(i - 1);
+                    return;
+                }
+            }
+        }
+        out += name + "/" + std::to_string(formula->vdata->var_kind);
+        return;
+    }
+
+    out += "(" + std::to_string(formula->type) + " " + std::string(precedenceTable[formula->symbol].repr);
+
+    if (formula->type == QUANTIFIER) {
+        bound.push_back(formula->children[0]->vdata->name);
+    }
+    for (const node* child : formula->children) {
+        out += " ";
+        canonical(out, child, bound);
+    }
+    if (formula->type == QUANTIFIER) {
+        bound.pop_back();
+    }
+
+    out += ")";
+}
+
+std::string proof_cache_key(const context_t& tab_ctx) {
+    std::string key = "ProofDroid proof cache version " + std::to_string(PROOF_CACHE_VERSION) + "\n";
+
+    for (const auto& tabline : tab_ctx.tableau) {
+        std::vector<std::string> bound;
+        key += tabline.target ? "T " : "H ";
+        canonical(key, tabline.target ? tabline.negation : tabline.formula, bound);
+        key += "\n";
+    }
+
+    for (const auto& ref : tab_ctx.modules) {
+        key += "M " + ref.name + " " + std::to_string(ref.module->source_hash) + "\n";
+    }
+
+    return key;
+}
+
+// Returns the file the result for the given key is stored in
+static std::string cache_path(const std::string& key) {
+    // FNV-1a hash of the key, which is also stored to check for collisions
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(h));
+    return std::string(PROOF_CACHE_DIR) + "/" + name;
+}
+
+// The file consists of the number of lines of the key, the key, whether the problem was
+// proved, the move counts, the number of premises, the premises one per line and
+// finally the output
+bool proof_cache_lookup(const std::string& key, cached_proof& proof) {
+    std::ifstream file(cache_path(key));
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    size_t key_lines;
+    if (!(file >> key_lines) || !std::getline(file, line)) {
+        return false;
+    }
+
+    std::string stored;
+    for (size_t i = 0; i < key_lines && std::getline(file, line); ++i) {
+        stored += line + "\n";
+    }
+    if (stored != key) {
+        return false;
+    }
+
+    size_t num_premises;
+    if (!(file >> proof.proved >> proof.cleanup >> proof.reasoning >> proof.rewrite >> proof.split >>
+          proof.backtrack >> num_premises)) {
+        return false;
+    }
+    proof.premises.clear();
+    for (size_t i = 0; i < num_premises; ++i) {
+        std::string module;
+        size_t record;
+        if (!(file >> module >> record)) {
+            return false;
+        }
+        proof.premises.emplace_back(module, record);
+    }
+    std::getline(file, line);
+
+    std::ostringstream output;
+    output << file.rdbuf();
+    proof.output = output.str();
+
+    return true;
+}
+
+void proof_cache_store(const std::string& key, const cached_proof& proof) {
+    if (mkdir(PROOF_CACHE_DIR, 0755) == -1 && errno != EEXIST) {
+        std::cerr << "Error: Could not create " << PROOF_CACHE_DIR << std::endl;
+        return;
+    }
+
+    // Write to a file of our own and move it into place, so that concurrent provers
+    // never see a partly written result
+    std::string path = cache_path(key);
+    std::string temp = path + "." + std::to_string(getpid());
+    {
+        std::ofstream file(temp);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not write " << temp << std::endl;
+            return;
+        }
+
+        file << std::count(key.begin(), key.end(), '\n') << "\n" << key;
+        file << proof.proved << " " << proof.cleanup << " " << proof.reasoning << " " << proof.rewrite << " "
+             << proof.split << " " << proof.backtrack << " " << proof.premises.size() << "\n";
+        for (const auto& [module, record] : proof.premises) {
+            file << module << " " << record << "\n";
+        }
+        file << proof.output;
+    }
+
+    if (rename(temp.c_str(), path.c_str()) == -1) {
+        std::cerr << "Error: Could not write " << path << std::endl;
+        unlink(temp.c_str());
+    }
+}
+
+void proof_cache_remove(const std::string& key) {
+    unlink(cache_path(key).c_str());
+}
+
+premise_list proof_premises(const context_t& tab_ctx) {
+    premise_list premises;
+
+    for (const auto& ref : tab_ctx.modules) {
+        for (size_t r = 0; r < ref.digest.size(); ++r) {
+            for (const auto& item : ref.digest[r]) {
+                if (item.kind != LIBRARY::Rewrite && item.main_tableau_line_idx != static_cast<size_t>(-1)) {
+                    premises.emplace_back(ref.name, r);
+                    break;
+                }
+            }
+        }
+    }
+
+    return premises;
+}
+
+void restrict_premises(context_t& tab_ctx, const premise_list& premises) {
+    for (auto& ref : tab_ctx.modules) {
+        for (size_t r = 0; r < ref.digest.size(); ++r) {
+            bool rewrite = std::any_of(ref.digest[r].begin(), ref.digest[r].end(),
+                [](const digest_item& item) { return item.kind == LIBRARY::Rewrite; });
+            bool used = std::find(premises.begin(), premises.end(), std::make_pair(ref.name, r)) != premises.end();
+
+            // Records are emptied rather than removed to keep indices into the digest valid
+            if (!rewrite && !used) {
+                ref.digest[r].clear();
+            }
+        }
+    }
+}
@@ -0,0 +1,48 @@
+// proof_cache.h
+
+#ifndef PROOF_CACHE_H
+#define PROOF_CACHE_H
+
+#include "context.h"
+#include <string>
+#include <vector>
+#include <utility>
+
+// Library records by module name and index in the module digest
+using premise_list = std::vector<std::pair<std::string, size_t>>;
+
+// The result of proving a problem, as stored in the proof cache
+struct cached_proof {
+    bool proved = false;
+    premise_list premises; // Library records loaded by the proof
+    std::string output;    // What the prover printed, ending with the final tableau and statistics
+    int cleanup = 0;       // Move counts of the proof, for proofs.log
+    int reasoning = 0;
+    int rewrite = 0;
+    int split = 0;
+    int backtrack = 0;
+};
+
+// Returns the text identifying the problem in the tableau: its hypotheses and targets up
+// to renaming of bound variables, the contents of the modules loaded for it and the
+// version of the prover. Must be called before any moves are made.
+std::string proof_cache_key(const context_t& tab_ctx);
+
+// Looks up the result for the problem with the given key. Returns false if there is none.
+bool proof_cache_lookup(const std::string& key, cached_proof& proof);
+
+// Stores the result for the problem with the given key
+void proof_cache_store(const std::string& key, const cached_proof& proof);
+
+// Removes the result for the problem with the given key
+void proof_cache_remove(const std::string& key);
+
+// Returns the library records that were loaded into the tableau
+premise_list proof_premises(const context_t& tab_ctx);
+
+// Drops all library records but the given ones from the digests of the tableau, so that
+// a cached proof can be replayed without searching the rest of the library. Rewrites
+// are kept, as they are by premise selection.
+void restrict_premises(context_t& tab_ctx, const premise_list& premises);
+
+#endif // PROOF_CACHE_H
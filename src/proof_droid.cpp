@@ -6,7 +6,11 @@
 #include "moves.h"
 #include "completion.h"
 #include "library.h"
+#include "module_registry.h"
 #include "automation.h"
+#include "mapped_file.h"
+#include "serve.h"
+#include "proof_cache.h"
 #include <iostream>
 #include <string>
 #include <fstream>
@@ -18,6 +22,8 @@
 #include <optional>
 
 #define DEBUG_HYDRAS 0 // Whether to print hydras after every move in semiautomatic mode
+#define PROOF_CACHE 1 // Whether automatic mode can reuse results of earlier runs on the same problem (--cache)
+#define PROOF_CACHE_VERIFY 0 // Whether cached proofs are replayed from the library records they used
 
 // Enum representing the possible user options
 enum class option_t {
@@ -79,11 +85,9 @@ const std::vector<option_entry> all_options = {
 
 // Function to convert a REPR-formatted string to its corresponding Unicode string.
 std::string get_unicode_from_repr(const std::string& repr) {
-    // Assuming precedenceTable is accessible here
-    extern const std::map<symbol_enum, PrecedenceInfo> precedenceTable;
-    for (const auto& [sym, info] : precedenceTable) {
-        if (info.repr == repr) {
-            return info.unicode;
+    for (const PrecedenceInfo& info : precedenceTable) {
+        if (!info.repr.empty() && info.repr == repr) {
+            return std::string(info.unicode);
         }
     }
     // If not found, return an empty string and optionally print a warning
@@ -179,44 +183,56 @@ std::vector<std::string> tokenize(const std::string& input) {
     return tokens;
 }
 
-// Function to find a loaded module by filename stem
-std::optional<context_t*> find_module(const context_t& tab_ctx, const std::string& filename_stem) {
-    for (const auto& [fname, ctx] : tab_ctx.modules) {
-        if (fname == filename_stem) {
-            return const_cast<context_t*>(&ctx); // Casting away constness for simplicity
-        }
-    }
-    return std::nullopt;
-}
-
 // Function to check if a module is loaded and if not to load it
-// Returns true is module_ctx was loaded correctly
-bool load_module(context_t& module_ctx, context_t& tab_ctx, const std::string filename_stem)
+// Returns the loaded module or nullptr if it couldn't be loaded
+module_ref* load_module(context_t& tab_ctx, const std::string filename_stem)
 {
     // Check if the module is already loaded
-    std::optional<context_t*> module_ctx_opt = tab_ctx.find_module(filename_stem);
+    module_ref* loaded = tab_ctx.find_module(filename_stem);
 
-    if (module_ctx_opt.has_value()) {
-        module_ctx = *module_ctx_opt.value();
+    if (loaded) {
         std::cout << std::endl;
+        return loaded;
     }
-    else {
-        // Load the module
-        std::cout << "Loading module \"" << filename_stem << "\"..." << std::endl;
-        if (library_load(module_ctx, filename_stem)) {
-            std::cout << "Module \"" << filename_stem << "\" loaded successfully." << std::endl << std::endl;
-        }
-        else {
-            std::cerr << "Error: Failed to load module \"" << filename_stem << "\"." << std::endl << std::endl;
-            return true;
-        }
-        module_ctx.get_constants(); // Populate constants
-        module_ctx.get_ltor(); // Compute whether implications are left-to-right and/or right-to-left applicable
 
-        tab_ctx.modules.emplace_back(filename_stem, module_ctx);
+    // Load the module, or share it if another tableau already loaded it
+    std::cout << "Loading module \"" << filename_stem << "\"..." << std::endl;
+    std::shared_ptr<const context_t> module_ctx = registry_load(filename_stem);
+    if (!module_ctx) {
+        std::cerr << "Error: Failed to load module \"" << filename_stem << "\"." << std::endl << std::endl;
+        return nullptr;
     }
+    std::cout << "Module \"" << filename_stem << "\" loaded successfully." << std::endl << std::endl;
 
-    return true;
+    tab_ctx.modules.push_back({filename_stem, module_ctx, module_ctx->digest});
+
+    return &tab_ctx.modules.back();
+}
+
+// Loads the modules of the manifest the problem needs
+void load_needed_modules(context_t& tab_ctx) {
+    std::vector<manifest_entry> manifest;
+    if (!manifest_load(manifest, "library.manifest")) {
+        std::cerr << "Error: No modules loaded." << std::endl << std::endl;
+        return;
+    }
+
+    for (const auto& name : modules_needed(tab_ctx, manifest)) {
+        bool loaded = tab_ctx.find_module(name);
+        module_ref* ref = load_module(tab_ctx, name);
+
+        // A symbol the manifest doesn't list can't bring the module in when it is needed
+        if (ref && !loaded) {
+            std::set<std::string> undeclared = undeclared_symbols(*ref->module, name, manifest);
+            if (!undeclared.empty()) {
+                std::cerr << "Warning: Module \"" << name << "\" uses symbols declared by neither it nor the modules it needs in library.manifest:";
+                for (const auto& symbol : undeclared) {
+                    std::cerr << " " << symbol;
+                }
+                std::cerr << std::endl << std::endl;
+            }
+        }
+    }
 }
 
 // Function to handle the "library filter" option in semiautomatic mode
@@ -247,11 +263,11 @@ void handle_library_filter(context_t& tab_ctx, const std::vector<std::string>& t
         return;
     }
 
-    context_t module_ctx;
-    
-    if (!load_module(module_ctx, tab_ctx, filename_stem)) {
+    module_ref* loaded = load_module(tab_ctx, filename_stem);
+    if (!loaded) {
         return;
     }
+    const context_t& module_ctx = *loaded->module;
 
     // Iterate through the digest of the module
     for (const auto& digest_entry : module_ctx.digest) {
@@ -300,13 +316,13 @@ void handle_load_theorems(context_t& tab_ctx, const std::vector<std::string>& to
     std::vector<std::string> line_no_strs(tokens.begin() + 2, tokens.end());
 
     // Find the module in tab_ctx.modules
-    std::optional<context_t*> module_ctx_opt = find_module(tab_ctx, module_name);
-    if (!module_ctx_opt.has_value()) {
+    module_ref* loaded = tab_ctx.find_module(module_name);
+    if (!loaded) {
         std::cerr << "Error: Module \"" << module_name << "\" is not loaded." << std::endl << std::endl;
         return;
     }
 
-    context_t* module_ctx = module_ctx_opt.value();
+    const context_t* module_ctx = loaded->module.get();
 
     for (const auto& line_no_str : line_no_strs) {
         // Convert line_no to size_t
@@ -332,7 +348,7 @@ void handle_load_theorems(context_t& tab_ctx, const std::vector<std::string>& to
         // Retrieve the digest entry for the specified line
         bool found = false;
         LIBRARY kind;
-        for (auto& digest_entry : module_ctx->digest) {
+        for (auto& digest_entry : loaded->digest) {
             for (auto& [mod_line_idx, main_line_idx, entry_kind] : digest_entry) {
                 if (mod_line_idx == line_no) {
                     if (main_line_idx != -static_cast<size_t>(1)) {
@@ -357,9 +373,12 @@ void handle_load_theorems(context_t& tab_ctx, const std::vector<std::string>& to
             continue; // Skip to the next line_no
         }
 
-        // Copy the fact's tabline from the module to the main tableau
+        // Copy the fact's tabline from the module to the main tableau. The module is
+        // shared through the registry, so the tableau gets formulas of its own.
         const tabline_t& module_tabline = module_ctx->tableau[line_no];
-        tabline_t copied_tabline = module_tabline; // Assuming a copy constructor is available
+        tabline_t copied_tabline = module_tabline;
+        copied_tabline.formula = deep_copy(module_tabline.formula);
+        copied_tabline.negation = nullptr;
 
         // Set the reason based on the kind
         if (kind == LIBRARY::Theorem) {
@@ -376,7 +395,7 @@ void handle_load_theorems(context_t& tab_ctx, const std::vector<std::string>& to
         tab_ctx.tableau.push_back(copied_tabline);
 
         // Update the digest to mark this fact as loaded
-        for (auto& digest_entry : module_ctx->digest) {
+        for (auto& digest_entry : loaded->digest) {
             for (auto& [mod_line_idx, main_line_idx, entry_kind] : digest_entry) {
                 if (mod_line_idx == line_no) {
                     main_line_idx = tab_ctx.tableau.size() - 1; // Set to the index of the newly added line
@@ -1138,85 +1157,148 @@ void semi_automatic_mode(context_t& tab_ctx, const std::vector<option_t>& semi_a
     }
 }
 
-// Entry point of the application
-int main(int argc, char** argv) {
-    // Initialize variables for command-line parsing
-    bool interactive_mode = false;
-    std::string filename;
+// Deletes the formulas of the tableau
+void delete_tableau(context_t& tab_ctx) {
+    for (auto& tabline : tab_ctx.tableau) {
+        if (tabline.target && tabline.negation) {
+            delete tabline.negation;
+        }
+        if (tabline.formula) {
+            delete tabline.formula;
+        }
+    }
+}
 
-    // Command-line parsing using std::string for safer comparisons
-    if (argc == 3 && std::string(argv[1]) == "-i") {
-        // Interactive mode: ./proof_droid -i filename.thm
-        interactive_mode = true;
-        filename = argv[2];
+// Runs automatic mode on the tableau, printing it before and after. If use_cache is set,
+// the result of an earlier run on the same problem is reused and the result is stored.
+// The nodes of the tableau are deleted afterwards. Returns true if all targets were proved.
+bool prove_automatic(context_t& tab_ctx, const std::string& filename, bool use_cache) {
+    // Display the initial tableau
+    print_tableau(tab_ctx);
+    std::cout << std::endl;
+
+    // Perform automatic mode steps
+    load_needed_modules(tab_ctx);
+
+    bool replay = false;
+#if PROOF_CACHE
+    std::string key;
+    cached_proof cached;
+    std::ostringstream captured;
+    std::streambuf* saved = nullptr;
+
+    if (use_cache) {
+        // Look for the result of an earlier run on the same problem
+        key = proof_cache_key(tab_ctx);
+        if (proof_cache_lookup(key, cached)) {
+            if (!PROOF_CACHE_VERIFY || !cached.proved) {
+                std::cout << cached.output;
+                if (cached.proved) {
+                    // The proof is logged as if it had been found again
+                    tab_ctx.cleanup = cached.cleanup;
+                    tab_ctx.reasoning = cached.reasoning;
+                    tab_ctx.rewrite = cached.rewrite;
+                    tab_ctx.split = cached.split;
+                    tab_ctx.backtrack = cached.backtrack;
+                    tab_ctx.log_statistics(filename);
+                }
+                delete_tableau(tab_ctx);
+                return cached.proved;
+            }
+            replay = true;
+        }
+
+        // Keep what is printed from here on, to store with the result
+        saved = std::cout.rdbuf(captured.rdbuf());
     }
-    else if (argc == 2) {
-        // Automatic mode: ./proof_droid filename.thm
-        interactive_mode = false;
-        filename = argv[1];
+#endif
+
+    if (replay) {
+        // Only search the library records the cached proof used
+        restrict_premises(tab_ctx, cached.premises);
     }
     else {
-        // Invalid usage
-        std::cerr << "Usage:\n";
-        std::cerr << "  " << argv[0] << " -i <filename.thm>  (Interactive mode)\n";
-        std::cerr << "  " << argv[0] << " <filename.thm>     (Automatic mode)\n";
-        return 1;
+        // Restrict the library to premises relevant to the problem
+        select_premises(tab_ctx);
     }
 
-    std::cout << "Welcome to ProofDroid for C version 0.1!" << std::endl << std::endl;
+    parameterize_all(tab_ctx);
 
-    // Open the specified file
-    std::cout << "Reading " << filename << "..." << std::endl << std::endl;
-    std::ifstream infile(filename);
-    if (!infile) {
-        std::cerr << "Error opening file: " << filename << std::endl;
-        return 1;
+    // Set up initial hydras
+    tab_ctx.initialize_hydras();
+    std::vector<int> targets = tab_ctx.get_hydra();
+    tab_ctx.select_targets(targets);
+    
+    cleanup_moves(tab_ctx, 0); // Starting from line 0
+
+    // Get constants for the tableau
+    tab_ctx.get_constants();
+
+    // Call the automate function
+    bool success = automate(tab_ctx);
+
+    // Set all lines to active for final display
+    tab_ctx.reanimate();
+
+    // After automation, display the tableau again
+    print_tableau(tab_ctx);
+    std::cout << std::endl;
+
+    if (success) {                        
+        tab_ctx.print_statistics(filename, true);
+        std::cout << std::endl;
     }
 
-    // Initialize a new blank context for the tableau
-    context_t tab_ctx;
+#if PROOF_CACHE
+    if (use_cache) {
+        std::cout.rdbuf(saved);
+        std::cout << captured.str();
+
+        if (!replay) {
+            proof_cache_store(key, {success, proof_premises(tab_ctx), captured.str(), tab_ctx.cleanup,
+                                    tab_ctx.reasoning, tab_ctx.rewrite, tab_ctx.split, tab_ctx.backtrack});
+        }
+        else if (!success) {
+            std::cerr << "Error: Cached proof could not be replayed, removing it from the cache." << std::endl;
+            proof_cache_remove(key);
+        }
+    }
+#endif
+
+    delete_tableau(tab_ctx);
 
-    // Initialize manager and parser context
+    return success;
+}
+
+// Reads the hypotheses and targets of a theorem from the given buffer into the tableau
+bool read_theorem(context_t& tab_ctx, const char* input, size_t size) {
+    // Initialize manager and parser context, the parser reads the whole theorem from one buffer
     manager_t mgr;
-    mgr.input = nullptr; // Initialize manager input
+    mgr.input = input;
     mgr.pos = 0;
 
     parser_context_t *ctx = parser_create(&mgr);
     if (ctx == nullptr) {
         std::cerr << "Failed to create parser context." << std::endl;
-        return 1;
+        return false;
     }
 
-    std::string line;
-    int line_number = 0;
-
-    // Read the file line by line
-    while (getline(infile, line)) {
-        line_number++;
-        if (line.empty()) continue; // Skip empty lines
+    bool more_input = size != 0;
 
-        bool is_target = false;
-        std::string formula_str = line;
+    // Parse the file one line at a time
+    while (more_input) {
+        mgr.record = RECORD_NONE;
 
-        // Check if the line is a target (starts with "* ")
-        if (line.size() >= 2 && line[0] == '*' && line[1] == ' ') {
-            is_target = true;
-            formula_str = line.substr(2); // Remove "* " prefix
-        }
-
-        std::string modified_input = formula_str;
-        modified_input.push_back('\n'); // Add newline to the input
+        // Parse the next line, targets start with "* "
+        node* ast = nullptr;
+        more_input = parser_parse(ctx, &ast);
 
-        // Set the input buffer and reset position
-        mgr.input = modified_input.c_str();
-        mgr.pos = 0;
+        if (mgr.record == RECORD_BLANK) continue; // Skip empty lines
 
-        // Parse the input
-        node* ast = nullptr;
-        parser_parse(ctx, &ast);
+        bool is_target = (mgr.record == RECORD_TARGET);
 
         if (!ast) {
-            std::cerr << "Error parsing line " << line_number << ": " << formula_str << std::endl << std::endl;
+            std::cerr << "Error parsing line " << mgr.line << ": " << statement_line(&mgr) << std::endl << std::endl;
             continue; // Skip to the next line
         }
 
@@ -1250,7 +1332,72 @@ int main(int argc, char** argv) {
         }
     }
 
-    infile.close(); // Close the input file
+    parser_destroy(ctx);
+
+    return true;
+}
+
+// Entry point of the application
+int main(int argc, char** argv) {
+    // Initialize variables for command-line parsing
+    bool interactive_mode = false;
+    bool use_cache = false;
+    std::string filename;
+
+    // Command-line parsing using std::string for safer comparisons
+    if (argc == 2 && std::string(argv[1]) == "--serve") {
+        // Server mode: ./proof_droid --serve
+        return serve([](const std::string& name, const std::string& theorem) {
+            context_t tab_ctx;
+            if (!read_theorem(tab_ctx, theorem.c_str(), theorem.size())) {
+                return false;
+            }
+            return prove_automatic(tab_ctx, name, false);
+        });
+    }
+    else if (argc == 3 && std::string(argv[1]) == "-i") {
+        // Interactive mode: ./proof_droid -i filename.thm
+        interactive_mode = true;
+        filename = argv[2];
+    }
+    else if (argc == 3 && std::string(argv[1]) == "--cache") {
+        // Automatic mode with the proof cache: ./proof_droid --cache filename.thm
+        use_cache = true;
+        filename = argv[2];
+    }
+    else if (argc == 2) {
+        // Automatic mode: ./proof_droid filename.thm
+        interactive_mode = false;
+        filename = argv[1];
+    }
+    else {
+        // Invalid usage
+        std::cerr << "Usage:\n";
+        std::cerr << "  " << argv[0] << " -i <filename.thm>  (Interactive mode)\n";
+        std::cerr << "  " << argv[0] << " <filename.thm>     (Automatic mode)\n";
+        std::cerr << "  " << argv[0] << " --cache <filename.thm>  (Automatic mode, reusing results kept in .proof_cache)\n";
+        std::cerr << "  " << argv[0] << " --serve            (Server mode, see serve.h)\n";
+        return 1;
+    }
+
+    std::cout << "Welcome to ProofDroid for C version 0.1!" << std::endl << std::endl;
+
+    // Open the specified file
+    std::cout << "Reading " << filename << "..." << std::endl << std::endl;
+    mapped_file infile(filename);
+    if (!infile.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return 1;
+    }
+
+    // Initialize a new blank context for the tableau
+    context_t tab_ctx;
+
+    if (!read_theorem(tab_ctx, infile.c_str(), infile.size())) {
+        return 1;
+    }
+
+    std::string line;
 
     if (interactive_mode) {
         // Interactive Mode: Present options to the user
@@ -1368,10 +1515,10 @@ int main(int argc, char** argv) {
                     }
                     case option_t::OPTION_AUTOMATIC: {
                         // Automatic Mode within Interactive Mode
-                        context_t module_ctx, module_ctx2;
-                        // For now, hard code module loads
-                        load_module(module_ctx, tab_ctx, "group");
-                        load_module(module_ctx2, tab_ctx, "set2");
+                        load_needed_modules(tab_ctx);
+
+                        // Restrict the library to premises relevant to the problem
+                        select_premises(tab_ctx);
 
                         parameterize_all(tab_ctx);
 
@@ -1392,6 +1539,9 @@ int main(int argc, char** argv) {
                             tab_ctx.reanimate();
                         }
 
+                        // Make the whole library available again for further moves
+                        restore_premises(tab_ctx);
+
                         std::cout << std::endl;
 
                         // After automation, display the tableau again
@@ -1426,72 +1576,15 @@ int main(int argc, char** argv) {
 
     exit_loop:
         // Clean up parser context
-        parser_destroy(ctx);
 
         // Clean up memory by deleting all node pointers in the tableau
-        for (auto& tabline : tab_ctx.tableau) {
-            if (tabline.target && tabline.negation) {
-                delete tabline.negation;
-            }
-            if (tabline.formula) {
-                delete tabline.formula;
-            }
-        }
+        delete_tableau(tab_ctx);
 
         return 0;
     }
     else {
         // Non-Interactive Mode: Run automatic mode immediately
-
-        // Display the initial tableau
-        print_tableau(tab_ctx);
-        std::cout << std::endl;
-
-        // Perform automatic mode steps
-        context_t module_ctx, module_ctx2;
-        // For now, hard code module loads
-        load_module(module_ctx, tab_ctx, "group");
-        load_module(module_ctx2, tab_ctx, "set2");
-
-        parameterize_all(tab_ctx);
-
-        // Set up initial hydras
-        tab_ctx.initialize_hydras();
-        std::vector<int> targets = tab_ctx.get_hydra();
-        tab_ctx.select_targets(targets);
-        
-        cleanup_moves(tab_ctx, 0); // Starting from line 0
-
-        // Get constants for the tableau
-        tab_ctx.get_constants();
-
-        // Call the automate function
-        bool success = automate(tab_ctx);
-
-        // Set all lines to active for final display
-        tab_ctx.reanimate();
-
-        // After automation, display the tableau again
-        print_tableau(tab_ctx);
-        std::cout << std::endl;
-
-        if (success) {                        
-            tab_ctx.print_statistics(filename, true);
-            std::cout << std::endl;
-        }
-
-        // Perform cleanup
-        parser_destroy(ctx);
-
-        // Clean up memory by deleting all node pointers in the tableau
-        for (auto& tabline : tab_ctx.tableau) {
-            if (tabline.target && tabline.negation) {
-                delete tabline.negation;
-            }
-            if (tabline.formula) {
-                delete tabline.formula;
-            }
-        }
+        bool success = prove_automatic(tab_ctx, filename, use_cache);
 
         // Exit with appropriate return value based on automation success
         if (success) {
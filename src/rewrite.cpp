@@ -0,0 +1,168 @@
+// rewrite.cpp
+
+#include "rewrite.h"
+#include "unify.h"
+#include <algorithm>
+
+// Returns the key rewrite rules are indexed by
+std::string head_symbol(const node* term) {
+    switch (term->type) {
+    case APPLICATION:
+        return term->children[0]->name();
+    case VARIABLE:
+        if (term->is_free_variable()) {
+            return ""; // Matches anything, so can't be used as a key
+        }
+        return term->name();
+    case TUPLE:
+        return "()";
+    default:
+        return "#" + std::to_string(static_cast<int>(term->symbol));
+    }
+}
+
+// Collects the head symbols of all terms occurring in the formula
+void term_heads(std::set<std::string>& heads, const node* formula) {
+    if (formula->is_term()) {
+        std::string head = head_symbol(formula);
+        if (!head.empty()) {
+            heads.insert(head);
+        }
+    }
+
+    // Quantified variables are not terms that can be rewritten
+    size_t start = (formula->type == QUANTIFIER || formula->type == APPLICATION) ? 1 : 0;
+    for (size_t i = start; i < formula->children.size(); ++i) {
+        term_heads(heads, formula->children[i]);
+    }
+}
+
+bool rewrite_index::add_rule(node* lhs, node* rhs, int line) {
+    if (term_greater(rhs, lhs, ordering)) {
+        std::swap(lhs, rhs); // Equalities can be used in either direction
+    }
+
+    std::string head = head_symbol(lhs);
+    if (head.empty() || !lhs->is_term()) {
+        return false; // A variable on the left would match every term
+    }
+
+    std::set<std::string> vars_lhs, vars_rhs;
+    vars_used(vars_lhs, lhs, false, false);
+    vars_used(vars_rhs, rhs, false, false);
+    if (!std::includes(vars_lhs.begin(), vars_lhs.end(), vars_rhs.begin(), vars_rhs.end())) {
+        return false; // Right side would contain unassigned variables
+    }
+
+    rules[head].push_back({lhs, rhs, line, term_greater(lhs, rhs, ordering)});
+
+    // Terms may have different normal forms with the new rule
+    clear_normal_forms();
+
+    return true;
+}
+
+void rewrite_index::clear_normal_forms() {
+    for (auto& [hash, nf] : normal_forms) {
+        delete nf.term;
+        delete nf.result;
+    }
+    normal_forms.clear();
+}
+
+// Rewrites the children of the given node to normal form, then the node itself.
+// Takes ownership of current and returns its normal form.
+node* rewrite_index::normalise_node(node* current, std::vector<int>& used_lines, int max_steps) {
+    if (!current->is_term()) {
+        // Rewrite the terms inside formulas, but not quantified variables
+        size_t start = (current->type == QUANTIFIER || current->type == APPLICATION) ? 1 : 0;
+        for (size_t i = start; i < current->children.size(); ++i) {
+            current->children[i] = normalise_node(current->children[i], used_lines, max_steps);
+        }
+
+        return current;
+    }
+
+    // Check if we have seen this term before
+    size_t hash = annotate(current).hash;
+    auto [first, last] = normal_forms.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        if (equal(it->second.term, current)) {
+            used_lines.insert(used_lines.end(), it->second.used_lines.begin(), it->second.used_lines.end());
+            delete current;
+            return deep_copy(it->second.result);
+        }
+    }
+
+    node* term = deep_copy(current);
+    size_t initial_used = used_lines.size();
+
+    // Innermost strategy: first normalise the arguments
+    size_t start = current->type == APPLICATION ? 1 : 0;
+    for (size_t i = start; i < current->children.size(); ++i) {
+        current->children[i] = normalise_node(current->children[i], used_lines, max_steps);
+    }
+
+    // Now try the rules indexed by the head of the term
+    auto rule_it = rules.find(head_symbol(current));
+    if (rule_it != rules.end() && steps <= max_steps) {
+        for (const rewrite_rule& rule : rule_it->second) {
+            Substitution subst;
+            if (match(rule.lhs, current, subst)) {
+                // Bindings point into current, so substitute before deleting it
+                node* result = substitute(rule.rhs, subst);
+
+                // Ordered rewriting: instances of unoriented rules must decrease
+                if (!rule.oriented && !term_greater(current, result, ordering)) {
+                    delete result;
+                    continue;
+                }
+
+                delete current;
+
+                steps++;
+                used_lines.push_back(rule.line);
+
+                // The result may have new redexes at the top or around the substituted terms
+                current = normalise_node(result, used_lines, max_steps);
+                break;
+            }
+        }
+    }
+
+    // The term may already have been seen while rewriting the result
+    auto [stored_first, stored_last] = normal_forms.equal_range(hash);
+    bool stored = std::any_of(stored_first, stored_last,
+        [term](const auto& entry) { return equal(entry.second.term, term); });
+
+    if (stored) {
+        delete term;
+    } else {
+        std::vector<int> term_lines(used_lines.begin() + initial_used, used_lines.end());
+        normal_forms.emplace(hash, normal_form{term, deep_copy(current), std::move(term_lines)});
+    }
+
+    return current;
+}
+
+node* rewrite_index::normalise(node* formula, std::vector<int>& used_lines, int max_steps) {
+    steps = 0;
+    size_t initial_used = used_lines.size();
+
+    node* result = normalise_node(formula, used_lines, max_steps);
+
+    if (steps > max_steps) {
+        // The rules don't terminate on this formula, and terms rewritten after
+        // the limit was reached were not brought to normal form
+        clear_normal_forms();
+        delete result;
+        used_lines.resize(initial_used);
+        return nullptr;
+    }
+
+    // Record each rule only once
+    std::sort(used_lines.begin() + initial_used, used_lines.end());
+    used_lines.erase(std::unique(used_lines.begin() + initial_used, used_lines.end()), used_lines.end());
+
+    return result;
+}
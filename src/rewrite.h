@@ -0,0 +1,90 @@
+// rewrite.h
+
+#ifndef REWRITE_H
+#define REWRITE_H
+
+#include "node.h"
+#include "substitute.h"
+#include "ordering.h"
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+
+// A rewrite rule lhs = rhs, applied left to right. The line is the tableau line
+// the rule came from, so that it can be cited in justifications. If the rule is
+// not oriented, i.e. lhs is not greater than rhs in the term ordering, each
+// instance is only applied if it makes the term smaller.
+struct rewrite_rule {
+    node* lhs;
+    node* rhs;
+    int line;
+    bool oriented;
+};
+
+// Returns the key rewrite rules are indexed by: the function name or operator
+// symbol at the head of the term, or the empty string for a free variable
+std::string head_symbol(const node* term);
+
+// Collects the head symbols of all terms occurring in the formula
+void term_heads(std::set<std::string>& heads, const node* formula);
+
+// A set of rewrite rules indexed by the head symbol of their left hand sides.
+// Rules are matched one-sided, i.e. only variables of the rule are assigned.
+// Only steps that decrease the term in the given ordering are made, so that
+// rewriting terminates. The index does not own the rules.
+class rewrite_index {
+public:
+    rewrite_index(TermOrdering ordering = TermOrdering::KBO) : ordering(ordering) {}
+
+    ~rewrite_index() {
+        clear_normal_forms();
+    }
+
+    // The index owns the normal forms it has memoised
+    rewrite_index(const rewrite_index&) = delete;
+    rewrite_index& operator=(const rewrite_index&) = delete;
+
+    // Adds a rule to the index, reversing it if the right side is greater. Returns
+    // false if it is not usable for rewriting, i.e. the left side is a variable
+    // or the right side has variables the left side doesn't bind
+    bool add_rule(node* lhs, node* rhs, int line);
+
+    // Whether the index has no rules
+    bool empty() const {
+        return rules.empty();
+    }
+
+    // Rewrites the formula to normal form with respect to all rules in a single
+    // innermost traversal. The formula is consumed and the normal form returned.
+    // Lines of rules that were used are appended to used_lines. Rewriting
+    // terminates as every step is decreasing, but if more than max_steps
+    // rewrites are needed nullptr is returned to bound the work. Normal forms
+    // are remembered until the next rule is added, so that terms seen again,
+    // in this or later calls, are not rewritten again.
+    node* normalise(node* formula, std::vector<int>& used_lines, int max_steps = 1000);
+
+private:
+    TermOrdering ordering;
+
+    std::unordered_map<std::string, std::vector<rewrite_rule>> rules;
+
+    // A term already seen, its normal form and the lines of the rules used to get there
+    struct normal_form {
+        node* term;
+        node* result;
+        std::vector<int> used_lines;
+    };
+
+    // Normal forms keyed by the structural hash of the term, terms with the same
+    // hash are told apart with equal()
+    std::unordered_multimap<size_t, normal_form> normal_forms;
+
+    int steps = 0;
+
+    node* normalise_node(node* current, std::vector<int>& used_lines, int max_steps);
+
+    void clear_normal_forms();
+};
+
+#endif // REWRITE_H
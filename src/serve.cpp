@@ -0,0 +1,519 @@
+// serve.cpp
+
+#include "serve.h"
+#include "library.h"
+#include "module_registry.h"
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+// A request being proved in a child process
+struct job_t {
+    request_t request;
+    pid_t pid;
+    int fd;              // Read end of the pipe the child prints to
+    std::string partial; // Output not yet ended by a newline
+    std::chrono::steady_clock::time_point start;
+    bool killed = false; // Whether the child was killed for taking too long
+    bool done = false;   // Whether the child has closed its output
+};
+
+// Returns the string as a JSON string literal
+static std::string json_string(const std::string& str) {
+    std::string out = "\"";
+    for (unsigned char c : str) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+static void skip_space(const std::string& line, size_t& pos) {
+    while (pos < line.size() && isspace(static_cast<unsigned char>(line[pos]))) {
+        pos++;
+    }
+}
+
+// Appends the code point to the string as UTF-8
+static void append_utf8(std::string& out, unsigned long cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Parses the four hex digits of a unicode escape at pos
+static bool parse_hex4(const std::string& line, size_t& pos, unsigned long& cp) {
+    if (pos + 4 > line.size()) {
+        return false;
+    }
+    cp = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        char c = line[pos++];
+        if (!isxdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+        cp = 16*cp + (isdigit(static_cast<unsigned char>(c)) ? c - '0' : (tolower(c) - 'a' + 10));
+    }
+    return true;
+}
+
+// Parses the JSON number at pos, returning its text as well as its value
+static bool parse_number(const std::string& line, size_t& pos, std::string& text, double& number) {
+    size_t begin = pos;
+    auto digits = [&]() {
+        size_t start = pos;
+        while (pos < line.size() && isdigit(static_cast<unsigned char>(line[pos]))) {
+            pos++;
+        }
+        return pos > start;
+    };
+
+    if (pos < line.size() && line[pos] == '-') {
+        pos++;
+    }
+    if (pos < line.size() && line[pos] == '0') {
+        pos++;
+    } else if (!digits()) {
+        return false;
+    }
+    if (pos < line.size() && line[pos] == '.') {
+        pos++;
+        if (!digits()) {
+            return false;
+        }
+    }
+    if (pos < line.size() && (line[pos] == 'e' || line[pos] == 'E')) {
+        pos++;
+        if (pos < line.size() && (line[pos] == '+' || line[pos] == '-')) {
+            pos++;
+        }
+        if (!digits()) {
+            return false;
+        }
+    }
+
+    text = line.substr(begin, pos - begin);
+    number = strtod(text.c_str(), nullptr);
+    return true;
+}
+
+// Parses the JSON string literal at pos
+static bool parse_string(const std::string& line, size_t& pos, std::string& out) {
+    if (pos >= line.size() || line[pos] != '"') {
+        return false;
+    }
+    pos++;
+
+    while (pos < line.size() && line[pos] != '"') {
+        char c = line[pos++];
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (pos >= line.size()) {
+            return false;
+        }
+        c = line[pos++];
+        switch (c) {
+            case '"': case '\\': case '/': out += c; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned long cp;
+                if (!parse_hex4(line, pos, cp) || (cp >= 0xDC00 && cp < 0xE000)) {
+                    return false;
+                }
+                // A high surrogate must be followed by a low one
+                if (cp >= 0xD800 && cp < 0xDC00) {
+                    unsigned long low;
+                    if (pos + 2 > line.size() || line[pos] != '\\' || line[pos + 1] != 'u') {
+                        return false;
+                    }
+                    pos += 2;
+                    if (!parse_hex4(line, pos, low) || low < 0xDC00 || low >= 0xE000) {
+                        return false;
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    if (pos >= line.size()) {
+        return false;
+    }
+    pos++;
+
+    return true;
+}
+
+bool parse_request(const std::string& line, request_t& request, std::string& error) {
+    size_t pos = 0;
+    skip_space(line, pos);
+    if (pos >= line.size() || line[pos] != '{') {
+        error = "request is not a JSON object";
+        return false;
+    }
+    pos++;
+
+    bool has_theorem = false;
+    skip_space(line, pos);
+    bool empty = pos < line.size() && line[pos] == '}';
+    while (!empty && pos < line.size()) {
+        std::string key;
+        if (!parse_string(line, pos, key)) {
+            error = "expected a key";
+            return false;
+        }
+        skip_space(line, pos);
+        if (pos >= line.size() || line[pos] != ':') {
+            error = "expected : after " + key;
+            return false;
+        }
+        pos++;
+        skip_space(line, pos);
+
+        std::string str;
+        double number = 0;
+        bool is_string = pos < line.size() && line[pos] == '"';
+        if (is_string) {
+            if (!parse_string(line, pos, str)) {
+                error = "malformed string for " + key;
+                return false;
+            }
+        } else if (!parse_number(line, pos, str, number)) {
+            error = "expected a string or number for " + key;
+            return false;
+        }
+
+        if (key == "id") {
+            request.id = str;
+            request.id_json = is_string ? json_string(str) : str;
+        } else if (key == "theorem") {
+            if (!is_string) {
+                error = "expected a string for theorem";
+                return false;
+            }
+            request.theorem = str;
+            has_theorem = true;
+        } else if (key == "timeout" || key == "memory") {
+            if (is_string) {
+                error = "expected a number for " + key;
+                return false;
+            }
+            if (number < 0) {
+                error = "expected a non-negative number for " + key;
+                return false;
+            }
+            if (key == "timeout") {
+                request.timeout = number;
+            } else {
+                request.memory = number;
+            }
+        }
+
+        // Members are separated by commas, the last is followed by the closing brace
+        skip_space(line, pos);
+        if (pos >= line.size() || line[pos] == '}') {
+            break;
+        }
+        if (line[pos] != ',') {
+            error = "expected , or } after " + key;
+            return false;
+        }
+        pos++;
+        skip_space(line, pos);
+    }
+
+    if (pos >= line.size()) {
+        error = "unterminated request";
+        return false;
+    }
+    if (!has_theorem) {
+        error = "request has no theorem";
+        return false;
+    }
+
+    // The parser expects every line to be terminated
+    if (request.theorem.empty() || request.theorem.back() != '\n') {
+        request.theorem += '\n';
+    }
+
+    return true;
+}
+
+// Writes a reply about the given request
+static void reply(const request_t& request, const std::string& fields) {
+    std::cout << "{\"id\": " << request.id_json << ", " << fields << "}" << std::endl;
+}
+
+// Forks a child process to prove the request, with its output going to a pipe
+static bool start_job(job_t& job, const prove_fn& prove) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+        return false;
+    }
+
+    // Anything buffered would otherwise be printed by the child too
+    std::cout.flush();
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[1]);
+        close(STDIN_FILENO);
+
+        if (job.request.timeout > 0) {
+            // The server kills the child on time, this is in case it can't
+            rlim_t seconds = static_cast<rlim_t>(std::ceil(job.request.timeout)) + 1;
+            struct rlimit limit = {seconds, seconds + 1};
+            setrlimit(RLIMIT_CPU, &limit);
+        }
+        if (job.request.memory > 0) {
+            rlim_t bytes = static_cast<rlim_t>(job.request.memory*1024*1024);
+            struct rlimit limit = {bytes, bytes};
+            setrlimit(RLIMIT_AS, &limit);
+        }
+
+        bool proved = false;
+        try {
+            proved = prove(job.request.id, job.request.theorem);
+        } catch (const std::bad_alloc&) {
+            std::cerr << "Error: Out of memory." << std::endl;
+            std::cout.flush();
+            _exit(2);
+        }
+
+        std::cout.flush();
+        _exit(proved ? 0 : 1);
+    }
+
+    close(fds[1]);
+    job.pid = pid;
+    job.fd = fds[0];
+    job.start = std::chrono::steady_clock::now();
+
+    return true;
+}
+
+// Passes on each complete line the child has printed
+static void read_job(job_t& job) {
+    char buf[4096];
+    ssize_t n = read(job.fd, buf, sizeof(buf));
+    if (n <= 0) {
+        if (n == 0 || errno != EINTR) {
+            job.done = true;
+        }
+        return;
+    }
+
+    job.partial.append(buf, n);
+    size_t begin = 0, end;
+    while ((end = job.partial.find('\n', begin)) != std::string::npos) {
+        reply(job.request, "\"output\": " + json_string(job.partial.substr(begin, end - begin)));
+        begin = end + 1;
+    }
+    job.partial.erase(0, begin);
+}
+
+// Collects the child once it has closed its output and reports the outcome
+static void finish_job(job_t& job) {
+    close(job.fd);
+
+    if (!job.partial.empty()) {
+        reply(job.request, "\"output\": " + json_string(job.partial));
+    }
+
+    int status = 0;
+    while (waitpid(job.pid, &status, 0) == -1 && errno == EINTR) {}
+
+    std::string outcome;
+    if (job.killed || (WIFSIGNALED(status) && WTERMSIG(status) == SIGXCPU)) {
+        outcome = "timeout";
+    } else if (WIFSIGNALED(status)) {
+        outcome = "crashed";
+    } else if (WEXITSTATUS(status) == 0) {
+        outcome = "proved";
+    } else if (WEXITSTATUS(status) == 1) {
+        outcome = "not proved";
+    } else {
+        outcome = "error";
+    }
+
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - job.start).count();
+
+    reply(job.request, "\"status\": " + json_string(outcome) + ", \"time\": " + std::to_string(time));
+}
+
+// Queues the request on the given line, or reports why it can't be
+static void accept_request(const std::string& line, std::deque<request_t>& queue) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        return;
+    }
+
+    request_t request;
+    std::string error;
+    if (!parse_request(line, request, error)) {
+        reply(request, "\"status\": \"error\", \"message\": " + json_string(error));
+        return;
+    }
+
+    queue.push_back(request);
+}
+
+int serve(const prove_fn& prove) {
+    // A client going away must not take the server with it
+    signal(SIGPIPE, SIG_IGN);
+
+    // Load every module up front, so that the children share them
+    std::vector<manifest_entry> manifest;
+    if (manifest_load(manifest, "library.manifest")) {
+        for (const auto& entry : manifest) {
+            if (!registry_load(entry.name)) {
+                std::cerr << "Error: Failed to load module \"" << entry.name << "\"." << std::endl;
+            }
+        }
+    }
+    registry_pin();
+
+    size_t max_jobs = std::max(1u, std::thread::hardware_concurrency());
+
+    std::deque<request_t> queue;
+    std::vector<job_t> jobs;
+    std::string input;
+    bool input_open = true;
+
+    std::cout << "{\"status\": \"ready\"}" << std::endl;
+
+    while (input_open || !queue.empty() || !jobs.empty()) {
+        // Start as many queued requests as there are free slots
+        while (!queue.empty() && jobs.size() < max_jobs) {
+            job_t job;
+            job.request = queue.front();
+            queue.pop_front();
+
+            if (start_job(job, prove)) {
+                reply(job.request, "\"status\": \"started\"");
+                jobs.push_back(std::move(job));
+            } else {
+                reply(job.request, "\"status\": \"error\", \"message\": \"could not start prover\"");
+            }
+        }
+
+        std::vector<pollfd> fds;
+        if (input_open) {
+            fds.push_back({STDIN_FILENO, POLLIN, 0});
+        }
+        for (const auto& job : jobs) {
+            fds.push_back({job.fd, POLLIN, 0});
+        }
+
+        // Wake up regularly to check for requests taking too long
+        if (poll(fds.data(), fds.size(), 100) == -1 && errno != EINTR) {
+            std::cerr << "Error: poll failed." << std::endl;
+            return 1;
+        }
+
+        size_t k = 0;
+        if (input_open) {
+            if (fds[k].revents) {
+                char buf[4096];
+                ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+                if (n > 0) {
+                    input.append(buf, n);
+                } else if (n == 0 || errno != EINTR) {
+                    // Treat unterminated input as a last line
+                    input_open = false;
+                    input += '\n';
+                }
+
+                size_t begin = 0, end;
+                while ((end = input.find('\n', begin)) != std::string::npos) {
+                    accept_request(input.substr(begin, end - begin), queue);
+                    begin = end + 1;
+                }
+                input.erase(0, begin);
+            }
+            k++;
+        }
+
+        for (auto& job : jobs) {
+            if (fds[k++].revents) {
+                read_job(job);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (auto& job : jobs) {
+            std::chrono::duration<double> elapsed = now - job.start;
+            if (!job.done && !job.killed && job.request.timeout > 0 && elapsed.count() > job.request.timeout) {
+                kill(job.pid, SIGKILL);
+                job.killed = true;
+            }
+        }
+
+        for (auto it = jobs.begin(); it != jobs.end(); ) {
+            if (it->done) {
+                finish_job(*it);
+                it = jobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    return 0;
+}
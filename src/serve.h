@@ -0,0 +1,47 @@
+// serve.h
+
+#ifndef SERVE_H
+#define SERVE_H
+
+#include <functional>
+#include <string>
+
+#define SERVE_TIMEOUT 60 // default limit in seconds on the time a request may take
+#define SERVE_MEMORY 4096 // default limit in megabytes on the memory a request may use
+
+// Proves the theorem with the given name and text, printing to std::cout as automatic
+// mode does. Returns true if all targets were proved.
+using prove_fn = std::function<bool(const std::string& name, const std::string& theorem)>;
+
+// A request read by the server
+struct request_t {
+    std::string id;                 // Name the theorem is proved under
+    std::string id_json = "\"\"";   // The id as written in the request, echoed in replies
+    std::string theorem;
+    double timeout = SERVE_TIMEOUT;
+    double memory = SERVE_MEMORY;
+};
+
+// Parses a request, a JSON object whose values are strings or numbers. Returns false
+// with the reason in error if the request can't be read.
+bool parse_request(const std::string& line, request_t& request, std::string& error);
+
+// Runs the prover as a server. Requests are read from stdin, one JSON object per line:
+//
+//   {"id": "t1", "theorem": "P(a)\n* P(a)", "timeout": 10, "memory": 1024}
+//
+// The id may be a string or a number and is echoed back as it was given. The timeout
+// in seconds and memory limit in megabytes are optional numbers, 0 meaning no limit.
+// The modules of the manifest are loaded once up front and each request is proved in a
+// process of its own forked from the server, so requests run concurrently, share the
+// loaded modules and can't take the server down. Changes to the .dat files of loaded
+// modules are not picked up until the server is restarted. Replies are written to
+// stdout, one JSON object per line: {"status": "ready"} once the server is ready, then
+// for each request {"id": ..., "status": "started"}, {"id": ..., "output": <line>} for
+// each line the prover prints and finally {"id": ..., "status": <status>, "time": <ms>},
+// where status is one of "proved", "not proved", "timeout", "crashed" or "error". A
+// request that can't be read gets {"id": ..., "status": "error", "message": <why>}.
+// Returns when stdin is closed and all requests are finished.
+int serve(const prove_fn& prove);
+
+#endif // SERVE_H
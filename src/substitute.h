@@ -8,7 +8,8 @@
 // UnificationResult can be represented as a substitution map where a variable is mapped to its value
 using Substitution = std::unordered_map<std::string, node*>;
 
-node* substitute(node* formula, const Substitution& subst);
+// Returns a copy of the formula with the substitution applied, the formula itself is left unchanged
+node* substitute(const node* formula, const Substitution& subst);
 
 void cleanup_subst(Substitution& subst);
 
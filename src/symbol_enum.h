@@ -1,35 +1,16 @@
 #ifndef SYMBOL_ENUM_H
 #define SYMBOL_ENUM_H
 
+#include "symbol_list.h"
+
+#define SYMBOL_ENUM_ENTRY(name, prec, assoc, fixity, nonlogical, repr, unicode) name,
+
 // Enum for representing various operators and constants in the AST
 typedef enum {
-    SYMBOL_NONE,
-    SYMBOL_FORALL,
-    SYMBOL_EXISTS,
-    SYMBOL_IMPLIES,
-    SYMBOL_IFF,
-    SYMBOL_AND,
-    SYMBOL_OR,
-    SYMBOL_NOT,
-    SYMBOL_LEQ,
-    SYMBOL_LT,
-    SYMBOL_ADD,
-    SYMBOL_MUL,
-    SYMBOL_EXP,
-    SYMBOL_EQUALS,
-    SYMBOL_SUBSET,
-    SYMBOL_SUBSETEQ,
-    SYMBOL_ELEM,
-    SYMBOL_TOP,
-    SYMBOL_BOT,
-    SYMBOL_POWERSET,
-    SYMBOL_CAP,
-    SYMBOL_CUP,
-    SYMBOL_TIMES,
-    SYMBOL_SETMINUS,
-    SYMBOL_EMPTYSET,
-    SYMBOL_ONE,
-    SYMBOL_MONE
+    SYMBOL_LIST(SYMBOL_ENUM_ENTRY)
+    SYMBOL_COUNT
 } symbol_enum;
 
+#undef SYMBOL_ENUM_ENTRY
+
 #endif // SYMBOL_ENUM_H
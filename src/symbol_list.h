@@ -0,0 +1,40 @@
+#ifndef SYMBOL_LIST_H
+#define SYMBOL_LIST_H
+
+// The single list of symbols, used to generate both symbol_enum and the precedence table
+// so that they can't get out of step. Each entry gives the enum name, then precedence,
+// associativity, fixity, whether the symbol is non-logical, representation for
+// re-parsing and unicode representation. Non-logical symbols are the built in
+// predicates, operators and constants that premise selection matches records on.
+// The order is significant: symbols from SYMBOL_EQUALS onwards are treated as constants
+// by node_get_constants.
+#define SYMBOL_LIST(X) \
+    X(SYMBOL_NONE,      0, NONE,  FUNCTIONAL, false, "",            "")  \
+    X(SYMBOL_FORALL,    0, NONE,  NONE,       false, "\\forall",    "∀") \
+    X(SYMBOL_EXISTS,    0, NONE,  NONE,       false, "\\exists",    "∃") \
+    X(SYMBOL_IMPLIES,   5, NONE,  INFIX,      false, "\\implies",   "→") \
+    X(SYMBOL_IFF,       5, RIGHT, INFIX,      false, "\\iff",       "↔") \
+    X(SYMBOL_AND,       5, LEFT,  INFIX,      false, "\\wedge",     "∧") \
+    X(SYMBOL_OR,        5, LEFT,  INFIX,      false, "\\vee",       "∨") \
+    X(SYMBOL_NOT,       0, NONE,  FUNCTIONAL, false, "\\neg",       "¬") \
+    X(SYMBOL_LEQ,       4, NONE,  INFIX,      true,  "\\leq",       "≤") \
+    X(SYMBOL_LT,        4, NONE,  INFIX,      true,  "<",           "<") \
+    X(SYMBOL_ADD,       3, LEFT,  INFIX,      true,  "+",           "+") \
+    X(SYMBOL_MUL,       2, LEFT,  INFIX,      true,  "*",           "*") \
+    X(SYMBOL_EXP,       1, RIGHT, INFIX,      true,  "^",           "^") \
+    X(SYMBOL_EQUALS,    4, NONE,  INFIX,      true,  "=",           "=") \
+    X(SYMBOL_SUBSET,    3, NONE,  INFIX,      true,  "\\subset",    "⊂") \
+    X(SYMBOL_SUBSETEQ,  3, NONE,  INFIX,      true,  "\\subseteq",  "⊆") \
+    X(SYMBOL_ELEM,      3, NONE,  INFIX,      true,  "\\in",        "∈") \
+    X(SYMBOL_TOP,       0, NONE,  NONE,       false, "\\top",       "⊤") \
+    X(SYMBOL_BOT,       0, NONE,  NONE,       false, "\\bot",       "⊥") \
+    X(SYMBOL_POWERSET,  0, NONE,  FUNCTIONAL, true,  "\\mathcal{P}", "𝒫") \
+    X(SYMBOL_CAP,       2, LEFT,  INFIX,      true,  "\\cap",       "∩") \
+    X(SYMBOL_CUP,       2, LEFT,  INFIX,      true,  "\\cup",       "∪") \
+    X(SYMBOL_TIMES,     2, LEFT,  INFIX,      true,  "\\times",     "×") \
+    X(SYMBOL_SETMINUS,  2, LEFT,  INFIX,      true,  "\\setminus",  "∖") \
+    X(SYMBOL_EMPTYSET,  0, NONE,  NONE,       true,  "\\emptyset",  "∅") \
+    X(SYMBOL_ONE,       0, NONE,  NONE,       true,  "1",           "1") \
+    X(SYMBOL_MONE,      0, NONE,  NONE,       true,  "-1",          "-1")
+
+#endif // SYMBOL_LIST_H
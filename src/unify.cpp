@@ -2,20 +2,22 @@
 #include "node.h"
 #include "unify.h"
 #include "substitute.h"
+#include "egraph.h"
 #include <iostream>
 #include <unordered_map>
 #include <optional>
 #include <string>
 #include <vector>
 
-// Function to check if a variable occurs in a node (occurs check)
-bool occurs_check(node* var, node* node) {
-    if (node->type == VARIABLE && node->name() == var->name()) {
-        return true;
-    }
-
-    for (auto& child : node->children) {
-        if (occurs_check(var, child)) {
+// Whether a variable with the given name occurs in the term. Names are only compared
+// at variable nodes and constants are skipped without a call.
+static bool occurs_in(const std::string& var_name, const node* term) {
+    for (const node* child : term->children) {
+        if (child->type == VARIABLE) {
+            if (child->vdata->name == var_name) {
+                return true;
+            }
+        } else if (child->type != CONSTANT && occurs_in(var_name, child)) {
             return true;
         }
     }
@@ -23,29 +25,30 @@ bool occurs_check(node* var, node* node) {
 }
 
 // Function to unify a variable with a node
-std::optional<Substitution> unify_variable(node* var, node* term, Substitution& subst, bool smgu) {
-    std::string var_name = var->name();
+std::optional<Substitution> unify_variable(node* var, node* term, Substitution& subst, bool smgu, const egraph* eg) {
+    const std::string& var_name = var->vdata->name;
 
     // If the variable is already bound in the substitution map, unify the mapped value with the term
-    if (subst.find(var_name) != subst.end()) {
-        return unify(subst[var_name], term, subst, smgu);
+    auto it = subst.find(var_name);
+    if (it != subst.end()) {
+        return unify(it->second, term, subst, smgu, eg);
     }
 
     // If the term is already a variable mapped in the substitution, unify them
     if (term->is_variable()) {
-        std::string term_name = term->name();
-        if (subst.find(term_name) != subst.end()) {
-            return unify(var, subst[term_name], subst, smgu);
+        auto term_it = subst.find(term->vdata->name);
+        if (term_it != subst.end()) {
+            return unify(var, term_it->second, subst, smgu, eg);
         }
     }
 
-    // Variable unifies with itself
-    if (term->type == VARIABLE && term->name() == var->name()) {
-        return subst;
-    }
-    
-    // If the variable occurs in the term (occurs check), fail to avoid infinite loops
-    if (occurs_check(var, term)) {
+    if (term->type == VARIABLE) {
+        // Variable unifies with itself, any other variable can't contain it
+        if (term->vdata->name == var_name) {
+            return subst;
+        }
+    } else if (term->type != CONSTANT && occurs_in(var_name, term)) {
+        // If the variable occurs in the term (occurs check), fail to avoid infinite loops
         return std::nullopt;
     }
 
@@ -61,16 +64,16 @@ std::optional<Substitution> unify_variable(node* var, node* term, Substitution&
     return subst;
 }
 
-// Function to unify two nodes
-std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst, bool smgu) {
+// Function to unify two nodes by their structure, subterms are unified by unify
+static std::optional<Substitution> unify_structure(node* node1, node* node2, Substitution& subst, bool smgu, const egraph* eg) {
     // If node1 is a variable, ensure it is a true variable before trying to unify
     if (node1->is_free_variable() && (smgu || !node1->is_shared_variable())) {
-        return unify_variable(node1, node2, subst, smgu);
+        return unify_variable(node1, node2, subst, smgu, eg);
     }
 
     // If node2 is a variable, ensure it is a true variable before trying to unify
     if (node2->is_free_variable() && (smgu || !node2->is_shared_variable())) {
-        return unify_variable(node2, node1, subst, smgu);
+        return unify_variable(node2, node1, subst, smgu, eg);
     }
 
     // If both nodes are PARAMETERS
@@ -97,7 +100,7 @@ std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst,
 
         // Unify the arguments of the applications
         for (size_t i = 0; i < node1->children.size(); ++i) {
-            auto result = unify(node1->children[i], node2->children[i], subst, smgu);
+            auto result = unify(node1->children[i], node2->children[i], subst, smgu, eg);
             if (!result.has_value()) {
                 return std::nullopt;
             }
@@ -130,7 +133,7 @@ std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst,
 
         // Unify the arguments of the applications
         for (size_t i = 1; i < node1->children.size(); ++i) {
-            auto result = unify(node1->children[i], node2->children[i], subst, smgu);
+            auto result = unify(node1->children[i], node2->children[i], subst, smgu, eg);
             if (!result.has_value()) {
                 return std::nullopt;
             }
@@ -147,7 +150,7 @@ std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst,
 
         // Unify the elements of the tuples
         for (size_t i = 0; i < node1->children.size(); ++i) {
-            auto result = unify(node1->children[i], node2->children[i], subst, smgu);
+            auto result = unify(node1->children[i], node2->children[i], subst, smgu, eg);
             if (!result.has_value()) {
                 return std::nullopt;
             }
@@ -169,7 +172,7 @@ std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst,
     if (node1->type == LOGICAL_UNARY && node2->type == LOGICAL_UNARY) {
         // Both must be SYMBOL_NOT to unify
         if (node1->symbol == node2->symbol) {
-            return unify(node1->children[0], node2->children[0], subst, smgu);
+            return unify(node1->children[0], node2->children[0], subst, smgu, eg);
         } else {
             return std::nullopt; // Different logical unary operations
         }
@@ -180,11 +183,11 @@ std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst,
         // The symbols must match (IFF, IMPLIES, AND, OR)
         if (node1->symbol == node2->symbol) {
             // Unify both left and right children
-            auto left_result = unify(node1->children[0], node2->children[0], subst, smgu);
+            auto left_result = unify(node1->children[0], node2->children[0], subst, smgu, eg);
             if (!left_result.has_value()) {
                 return std::nullopt;
             }
-            auto right_result = unify(node1->children[1], node2->children[1], subst, smgu);
+            auto right_result = unify(node1->children[1], node2->children[1], subst, smgu, eg);
             if (!right_result.has_value()) {
                 return std::nullopt;
             }
@@ -206,7 +209,7 @@ std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst,
             node* bound_var1 = node1->children[0];
             node* bound_var2 = node2->children[0];
 
-            auto bound_result = unify_variable(bound_var1, bound_var2, local_subst, smgu);
+            auto bound_result = unify_variable(bound_var1, bound_var2, local_subst, smgu, eg);
             if (!bound_result.has_value()) {
                 return std::nullopt; // Bound variables must match or unification failed
             }
@@ -214,7 +217,7 @@ std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst,
             // Apply the local substitution to the inner formulas and unify them
             node* inner_formula1 = node1->children[1];
             node* inner_formula2 = node2->children[1];
-            auto inner_result = unify(inner_formula1, inner_formula2, local_subst, smgu);
+            auto inner_result = unify(inner_formula1, inner_formula2, local_subst, smgu, eg);
             if (!inner_result.has_value()) {
                 return std::nullopt; // Inner formulas cannot be unified
             }
@@ -229,4 +232,298 @@ std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst,
 
     // If the nodes cannot be unified, return nullopt
     return std::nullopt;
-}
\ No newline at end of file
+}
+
+std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst, bool smgu, const egraph* eg) {
+    std::optional<Substitution> result = unify_structure(node1, node2, subst, smgu, eg);
+
+    // Terms without variables that differ in a head or an argument may still be equal
+    // modulo the known equalities. Binding no variables, they leave subst unchanged.
+    if (!result.has_value() && eg && node1->is_term() && node2->is_term() && eg->equivalent(node1, node2)) {
+        return subst;
+    }
+
+    return result;
+}
+
+// Function to match a pattern against a term
+bool match(node* pattern, node* term, Substitution& subst) {
+    // Free variables of the pattern match any term, consistently with earlier bindings
+    if (pattern->is_free_variable()) {
+        auto it = subst.find(pattern->name());
+        if (it != subst.end()) {
+            if (!equal(it->second, term)) {
+                return false; // Already bound to something else
+            }
+            return true;
+        }
+
+        if (!term->is_term()) {
+            return false; // Only terms can be assigned to individual variables
+        }
+
+        subst[pattern->name()] = term;
+        return true;
+    }
+
+    if (pattern->type != term->type || pattern->children.size() != term->children.size()) {
+        return false;
+    }
+
+    switch (pattern->type) {
+    case VARIABLE:
+        // Parameters, bound variables, functions and predicates must be identical
+        if (pattern->vdata->var_kind != term->vdata->var_kind ||
+            pattern->name() != term->name()) {
+            return false;
+        }
+        return true;
+    case APPLICATION:
+        // Function/predicate symbols are not matched, they must be identical
+        if (pattern->children[0]->type != VARIABLE || term->children[0]->type != VARIABLE ||
+            pattern->children[0]->vdata->var_kind != term->children[0]->vdata->var_kind ||
+            pattern->children[0]->name() != term->children[0]->name()) {
+            return false;
+        }
+        for (size_t i = 1; i < pattern->children.size(); ++i) {
+            if (!match(pattern->children[i], term->children[i], subst)) {
+                return false;
+            }
+        }
+        return true;
+    case QUANTIFIER:
+        return false; // Not needed for rewriting
+    default:
+        // Constants, operators, predicates and logical connectives
+        if (pattern->symbol != term->symbol) {
+            return false;
+        }
+        for (size_t i = 0; i < pattern->children.size(); ++i) {
+            if (!match(pattern->children[i], term->children[i], subst)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+// Key of a variable in a banked substitution
+static std::string bank_key(const node* var, int bank) {
+    return std::to_string(bank) + ":" + var->name();
+}
+
+// Whether two variable nodes are the same variable, individual variables in
+// different banks being distinct unless they are shared
+static bool same_variable(const node* var1, int bank1, const node* var2, int bank2) {
+    if (var1->vdata->name != var2->vdata->name || var1->vdata->var_kind != var2->vdata->var_kind) {
+        return false;
+    }
+
+    return bank1 == bank2 || var1->vdata->var_kind != INDIVIDUAL || var1->vdata->shared || var2->vdata->shared;
+}
+
+// Occurs check for variable banks
+static bool occurs_check_banks(node* var, int var_bank, node* term, int term_bank) {
+    if (term->type == VARIABLE) {
+        return same_variable(var, var_bank, term, term_bank);
+    }
+
+    for (auto& child : term->children) {
+        if (child->type != CONSTANT && occurs_check_banks(var, var_bank, child, term_bank)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Function to unify a variable with a node, each in their own bank
+static std::optional<BankedSubstitution> unify_variable_banks(node* var, int var_bank, node* term, int term_bank, BankedSubstitution& subst, bool smgu, const BankMasks* masks) {
+    std::string var_key = bank_key(var, var_bank);
+
+    // If the variable is already bound, unify the value with the term
+    auto it = subst.find(var_key);
+    if (it != subst.end()) {
+        auto [value, value_bank] = it->second;
+        return unify_banks(value, value_bank, term, term_bank, subst, smgu, masks);
+    }
+
+    // If the term is a bound variable, unify the variable with its value
+    if (term->is_variable()) {
+        auto term_it = subst.find(bank_key(term, term_bank));
+        if (term_it != subst.end()) {
+            auto [value, value_bank] = term_it->second;
+            return unify_banks(var, var_bank, value, value_bank, subst, smgu, masks);
+        }
+    }
+
+    // Variable unifies with itself
+    if (term->type == VARIABLE && same_variable(var, var_bank, term, term_bank)) {
+        return subst;
+    }
+
+    // The summary of the bank of the term settles most occurs checks without a traversal
+    bool may_occur = !masks || term_bank < 0 || term_bank >= static_cast<int>(masks->size()) ||
+                     ((*masks)[term_bank] & var_bit(var->vdata->name));
+    if (may_occur && occurs_check_banks(var, var_bank, term, term_bank)) {
+        return std::nullopt;
+    }
+
+    if (term->type == VARIABLE || term->type == CONSTANT ||
+        term->type == APPLICATION || term->type == TUPLE ||
+        term->type == BINARY_OP || term->type == UNARY_OP) {
+            subst[var_key] = {term, term_bank};
+    } else {
+        return std::nullopt;
+    }
+
+    return subst;
+}
+
+// Function to unify two nodes whose variables are in different banks
+std::optional<BankedSubstitution> unify_banks(node* node1, int bank1, node* node2, int bank2, BankedSubstitution& subst, bool smgu, const BankMasks* masks) {
+    if (node1->is_free_variable() && (smgu || !node1->is_shared_variable())) {
+        return unify_variable_banks(node1, bank1, node2, bank2, subst, smgu, masks);
+    }
+
+    if (node2->is_free_variable() && (smgu || !node2->is_shared_variable())) {
+        return unify_variable_banks(node2, bank2, node1, bank1, subst, smgu, masks);
+    }
+
+    if (node1->type != node2->type) {
+        return std::nullopt;
+    }
+
+    switch (node1->type) {
+    case VARIABLE:
+        if (node1->vdata->var_kind != node2->vdata->var_kind ||
+            !same_variable(node1, bank1, node2, bank2)) {
+            return std::nullopt;
+        }
+        return subst;
+    case CONSTANT:
+        if (node1->symbol != node2->symbol) {
+            return std::nullopt;
+        }
+        return subst;
+    case APPLICATION:
+        // Functions/predicates must have the same name and arity
+        if (node1->children[0]->type != VARIABLE || node2->children[0]->type != VARIABLE ||
+            node1->children[0]->vdata->var_kind != node2->children[0]->vdata->var_kind ||
+            node1->children[0]->name() != node2->children[0]->name() ||
+            node1->children.size() != node2->children.size()) {
+            return std::nullopt;
+        }
+        for (size_t i = 1; i < node1->children.size(); ++i) {
+            if (!unify_banks(node1->children[i], bank1, node2->children[i], bank2, subst, smgu, masks).has_value()) {
+                return std::nullopt;
+            }
+        }
+        return subst;
+    case QUANTIFIER: {
+        if (node1->symbol != node2->symbol) {
+            return std::nullopt;
+        }
+
+        // Bound variables are assigned in a local substitution
+        BankedSubstitution local_subst = subst;
+        if (!unify_variable_banks(node1->children[0], bank1, node2->children[0], bank2, local_subst, smgu, masks).has_value() ||
+            !unify_banks(node1->children[1], bank1, node2->children[1], bank2, local_subst, smgu, masks).has_value()) {
+            return std::nullopt;
+        }
+
+        subst = local_subst;
+        return subst;
+    }
+    default:
+        // Predicates, operators, tuples and logical connectives
+        if (node1->symbol != node2->symbol || node1->children.size() != node2->children.size()) {
+            return std::nullopt;
+        }
+        for (size_t i = 0; i < node1->children.size(); ++i) {
+            if (!unify_banks(node1->children[i], bank1, node2->children[i], bank2, subst, smgu, masks).has_value()) {
+                return std::nullopt;
+            }
+        }
+        return subst;
+    }
+}
+
+node* substitute_banks(const node* formula, int bank, const BankedSubstitution& subst) {
+    if (formula->type == VARIABLE) {
+        auto it = subst.find(bank_key(formula, bank));
+        if (it != subst.end()) {
+            auto [value, value_bank] = it->second;
+            return substitute_banks(value, value_bank, subst);
+        }
+
+        return deep_copy(formula);
+    }
+
+    // Build the node from substituted children, as substitute does
+    node* result = new node(formula->type, formula->symbol);
+    result->children.reserve(formula->children.size());
+    for (const node* child : formula->children) {
+        result->children.push_back(substitute_banks(child, bank, subst));
+    }
+
+    return result;
+}
+
+// Follows the bindings of a variable of the given bank until a term that is not a bound
+// variable is reached, updating the bank to the one of the term
+static const node* resolve_banks(const node* term, int& bank, const BankedSubstitution& subst) {
+    while (term->type == VARIABLE) {
+        auto it = subst.find(bank_key(term, bank));
+        if (it == subst.end()) {
+            break;
+        }
+        term = it->second.first;
+        bank = it->second.second;
+    }
+
+    return term;
+}
+
+// Compares as equal() does, with bound variables of a mapped to those of b in var_map
+static bool equal_banked_helper(const node* a, const node* b, int bank, const BankedSubstitution& subst,
+                                std::unordered_map<std::string, std::string>& var_map) {
+    b = resolve_banks(b, bank, subst);
+
+    if (a->type != b->type) {
+        return false;
+    }
+
+    if (a->type == VARIABLE) {
+        if (a->vdata->var_kind == INDIVIDUAL) {
+            auto it = var_map.find(a->vdata->name);
+            if (it != var_map.end()) {
+                return it->second == b->vdata->name;
+            }
+        }
+        return a->vdata->name == b->vdata->name;
+    }
+
+    if ((a->type != APPLICATION && a->type != TUPLE && a->symbol != b->symbol) ||
+        a->children.size() != b->children.size()) {
+        return false;
+    }
+
+    if (a->type == QUANTIFIER) {
+        int var_bank = bank;
+        var_map[a->children[0]->vdata->name] = resolve_banks(b->children[0], var_bank, subst)->vdata->name;
+        return equal_banked_helper(a->children[1], b->children[1], bank, subst, var_map);
+    }
+
+    for (size_t i = 0; i < a->children.size(); ++i) {
+        if (!equal_banked_helper(a->children[i], b->children[i], bank, subst, var_map)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool equal_banked(const node* formula, const banked_term& term) {
+    std::unordered_map<std::string, std::string> var_map;
+    return equal_banked_helper(formula, term.formula, term.bank, *term.subst, var_map);
+}
@@ -3,7 +3,49 @@
 
 #include "substitute.h"
 #include <optional>
+#include <vector>
+#include <cstdint>
 
-std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst, bool smgu=false);
+class egraph;
+
+// Unify two formulas. If an e-graph is given, terms in the same congruence class
+// unify without being rewritten. It is only asked about terms without variables
+// that don't unify structurally.
+std::optional<Substitution> unify(node* node1, node* node2, Substitution& subst, bool smgu=false, const egraph* eg=nullptr);
+
+// One-sided matching: only free variables of the pattern are assigned, so that the
+// pattern with the substitution applied is the term. Variables of the term are
+// treated as constants. Bindings point into the term, they are not copies. Returns
+// whether the pattern matches, with its bindings added to subst.
+bool match(node* pattern, node* term, Substitution& subst);
+
+// Substitution for unification with variable banks: keys are "bank:name" and each
+// value is recorded with the bank its variables belong to
+using BankedSubstitution = std::unordered_map<std::string, std::pair<node*, int>>;
+
+// Variable summaries of the formulas in each bank, indexed by bank, as node_info::var_mask
+using BankMasks = std::vector<uint64_t>;
+
+// Unify two formulas whose variables are in different banks, so that variables of
+// the same name in node1 and node2 are distinct without copying and renaming.
+// Gives the same answer as unify after renaming the common variables apart. If
+// summaries of the banks are given, the occurs check only traverses a term when the
+// summary of its bank says the variable may occur in it.
+std::optional<BankedSubstitution> unify_banks(node* node1, int bank1, node* node2, int bank2, BankedSubstitution& subst, bool smgu=false, const BankMasks* masks=nullptr);
+
+// Returns a copy of the formula, whose variables are in the given bank, with the
+// banked substitution applied
+node* substitute_banks(const node* formula, int bank, const BankedSubstitution& subst);
+
+// A formula whose variables are in the given bank with the banked substitution applied
+// lazily, i.e. without building the result. substitute_banks builds it if it is kept.
+struct banked_term {
+    const node* formula;
+    int bank;
+    const BankedSubstitution* subst;
+};
+
+// Whether the formula is equal() to the banked term with its substitution applied
+bool equal_banked(const node* formula, const banked_term& term);
 
 #endif // UNIFY_H
@@ -0,0 +1,168 @@
+#include "../src/node.h"
+#include "../src/grammar.h"
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+// Function to parse a formula using the parser
+node* parse_formula(const std::string& formula) {
+    manager_t mgr;
+    parser_context_t *ctx = parser_create(&mgr);
+    node* ast = nullptr;
+
+    std::string modified_input = formula + "\n";
+    mgr.input = modified_input.c_str();
+    mgr.pos = 0;
+
+    parser_parse(ctx, &ast);
+    parser_destroy(ctx);
+
+    if (!ast) {
+        std::cerr << "Failed to parse formula: " << formula << "\n";
+    }
+
+    return ast;
+}
+
+// Marks the variables with the given name as shared
+void share_var(node* formula, const std::string& name) {
+    if (formula->type == VARIABLE && formula->vdata->name == name) {
+        formula->vdata->shared = true;
+    }
+    for (node* child : formula->children) {
+        share_var(child, name);
+    }
+}
+
+int main() {
+    struct TestCase {
+        std::string formula;
+        std::vector<std::string> free_vars;
+        size_t depth;
+        size_t term_depth;
+    };
+
+    std::vector<TestCase> test_cases = {
+        {"P(x)", {"x"}, 2, 1},
+        {"P(f(x, g(y)))", {"x", "y"}, 4, 3},
+        {"P(\\emptyset)", {}, 2, 1},
+        {"\\forall x P(x, y)", {"y"}, 3, 1},
+        {"\\forall x \\exists y (f(x) = y)", {}, 5, 2},
+        {"P(x) \\implies (Q(y) \\wedge R(h(z)))", {"x", "y", "z"}, 5, 2}
+    };
+
+    std::cout << "Running tests..." << std::endl;
+
+    bool all_passed = true;
+    for (const auto& test : test_cases) {
+        node* formula = parse_formula(test.formula);
+        if (!formula) {
+            all_passed = false;
+            continue;
+        }
+
+        node_info info = annotate(formula);
+
+        if (info.free_vars != test.free_vars || info.ground != test.free_vars.empty()) {
+            std::cout << "Free variables test failed for: " << test.formula << "\n";
+            all_passed = false;
+        }
+
+        if (info.depth != test.depth || info.term_depth != test.term_depth) {
+            std::cout << "Depth test failed for: " << test.formula << "\n";
+            all_passed = false;
+        }
+
+        // The single traversal must agree with the functions built on it
+        std::set<std::string> vars;
+        vars_used(vars, formula, false, false);
+        if (std::vector<std::string>(vars.begin(), vars.end()) != info.free_vars ||
+            max_term_depth(formula) != info.term_depth || formula_depth(formula) != info.depth) {
+            std::cout << "Consistency test failed for: " << test.formula << "\n";
+            all_passed = false;
+        }
+
+        // Every individual variable, bound or free, has its bit in the mask
+        std::set<std::string> all_vars;
+        vars_used(all_vars, formula, false, true);
+        for (const std::string& var : all_vars) {
+            if (!(info.var_mask & var_bit(var))) {
+                std::cout << "Variable mask test failed for: " << test.formula << "\n";
+                all_passed = false;
+            }
+        }
+
+        // A formula parsed again has the same hash
+        node* again = parse_formula(test.formula);
+        if (annotate(again).hash != info.hash) {
+            std::cout << "Hash test failed for: " << test.formula << "\n";
+            all_passed = false;
+        }
+
+        if (info.shared || formula->has_shared_vars()) {
+            std::cout << "Shared variable test failed for: " << test.formula << "\n";
+            all_passed = false;
+        }
+
+        if (!test.free_vars.empty()) {
+            share_var(again, test.free_vars[0]);
+            if (!annotate(again).shared || !again->has_shared_vars()) {
+                std::cout << "Shared variable test failed for: " << test.formula << "\n";
+                all_passed = false;
+            }
+        }
+
+        delete again;
+        delete formula;
+    }
+
+    // Formulas differing only in the names of bound variables have the same hash
+    std::vector<std::pair<std::string, std::string>> renamed = {
+        {"\\forall x P(x)", "\\forall y P(y)"},
+        {"\\forall x \\exists y (f(x) = y)", "\\forall y \\exists x (f(y) = x)"},
+        {"\\forall x (P(x, z) \\wedge \\exists y Q(x, y))", "\\forall y (P(y, z) \\wedge \\exists w Q(y, w))"}
+    };
+
+    for (const auto& [a, b] : renamed) {
+        node* formula_a = parse_formula(a);
+        node* formula_b = parse_formula(b);
+
+        if (!equal(formula_a, formula_b) || annotate(formula_a).hash != annotate(formula_b).hash) {
+            std::cout << "Hash test failed for: " << a << " and " << b << "\n";
+            all_passed = false;
+        }
+
+        delete formula_a;
+        delete formula_b;
+    }
+
+    // Formulas differing in a variable or a function have different hashes
+    std::vector<std::pair<std::string, std::string>> different = {
+        {"P(x)", "P(y)"},
+        {"\\forall x P(x, y)", "\\forall y P(y, y)"},
+        {"\\forall x \\forall y P(x, y)", "\\forall x \\forall y P(y, x)"},
+        {"P(f(x))", "P(g(x))"},
+        {"P(x, y)", "P(y, x)"},
+        {"P(x) \\wedge Q(x)", "P(x) \\vee Q(x)"}
+    };
+
+    for (const auto& [a, b] : different) {
+        node* formula_a = parse_formula(a);
+        node* formula_b = parse_formula(b);
+
+        if (annotate(formula_a).hash == annotate(formula_b).hash) {
+            std::cout << "Hash test failed for: " << a << " and " << b << "\n";
+            all_passed = false;
+        }
+
+        delete formula_a;
+        delete formula_b;
+    }
+
+    if (all_passed) {
+        std::cout << "All tests passed!\n";
+    }
+
+    return all_passed ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+#include "../src/node.h"
+#include "../src/grammar.h"
+#include "../src/egraph.h"
+#include "../src/fingerprint.h"
+#include "../src/unify.h"
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+// Function to parse a term using the parser
+node* parse_term(const std::string& term) {
+    manager_t mgr;
+    parser_context_t *ctx = parser_create(&mgr);
+    node* ast = nullptr;
+
+    std::string modified_input = "P(" + term + ")\n";
+    mgr.input = modified_input.c_str();
+    mgr.pos = 0;
+
+    parser_parse(ctx, &ast);
+    parser_destroy(ctx);
+
+    if (!ast) {
+        std::cerr << "Failed to parse term: " << term << "\n";
+        return nullptr;
+    }
+
+    node* result = ast->children[1];
+    ast->children.pop_back(); // Detach the term from the predicate
+    delete ast;
+
+    return result;
+}
+
+// Turns all free variables into parameters, so that the term is stored in the e-graph
+void parameterize_vars(node* term) {
+    if (term->is_free_variable()) {
+        term->vdata->var_kind = PARAMETER;
+    }
+    for (node* child : term->children) {
+        parameterize_vars(child);
+    }
+}
+
+int main() {
+    struct TestCase {
+        std::vector<std::pair<std::string, std::string>> equalities; // Merged with reasons 1, 2, ...
+        std::vector<std::pair<std::string, std::string>> rules;      // Added with reasons 10, 11, ...
+        std::vector<std::string> terms;                              // Added before the equalities
+        std::string a;
+        std::string b;
+        bool expected;
+        std::set<int> reasons; // Expected explanation if a and b are equivalent
+    };
+
+    std::vector<TestCase> test_cases = {
+        // Merge
+        {{{"a", "b"}}, {}, {}, "a", "b", true, {1}},
+        {{{"a", "b"}}, {}, {"c"}, "a", "c", false, {}},
+        // Congruence, for terms added before and after the merges
+        {{{"a", "b"}}, {}, {"f(a)", "f(b)"}, "f(a)", "f(b)", true, {1}},
+        {{{"a", "b"}, {"b", "c"}, {"d", "e"}}, {}, {"f(a, d)", "f(c, d)"}, "f(a, d)", "f(c, d)", true, {1, 2}},
+        {{{"a", "b"}, {"c", "d"}}, {}, {"g(f(a), c)", "g(f(b), d)"}, "g(f(a), c)", "g(f(b), d)", true, {1, 2}},
+        // Saturation with rules
+        {{}, {{"x*1", "x"}}, {"a*1", "a"}, "a*1", "a", true, {10}},
+        {{{"a", "b"}}, {{"x*1", "x"}}, {"a*1", "b"}, "a*1", "b", true, {1, 10}},
+        {{}, {{"x*1", "x"}, {"1*x", "x"}}, {"(1*a)*1", "a"}, "(1*a)*1", "a", true, {10, 11}},
+        {{}, {{"x*1", "x"}}, {"1*a", "a"}, "1*a", "a", false, {}}
+    };
+
+    std::cout << "Running tests..." << std::endl;
+
+    bool all_passed = true;
+    for (const auto& test : test_cases) {
+        egraph eg;
+        std::vector<node*> owned; // The e-graph does not copy terms or rules
+
+        for (const auto& term : test.terms) {
+            node* parsed = parse_term(term);
+            parameterize_vars(parsed);
+            eg.add_term(parsed);
+            owned.push_back(parsed);
+        }
+
+        int reason = 1;
+        for (const auto& [lhs, rhs] : test.equalities) {
+            node* parsed_lhs = parse_term(lhs);
+            node* parsed_rhs = parse_term(rhs);
+            parameterize_vars(parsed_lhs);
+            parameterize_vars(parsed_rhs);
+            eg.merge_terms(parsed_lhs, parsed_rhs, reason++);
+            owned.push_back(parsed_lhs);
+            owned.push_back(parsed_rhs);
+        }
+
+        reason = 10;
+        for (const auto& [lhs, rhs] : test.rules) {
+            node* parsed_lhs = parse_term(lhs);
+            node* parsed_rhs = parse_term(rhs);
+            eg.add_rule(parsed_lhs, parsed_rhs, reason++);
+            owned.push_back(parsed_lhs);
+            owned.push_back(parsed_rhs);
+        }
+
+        eg.saturate();
+
+        node* a = parse_term(test.a);
+        node* b = parse_term(test.b);
+        parameterize_vars(a);
+        parameterize_vars(b);
+
+        if (eg.equivalent(a, b) != test.expected) {
+            std::cout << "Equivalence test failed for: " << test.a << " = " << test.b << "\n";
+            all_passed = false;
+        } else if (test.expected) {
+            std::set<int> reasons;
+            eg.explain(a, b, reasons);
+            if (reasons != test.reasons) {
+                std::cout << "Explanation test failed for: " << test.a << " = " << test.b << "\n";
+                all_passed = false;
+            }
+        }
+
+        delete a;
+        delete b;
+        for (node* n : owned) {
+            delete n;
+        }
+    }
+
+    // Unification and fingerprints modulo the equalities
+    egraph eg;
+    node* a = parse_term("a");
+    node* b = parse_term("b");
+    node* fa = parse_term("f(a)");
+    node* fb = parse_term("f(b)");
+    node* c = parse_term("c");
+    node* fc = parse_term("f(c)");
+    node* gb = parse_term("g(b)");
+    for (node* term : {a, b, c, fa, fb, fc, gb}) {
+        parameterize_vars(term);
+    }
+    eg.add_term(fa);
+    eg.add_term(fc);
+    eg.merge_terms(a, b, 1);
+
+    Substitution subst;
+    if (!unify(fa, fb, subst, false, &eg).has_value() || unify(fa, fc, subst, false, &eg).has_value() ||
+        unify(fa, fb, subst).has_value()) {
+        std::cout << "Unification modulo equalities test failed\n";
+        all_passed = false;
+    }
+
+    // Only the positions of merged terms are wildcards
+    eg.set_cache(true);
+    if (!eg.in_merged_class(a) || eg.in_merged_class(c) ||
+        !fingerprints_compatible(get_fingerprint(fa, &eg), get_fingerprint(fb, &eg)) ||
+        fingerprints_compatible(get_fingerprint(fa), get_fingerprint(fb)) ||
+        fingerprints_compatible(get_fingerprint(fa, &eg), get_fingerprint(gb, &eg))) {
+        std::cout << "Fingerprint modulo equalities test failed\n";
+        all_passed = false;
+    }
+    eg.set_cache(false);
+
+    for (node* term : {a, b, c, fa, fb, fc, gb}) {
+        delete term;
+    }
+
+    if (all_passed) {
+        std::cout << "All tests passed!\n";
+    }
+
+    return all_passed ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+#include "../src/node_list.h"
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Distinct pointers to fill lists with, never dereferenced
+node* child(size_t i) {
+    return reinterpret_cast<node*>(static_cast<uintptr_t>(8*(i + 1)));
+}
+
+std::vector<node*> children(size_t n) {
+    std::vector<node*> list;
+    for (size_t i = 0; i < n; ++i) {
+        list.push_back(child(i));
+    }
+    return list;
+}
+
+// Checks the list holds exactly the expected children
+bool check(const node_list& list, const std::vector<node*>& expected, const std::string& test) {
+    if (list.size() != expected.size() || list.empty() != expected.empty() ||
+        !std::equal(list.begin(), list.end(), expected.begin()) ||
+        static_cast<std::vector<node*>>(list) != expected) {
+        std::cout << "Test failed: " << test << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    std::cout << "Running tests..." << std::endl;
+
+    bool all_passed = true;
+
+    // Pushing past the inline children spills to the heap
+    for (size_t n = 0; n <= 10; ++n) {
+        node_list list;
+        for (size_t i = 0; i < n; ++i) {
+            list.push_back(child(i));
+        }
+        all_passed &= check(list, children(n), "push_back of " + std::to_string(n));
+
+        node_list from_vector(children(n));
+        all_passed &= check(from_vector, children(n), "construction of " + std::to_string(n));
+
+        if (n > 0 && (list.front() != child(0) || list.back() != child(n - 1) || list[n - 1] != child(n - 1))) {
+            std::cout << "Test failed: element access of " << n << "\n";
+            all_passed = false;
+        }
+
+        // Popping back down to inline size keeps the remaining children
+        while (!list.empty()) {
+            list.pop_back();
+            all_passed &= check(list, children(list.size()), "pop_back from " + std::to_string(n));
+        }
+    }
+
+    // Inserting and erasing at every position, for lists either side of the boundary
+    for (size_t n = 0; n <= 5; ++n) {
+        for (size_t pos = 0; pos <= n; ++pos) {
+            node_list list(children(n));
+            std::vector<node*> expected = children(n);
+            node* extra = child(100);
+
+            auto it = list.insert(list.begin() + pos, extra);
+            expected.insert(expected.begin() + pos, extra);
+            if (it != list.begin() + pos || *it != extra) {
+                std::cout << "Test failed: insert result at " << pos << " of " << n << "\n";
+                all_passed = false;
+            }
+            all_passed &= check(list, expected, "insert at " + std::to_string(pos) + " of " + std::to_string(n));
+
+            it = list.erase(list.begin() + pos);
+            expected.erase(expected.begin() + pos);
+            if (it != list.begin() + pos) {
+                std::cout << "Test failed: erase result at " << pos << " of " << n << "\n";
+                all_passed = false;
+            }
+            all_passed &= check(list, expected, "erase at " + std::to_string(pos) + " of " + std::to_string(n));
+        }
+    }
+
+    // Erasing a range
+    node_list ranged(children(6));
+    ranged.erase(ranged.begin() + 1, ranged.begin() + 4);
+    all_passed &= check(ranged, {child(0), child(4), child(5)}, "erase of a range");
+    ranged.erase(ranged.begin(), ranged.end());
+    all_passed &= check(ranged, {}, "erase of everything");
+
+    // Copying, including onto itself and between inline and heap lists
+    for (size_t n : {0, 2, 3, 4, 7}) {
+        for (size_t m : {0, 2, 3, 4, 7}) {
+            node_list source(children(n));
+            node_list target(children(m));
+            node* extra = child(100);
+            target.push_back(extra);
+
+            target = source;
+            all_passed &= check(target, children(n), "copy of " + std::to_string(n) + " onto " + std::to_string(m));
+            all_passed &= check(source, children(n), "source of copy of " + std::to_string(n));
+
+            // The copy is independent of the original
+            target.push_back(extra);
+            all_passed &= check(source, children(n), "source after copy of " + std::to_string(n) + " changed");
+        }
+
+        node_list self(children(n));
+        node_list& alias = self;
+        self = alias;
+        all_passed &= check(self, children(n), "self copy of " + std::to_string(n));
+        self = std::move(alias);
+        all_passed &= check(self, children(n), "self move of " + std::to_string(n));
+
+        node_list copied(self);
+        all_passed &= check(copied, children(n), "copy construction of " + std::to_string(n));
+    }
+
+    // Moving inline and heap lists leaves the source empty and usable
+    for (size_t n : {0, 2, 3, 4, 7}) {
+        node_list source(children(n));
+        node_list moved(std::move(source));
+        all_passed &= check(moved, children(n), "move construction of " + std::to_string(n));
+        all_passed &= check(source, {}, "source of move construction of " + std::to_string(n));
+
+        for (size_t m : {0, 2, 4}) {
+            node_list target(children(m));
+            target = std::move(moved);
+            all_passed &= check(target, children(n), "move of " + std::to_string(n) + " onto " + std::to_string(m));
+            all_passed &= check(moved, {}, "source of move of " + std::to_string(n));
+
+            moved = target;
+        }
+
+        source.push_back(child(0));
+        for (size_t i = 1; i < 5; ++i) {
+            source.push_back(child(i));
+        }
+        all_passed &= check(source, children(5), "reuse of moved list of " + std::to_string(n));
+    }
+
+    // Assigning from a vector
+    node_list assigned(children(2));
+    assigned = children(6);
+    all_passed &= check(assigned, children(6), "assignment of a longer vector");
+    assigned = children(1);
+    all_passed &= check(assigned, children(1), "assignment of a shorter vector");
+
+    if (all_passed) {
+        std::cout << "All tests passed!\n";
+    }
+
+    return all_passed ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include "../src/node.h"
+#include "../src/grammar.h"
+#include "../src/ordering.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Function to parse a term using the parser
+node* parse_term(const std::string& term) {
+    manager_t mgr;
+    parser_context_t *ctx = parser_create(&mgr);
+    node* ast = nullptr;
+
+    std::string modified_input = "P(" + term + ")\n";
+    mgr.input = modified_input.c_str();
+    mgr.pos = 0;
+
+    parser_parse(ctx, &ast);
+    parser_destroy(ctx);
+
+    if (!ast) {
+        std::cerr << "Failed to parse term: " << term << "\n";
+        return nullptr;
+    }
+
+    node* result = ast->children[1];
+    ast->children.pop_back(); // Detach the term from the predicate
+    delete ast;
+
+    return result;
+}
+
+// Function to run a single test case, returns true if the test passes
+bool run_test_case(const std::string& s, const std::string& t, bool expected, TermOrdering ordering) {
+    node* parsed_s = parse_term(s);
+    node* parsed_t = parse_term(t);
+
+    if (parsed_s == nullptr || parsed_t == nullptr) {
+        return false;
+    }
+
+    bool result = term_greater(parsed_s, parsed_t, ordering);
+    bool passed = (result == expected);
+
+    if (!passed) {
+        std::cout << "Test failed for: " << s << " > " << t
+                  << (ordering == TermOrdering::KBO ? " (KBO)" : " (LPO)") << "\n";
+    }
+
+    delete parsed_s;
+    delete parsed_t;
+
+    return passed;
+}
+
+int main() {
+    struct TestCase {
+        std::string s;
+        std::string t;
+        bool expected;
+    };
+
+    // The same answers are expected from both orderings
+    std::vector<TestCase> test_cases = {
+        {"1*g", "g", true},
+        {"g", "1*g", false},
+        {"g^(-1)*g", "1", true},
+        {"(a*b)*c", "a*(b*c)", true},
+        {"a*(b*c)", "(a*b)*c", false},
+        {"a*b", "b*a", false}, // Commutativity can't be oriented
+        {"b*a", "a*b", false},
+        {"f(x)", "y", false}, // Variable not contained on the left
+        {"f(g(x))", "f(x)", true}
+    };
+
+    std::cout << "Running tests..." << std::endl;
+
+    bool all_passed = true;
+    for (const auto& test : test_cases) {
+        if (!run_test_case(test.s, test.t, test.expected, TermOrdering::KBO) ||
+            !run_test_case(test.s, test.t, test.expected, TermOrdering::LPO)) {
+            all_passed = false;
+        }
+    }
+
+    if (all_passed) {
+        std::cout << "All tests passed!\n";
+    }
+
+    return all_passed ? 0 : 1;
+}
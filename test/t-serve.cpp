@@ -0,0 +1,171 @@
+#include "../src/serve.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Runs the server on the given input and returns the lines it replies with
+std::vector<std::string> run_server(const std::string& input, const prove_fn& prove) {
+    int in[2], out[2];
+    if (pipe(in) == -1 || pipe(out) == -1) {
+        return {};
+    }
+
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        close(in[0]);
+        close(in[1]);
+        close(out[0]);
+        close(out[1]);
+        int status = serve(prove);
+        std::cout.flush();
+        _exit(status);
+    }
+
+    close(in[0]);
+    close(out[1]);
+    if (write(in[1], input.c_str(), input.size()) != static_cast<ssize_t>(input.size())) {
+        std::cerr << "Failed to write requests\n";
+    }
+    close(in[1]);
+
+    std::string output;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(out[0], buf, sizeof(buf))) > 0) {
+        output.append(buf, n);
+    }
+    close(out[0]);
+    waitpid(pid, nullptr, 0);
+
+    std::vector<std::string> lines;
+    size_t begin = 0, end;
+    while ((end = output.find('\n', begin)) != std::string::npos) {
+        lines.push_back(output.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return lines;
+}
+
+// Returns whether one of the lines starts with the given text
+bool has_reply(const std::vector<std::string>& lines, const std::string& prefix) {
+    for (const auto& line : lines) {
+        if (line.compare(0, prefix.size(), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main() {
+    struct TestCase {
+        std::string line;
+        bool valid;
+        std::string id;
+        std::string id_json;
+        std::string theorem;
+    };
+
+    std::vector<TestCase> test_cases = {
+        {"{\"id\": \"t1\", \"theorem\": \"P(a)\\n* P(a)\"}", true, "t1", "\"t1\"", "P(a)\n* P(a)\n"},
+        // Numeric ids are echoed as numbers
+        {"{\"id\": 7, \"theorem\": \"P(a)\"}", true, "7", "7", "P(a)\n"},
+        {"{\"id\": -1.5e3, \"theorem\": \"P(a)\"}", true, "-1.5e3", "-1.5e3", "P(a)\n"},
+        {"{\"theorem\": \"P(a)\"}", true, "", "\"\"", "P(a)\n"},
+        // Escapes, including a surrogate pair
+        {"{\"id\": \"a\\\"b\", \"theorem\": \"\\u00e9\\ud83d\\ude00\\t\"}", true, "a\"b", "\"a\\\"b\"", "\xC3\xA9\xF0\x9F\x98\x80\t\n"},
+        // Malformed values
+        {"{\"id\": 0x1F, \"theorem\": \"P(a)\"}", false, "", "", ""},
+        {"{\"id\": inf, \"theorem\": \"P(a)\"}", false, "", "", ""},
+        {"{\"id\": 1., \"theorem\": \"P(a)\"}", false, "", "", ""},
+        {"{\"theorem\": \"\\u12G4\"}", false, "", "", ""},
+        {"{\"theorem\": \"\\u12\"}", false, "", "", ""},
+        {"{\"theorem\": \"\\ud800\"}", false, "", "", ""},
+        {"{\"theorem\": \"\\ud800\\u0041\"}", false, "", "", ""},
+        {"{\"theorem\": \"\\udc00\"}", false, "", "", ""},
+        {"{\"theorem\": \"P(a)\"", false, "", "", ""},
+        // Limits must be non-negative numbers
+        {"{\"theorem\": \"P(a)\", \"timeout\": 0, \"memory\": 1024}", true, "", "\"\"", "P(a)\n"},
+        {"{\"theorem\": \"P(a)\", \"timeout\": \"5\"}", false, "", "", ""},
+        {"{\"theorem\": \"P(a)\", \"memory\": \"1G\"}", false, "", "", ""},
+        {"{\"theorem\": \"P(a)\", \"timeout\": -1}", false, "", "", ""},
+        {"{\"theorem\": 5}", false, "", "", ""},
+        // Members must be separated by commas
+        {"{\"id\": \"t1\" \"theorem\": \"P(a)\"}", false, "", "", ""},
+        {"{\"theorem\": \"P(a)\" x}", false, "", "", ""},
+        {"{\"theorem\": \"P(a)\",}", false, "", "", ""},
+        {"{\"theorem\": \"P(a)\",", false, "", "", ""},
+        {"{}", false, "", "", ""},
+        {"{\"id\": \"t1\"}", false, "", "", ""},
+        {"[\"P(a)\"]", false, "", "", ""}
+    };
+
+    std::cout << "Running tests..." << std::endl;
+
+    bool all_passed = true;
+    for (const auto& test : test_cases) {
+        request_t request;
+        std::string error;
+        bool valid = parse_request(test.line, request, error);
+
+        if (valid != test.valid || (valid && (request.id != test.id || request.id_json != test.id_json ||
+                                              request.theorem != test.theorem))) {
+            std::cout << "Request test failed for: " << test.line << "\n";
+            all_passed = false;
+        }
+    }
+
+    // The protocol, with a prover that proves theorems starting with P
+    std::vector<std::string> lines = run_server(
+        "{\"id\": 7, \"theorem\": \"P(a)\", \"timeout\": 10}\n"
+        "\n"
+        "{\"id\": \"t2\", \"theorem\": \"Q(a)\"}\n"
+        "{\"id\": 3, \"theorem\": \"\\uzzzz\"}\n"
+        "{\"id\": \"t4\", \"theorem\": \"P(b)\", \"timeout\": 0.5}\n"
+        "{\"id\": 5, \"theorem\": \"P(a)\", \"timeout\": \"5\"}",
+        [](const std::string& name, const std::string& theorem) {
+            std::cout << "proving " << name << std::endl;
+            if (theorem == "P(b)\n") {
+                sleep(10);
+            }
+            return theorem[0] == 'P';
+        });
+
+    std::vector<std::string> expected = {
+        "{\"status\": \"ready\"}",
+        "{\"id\": 7, \"status\": \"started\"}",
+        "{\"id\": 7, \"output\": \"proving 7\"}",
+        "{\"id\": 7, \"status\": \"proved\", \"time\": ",
+        "{\"id\": \"t2\", \"output\": \"proving t2\"}",
+        "{\"id\": \"t2\", \"status\": \"not proved\", \"time\": ",
+        "{\"id\": 3, \"status\": \"error\", \"message\": \"malformed string for theorem\"}",
+        "{\"id\": \"t4\", \"status\": \"timeout\", \"time\": ",
+        "{\"id\": 5, \"status\": \"error\", \"message\": \"expected a number for timeout\"}"
+    };
+
+    if (lines.empty() || lines[0] != expected[0]) {
+        std::cout << "Server did not report it was ready\n";
+        all_passed = false;
+    }
+    for (const auto& reply : expected) {
+        if (!has_reply(lines, reply)) {
+            std::cout << "Protocol test failed, no reply: " << reply << "\n";
+            all_passed = false;
+        }
+    }
+    if (lines.size() != 12) {
+        std::cout << "Protocol test failed, " << lines.size() << " replies\n";
+        all_passed = false;
+    }
+
+    if (all_passed) {
+        std::cout << "All tests passed!\n";
+    }
+
+    return all_passed ? 0 : 1;
+}
@@ -82,6 +82,26 @@ bool test_skolem_form(const std::string& input, const std::string& expected_outp
         std::cerr << "Actual Skolemized:      [" << skolemized_str << "]\n";
     }
 
+    // Skolemize again, asking for an independent copy of the result
+    context_t context_copy = context_t();
+    node* copy = nullptr;
+    node* skolemized_ast2 = skolem_form(context_copy, deep_copy(ast_original), &copy);
+
+    if (copy == nullptr || copy == skolemized_ast2 ||
+        copy->to_string(REPR) != skolemized_str || skolemized_ast2->to_string(REPR) != skolemized_str) {
+        std::cerr << "Test #" << test_number << " failed: copy of skolemized formula differs:\n";
+        std::cerr << "Input Formula:          [" << input << "]\n";
+        if (copy != nullptr) {
+            std::cerr << "Copy:                   [" << copy->to_string(REPR) << "]\n";
+        }
+        pass = false;
+    }
+
+    if (copy != skolemized_ast2) {
+        delete copy;
+    }
+    delete skolemized_ast2;
+
     // Clean up memory
     delete ast_expected;
     delete skolemized_ast;
@@ -108,8 +108,15 @@ bool run_test_case(const std::string& formula, const Substitution& substitution,
         std::cerr << "Expected Formula REPR:[" << repr_expected << "]\n";
     }
 
+    // The formula substituted into must be left unchanged
+    if (formula_copy->to_string(OutputFormat::REPR) != parsed_formula->to_string(OutputFormat::REPR)) {
+        std::cerr << "Test failed: Substitution changed the formula: " << formula << "\n";
+        pass = false;
+    }
+
     // Clean up memory
     delete parsed_formula;
+    delete formula_copy;
     delete substituted_formula;
     delete parsed_expected;
 
@@ -2,6 +2,8 @@
 #include "../src/substitute.h"
 #include "../src/grammar.h"
 #include "../src/unify.h"
+#include "../src/clause_code.h"
+#include "../src/automation.h"
 #include <iostream>
 #include <unordered_map>
 #include <string>
@@ -46,6 +48,16 @@ node* parse_term(const std::string& formula) {
     return f->children[1];
 }
 
+// Turns all free variables into parameters
+void parameterize_vars(node* formula) {
+    if (formula->is_free_variable()) {
+        formula->vdata->var_kind = PARAMETER;
+    }
+    for (node* child : formula->children) {
+        parameterize_vars(child);
+    }
+}
+
 // Function to print the substitutions
 void print_substitution(const Substitution& subst) {
     for (const auto& [key, value] : subst) {
@@ -104,6 +116,21 @@ bool run_test_case(const std::string& formula1, const std::string& formula2, con
     return passed;
 }
 
+// Function to run a single matching test case, returns true if the test passes
+bool run_match_case(const std::string& pattern, const std::string& term, bool expected) {
+    node* parsed_pattern = parse_term(pattern);
+    node* parsed_term = parse_term(term);
+
+    Substitution subst;
+    bool result = match(parsed_pattern, parsed_term, subst);
+
+    if (result != expected) {
+        std::cout << "Match test failed for: " << pattern << " and " << term << "\n";
+    }
+
+    return result == expected;
+}
+
 int main() {
     // Test cases: each contains a pair of formulas and the expected substitution
     struct TestCase {
@@ -131,6 +158,191 @@ int main() {
         }
     }
 
+    // Matching only assigns variables of the pattern
+    if (!run_match_case("x*1", "(a*b)*1", true) ||
+        !run_match_case("x*x", "a*b", false) ||
+        !run_match_case("x*1", "a*b", false) ||
+        !run_match_case("(a*b)*c", "(x*y)*z", true)) {
+        all_passed = false;
+    }
+
+    // A variable can't be bound to a term containing it, however deeply
+    std::vector<std::pair<std::string, std::string>> occurs_cases = {
+        {"P(x)", "P(f(x))"},
+        {"P(x)", "P((\\emptyset, g(\\emptyset, x)))"},
+        {"P(x, x)", "P(y, f(y))"}
+    };
+
+    for (const auto& [formula1, formula2] : occurs_cases) {
+        node* occurs1 = parse_formula(formula1);
+        node* occurs2 = parse_formula(formula2);
+        Substitution occurs_subst;
+        if (unify(occurs1, occurs2, occurs_subst).has_value()) {
+            std::cout << "Occurs check test failed for: " << formula1 << " and " << formula2 << "\n";
+            all_passed = false;
+        }
+
+        // The same within one bank when the check consults the summaries of the banks,
+        // while the other bank's variable of the same name is distinct
+        BankMasks one_bank = { annotate(occurs1).var_mask | annotate(occurs2).var_mask };
+        BankMasks two_banks = { annotate(occurs1).var_mask, annotate(occurs2).var_mask };
+        BankedSubstitution same_bank, other_bank;
+        if (unify_banks(occurs1, 0, occurs2, 0, same_bank, false, &one_bank).has_value() ||
+            (formula1 == "P(x)" && !unify_banks(occurs1, 0, occurs2, 1, other_bank, false, &two_banks).has_value())) {
+            std::cout << "Banked occurs check test failed for: " << formula1 << " and " << formula2 << "\n";
+            all_passed = false;
+        }
+        delete occurs1;
+        delete occurs2;
+    }
+
+    // Variables of the same name in different banks are distinct
+    BankedSubstitution banked;
+    node* bank_formula1 = parse_formula("P(x)");
+    node* bank_formula2 = parse_formula("P(f(x))");
+    Substitution plain;
+    if (!unify_banks(bank_formula1, 0, bank_formula2, 1, banked).has_value() ||
+        unify(bank_formula1, bank_formula2, plain).has_value()) {
+        std::cout << "Banked unification test failed\n";
+        all_passed = false;
+    } else {
+        node* instance = substitute_banks(bank_formula1, 0, banked);
+        if (instance->to_string(REPR) != bank_formula2->to_string(REPR)) {
+            std::cout << "Banked substitution test failed\n";
+            all_passed = false;
+        }
+        delete instance;
+
+        // Comparing with the substitution applied lazily agrees with building the instance
+        if (!equal_banked(bank_formula2, {bank_formula1, 0, &banked}) ||
+            !equal_banked(bank_formula2, {bank_formula2, 1, &banked}) ||
+            equal_banked(bank_formula1, {bank_formula1, 0, &banked})) {
+            std::cout << "Lazy banked substitution test failed\n";
+            all_passed = false;
+        }
+    }
+    delete bank_formula1;
+    delete bank_formula2;
+
+    // Compiled patterns agree with unification, or defer to it
+    struct ProgramCase {
+        std::string pattern;
+        std::string term;
+        trial_result expected;
+    };
+
+    std::vector<ProgramCase> program_cases = {
+        {"x \\in A", "f(a) \\in B", trial_result::Success},
+        {"x \\subseteq y", "x \\in y", trial_result::Fail},
+        {"P(x, x)", "P(f(y), f(y))", trial_result::Success},
+        {"P(x, \\emptyset)", "P(y, z)", trial_result::Unknown}
+    };
+
+    for (const auto& test : program_cases) {
+        node* pattern = parse_formula(test.pattern);
+        node* term = parse_formula(test.term);
+        // Only variables of the pattern are variables for the compiled code
+        if (test.expected != trial_result::Unknown) {
+            parameterize_vars(term);
+        }
+        if (run_program(compile_pattern(pattern), term) != test.expected) {
+            std::cout << "Compiled pattern test failed for: " << test.pattern << " and " << test.term << "\n";
+            all_passed = false;
+        }
+        delete pattern;
+        delete term;
+    }
+
+    // Hyperresolution finds units for all conjuncts of an implication at once
+    struct HyperCase {
+        std::string implication;
+        std::vector<std::string> units;
+        bool parameterize_units;
+        std::string conclusion;
+    };
+
+    std::vector<HyperCase> hyper_cases = {
+        // Transitivity fires on two units sharing a parameter
+        {"P(x, y) \\wedge P(y, z) \\implies P(x, z)", {"P(a, b)", "P(b, c)"}, true, "P(a, c)"},
+        // Variables of different units are distinct even if they have the same name
+        {"P(\\emptyset) \\wedge Q(\\emptyset \\cap \\emptyset) \\implies R(\\emptyset)", {"P(u)", "Q(u)"}, false, "R(∅)"}
+    };
+
+    for (const auto& test : hyper_cases) {
+        context_t hyper_ctx;
+        std::unordered_map<std::string, std::vector<size_t>> unit_index;
+        for (const auto& unit : test.units) {
+            node* formula = parse_formula(unit);
+            if (test.parameterize_units) {
+                parameterize_vars(formula);
+            }
+            tabline_t tabline(formula);
+            tabline.active = true;
+            tabline.justification = { Reason::Hypothesis, {} };
+            unit_index[predicate_key(formula)].push_back(hyper_ctx.tableau.size());
+            hyper_ctx.tableau.push_back(tabline);
+        }
+        tabline_t impl_tabline(parse_formula(test.implication));
+        impl_tabline.active = true;
+        impl_tabline.justification = { Reason::Hypothesis, {} };
+        hyper_ctx.tableau.push_back(impl_tabline);
+        int impl_idx = hyper_ctx.tableau.size() - 1;
+
+        std::vector<int> tuple;
+        if (!find_hyper_units(tuple, hyper_ctx, hyper_ctx.tableau[impl_idx], unit_index, {}) ||
+            tuple != std::vector<int>{0, 1}) {
+            std::cout << "Hyperresolution test failed for: " << test.implication << "\n";
+            all_passed = false;
+        } else if (!move_mpt(hyper_ctx, impl_idx, tuple, {}, true, true) ||
+                   hyper_ctx.tableau.back().formula->to_string(UNICODE) != test.conclusion) {
+            std::cout << "Hyperresolution move failed for: " << test.implication << "\n";
+            all_passed = false;
+        }
+
+        for (auto& tabline : hyper_ctx.tableau) {
+            delete tabline.formula;
+        }
+    }
+
+    // Structure constraints of a unit line apply to what its variables are bound to
+    struct SpecialCase {
+        std::string implication;
+        std::string unit;
+        bool expected;
+        std::string conclusion;
+    };
+
+    std::vector<SpecialCase> special_cases = {
+        {"P(x) \\implies Q(x)", "G:Group \\implies P(G)", true, "[G':Group] Q(G')"},
+        // The unit's G is bound to f(y), which no line says is a group
+        {"P(f(y)) \\implies Q(y)", "G:Group \\implies P(G)", false, ""},
+        // The unit's x is not the implication's x
+        {"P(x, f(y)) \\implies Q(x)", "x:Group \\implies P(c, x)", false, ""}
+    };
+
+    for (const auto& test : special_cases) {
+        context_t special_ctx;
+        for (const auto& formula : {test.implication, test.unit, std::string("H:Group")}) {
+            tabline_t tabline(parse_formula(formula));
+            tabline.active = true;
+            tabline.justification = { Reason::Hypothesis, {} };
+            special_ctx.tableau.push_back(tabline);
+        }
+        parameterize_vars(special_ctx.tableau[2].formula);
+
+        bool moved = move_mpt(special_ctx, 0, {1}, {2}, true, true);
+        if (moved != test.expected ||
+            (moved && special_ctx.tableau.back().formula->to_string(UNICODE) != test.conclusion)) {
+            std::cout << "Structure constraint test failed for: " << test.implication << " and " << test.unit << "\n";
+            all_passed = false;
+        }
+
+        for (auto& tabline : special_ctx.tableau) {
+            delete tabline.formula;
+            delete tabline.negation;
+        }
+    }
+
     if (all_passed) {
         std::cout << "All tests passed!\n";
     }